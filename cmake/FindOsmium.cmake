@@ -25,6 +25,9 @@
 #    following components:
 #
 #      pbf        - include libraries needed for PBF input and output
+#                   (libdeflate is used for faster PBF blob compression
+#                   and lz4 and zstd compressed blobs are supported if
+#                   those libraries are found)
 #      xml        - include libraries needed for XML input and output
 #      io         - include libraries needed for any type of input/output
 #      geos       - include if you want to use any of the GEOS functions
@@ -110,6 +113,35 @@ if(Osmium_USE_PBF)
     else()
         message(WARNING "Osmium: Can not find some libraries for PBF input/output, please install them or configure the paths.")
     endif()
+
+    # Use libdeflate for PBF blob (de)compression if it is available.
+    find_path(LIBDEFLATE_INCLUDE_DIR libdeflate.h)
+    find_library(LIBDEFLATE_LIBRARY NAMES deflate libdeflate)
+    if(LIBDEFLATE_INCLUDE_DIR AND LIBDEFLATE_LIBRARY)
+        set(LIBDEFLATE_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_LIBDEFLATE=${LIBDEFLATE_FOUND})
+        list(APPEND OSMIUM_PBF_LIBRARIES ${LIBDEFLATE_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${LIBDEFLATE_INCLUDE_DIR})
+    endif()
+
+    # Support lz4 and zstd compressed PBF blobs if the libraries are available.
+    find_path(LZ4_INCLUDE_DIR lz4hc.h)
+    find_library(LZ4_LIBRARY NAMES lz4 liblz4)
+    if(LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+        set(LZ4_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_LZ4=${LZ4_FOUND})
+        list(APPEND OSMIUM_PBF_LIBRARIES ${LZ4_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${LZ4_INCLUDE_DIR})
+    endif()
+
+    find_path(ZSTD_INCLUDE_DIR zstd.h)
+    find_library(ZSTD_LIBRARY NAMES zstd libzstd)
+    if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+        set(ZSTD_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_ZSTD=${ZSTD_FOUND})
+        list(APPEND OSMIUM_PBF_LIBRARIES ${ZSTD_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+    endif()
 endif()
 
 #----------------------------------------------------------------------
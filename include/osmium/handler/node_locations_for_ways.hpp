@@ -33,12 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <cstddef>
+#include <future>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 #include <osmium/handler.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -87,6 +93,21 @@ namespace osmium {
 
             bool m_must_sort {false};
 
+            // Buffers for the IDs and locations of the nodes of a way
+            // used for the batch lookups.
+            struct lookup_buffers {
+                std::vector<osmium::unsigned_object_id_type> pos_ids;
+                std::vector<osmium::unsigned_object_id_type> neg_ids;
+                std::vector<osmium::Location> pos_locations;
+                std::vector<osmium::Location> neg_locations;
+            }; // struct lookup_buffers
+
+            lookup_buffers m_lookup_buffers;
+
+            // Minimum number of ways in a task submitted to the pool by
+            // apply_parallel().
+            static constexpr const std::size_t min_ways_per_task = 256;
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -142,33 +163,163 @@ namespace osmium {
                 }
             }
 
-            /**
-             * Retrieve locations of all nodes in the way from storage and add
-             * them to the way object.
-             */
-            void way(osmium::Way& way) {
+        private:
+
+            using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+            void sort_if_needed() {
                 if (m_must_sort) {
                     m_storage_pos.sort();
                     m_storage_neg.sort();
                     m_must_sort = false;
                     m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
                 }
-                bool error = false;
+            }
+
+            // Call through the base class, derived classes which only
+            // implement sort() hide the sort(Pool&) overload.
+            template <typename TPool>
+            void sort_if_needed(TPool& pool) {
+                if (m_must_sort) {
+                    static_cast<map_type&>(m_storage_pos).sort(pool);
+                    static_cast<map_type&>(m_storage_neg).sort(pool);
+                    m_must_sort = false;
+                    m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
+                }
+            }
+
+            /**
+             * Look up the locations of all nodes in the way with one call
+             * to get_many() for each of the indexes and add them to the
+             * way. Only reads from the indexes, so it can be called from
+             * several threads at the same time with different buffers.
+             *
+             * @returns false if any location was not found.
+             */
+            bool add_locations(osmium::Way& way, lookup_buffers& buffers) const {
+                buffers.pos_ids.clear();
+                buffers.neg_ids.clear();
+                for (const auto& node_ref : way.nodes()) {
+                    if (node_ref.ref() >= 0) {
+                        buffers.pos_ids.push_back(static_cast<osmium::unsigned_object_id_type>( node_ref.ref()));
+                    } else {
+                        buffers.neg_ids.push_back(static_cast<osmium::unsigned_object_id_type>(-node_ref.ref()));
+                    }
+                }
+
+                buffers.pos_locations.resize(buffers.pos_ids.size());
+                buffers.neg_locations.resize(buffers.neg_ids.size());
+                m_storage_pos.get_many(buffers.pos_ids.data(), buffers.pos_locations.data(), buffers.pos_ids.size());
+                if (!buffers.neg_ids.empty()) {
+                    m_storage_neg.get_many(buffers.neg_ids.data(), buffers.neg_locations.data(), buffers.neg_ids.size());
+                }
+
+                bool found = true;
+                auto pos_it = buffers.pos_locations.cbegin();
+                auto neg_it = buffers.neg_locations.cbegin();
                 for (auto& node_ref : way.nodes()) {
-                    try {
-                        node_ref.set_location(get_node_location(node_ref.ref()));
-                        if (!node_ref.location()) {
-                            error = true;
-                        }
-                    } catch (osmium::not_found&) {
-                        error = true;
+                    node_ref.set_location(node_ref.ref() >= 0 ? *pos_it++ : *neg_it++);
+                    if (!node_ref.location()) {
+                        found = false;
                     }
                 }
-                if (error && !m_ignore_errors) {
+                return found;
+            }
+
+            void check_error(bool found) const {
+                if (!found && !m_ignore_errors) {
                     throw osmium::not_found("location for one or more nodes not found in node location index");
                 }
             }
 
+        public:
+
+            /**
+             * Retrieve locations of all nodes in the way from storage and add
+             * them to the way object.
+             */
+            void way(osmium::Way& way) {
+                sort_if_needed();
+                check_error(add_locations(way, m_lookup_buffers));
+            }
+
+            /**
+             * Handle all objects in the buffer: Store the locations of all
+             * nodes and then add the locations to all ways, the ways are
+             * split up into groups that are handled in parallel by the
+             * workers of the pool. This only works because the indexes are
+             * not changed while ways are handled. If the indexes have to be
+             * sorted, they are sorted using the pool. Call this instead of
+             * osmium::apply(buffer, handler) before handing the buffer on
+             * to other handlers.
+             *
+             * If called from a worker of the pool, or if the pool only has
+             * one thread, the ways are handled in the current thread.
+             *
+             * @tparam TPool Thread pool class (usually osmium::thread::Pool).
+             *               The handler doesn't depend on the pool header,
+             *               include osmium/thread/pool.hpp yourself.
+             * @param buffer The buffer with nodes and/or ways.
+             * @param pool The thread pool to use.
+             * @throws osmium::not_found if a location was not found and
+             *         ignore_errors() was not called. All ways are handled
+             *         before the exception is thrown.
+             */
+            template <typename TPool>
+            void apply_parallel(osmium::memory::Buffer& buffer, TPool& pool) {
+                std::vector<osmium::Way*> ways;
+                for (auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() == osmium::item_type::node) {
+                        node(static_cast<const osmium::Node&>(object));
+                    } else if (object.type() == osmium::item_type::way) {
+                        ways.push_back(&static_cast<osmium::Way&>(object));
+                    }
+                }
+
+                if (ways.empty()) {
+                    return;
+                }
+
+                sort_if_needed(pool);
+
+                if (pool.num_threads() < 2 || ways.size() < 2 * min_ways_per_task || pool.is_worker_thread()) {
+                    bool found = true;
+                    for (auto* way : ways) {
+                        found = add_locations(*way, m_lookup_buffers) && found;
+                    }
+                    check_error(found);
+                    return;
+                }
+
+                const std::size_t num_tasks = std::min(static_cast<std::size_t>(pool.num_threads()) * 4, ways.size() / min_ways_per_task);
+                const std::size_t ways_per_task = (ways.size() + num_tasks - 1) / num_tasks;
+
+                std::vector<std::future<bool>> futures;
+                for (std::size_t start = 0; start < ways.size(); start += ways_per_task) {
+                    auto first = ways.cbegin() + start;
+                    auto last = ways.cbegin() + std::min(start + ways_per_task, ways.size());
+                    futures.push_back(pool.submit([this, first, last] {
+                        lookup_buffers buffers;
+                        bool found = true;
+                        for (auto it = first; it != last; ++it) {
+                            found = add_locations(**it, buffers) && found;
+                        }
+                        return found;
+                    }));
+                }
+
+                // wait for all tasks before looking at the results, the
+                // ways must not be touched after this function returns
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                bool found = true;
+                for (auto& future : futures) {
+                    found = future.get() && found;
+                }
+                check_error(found);
+            }
+
             /**
              * Call clear on the location indexes. Makes the
              * NodeLocationsForWays handler unusable. Used to explicitly free
@@ -41,6 +41,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+#include <osmium/util/compatibility.hpp>
 
 namespace osmium {
 
@@ -51,6 +54,9 @@ namespace osmium {
             template <typename TVector, typename TId, typename TValue>
             class VectorBasedDenseMap : public Map<TId, TValue> {
 
+                // How many ids ahead get_many() prefetches the values.
+                static constexpr const size_t prefetch_distance = 16;
+
                 TVector m_vector;
 
             public:
@@ -93,6 +99,29 @@ namespace osmium {
                     }
                 }
 
+                size_t get_many(const TId* ids, TValue* values, const size_t n) const final {
+                    const TValue* data = m_vector.data();
+                    const size_t vector_size = m_vector.size();
+
+                    for (size_t i = 0; i < n && i < prefetch_distance; ++i) {
+                        if (ids[i] < vector_size) {
+                            OSMIUM_PREFETCH(data + ids[i]);
+                        }
+                    }
+
+                    size_t not_found_count = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        if (i + prefetch_distance < n && ids[i + prefetch_distance] < vector_size) {
+                            OSMIUM_PREFETCH(data + ids[i + prefetch_distance]);
+                        }
+                        values[i] = ids[i] < vector_size ? data[ids[i]] : osmium::index::empty_value<TValue>();
+                        if (values[i] == osmium::index::empty_value<TValue>()) {
+                            ++not_found_count;
+                        }
+                    }
+                    return not_found_count;
+                }
+
                 size_t size() const final {
                     return m_vector.size();
                 }
@@ -144,6 +173,9 @@ namespace osmium {
             template <typename TId, typename TValue, template<typename...> class TVector>
             class VectorBasedSparseMap : public Map<TId, TValue> {
 
+                // Number of ids get_many() looks up at the same time.
+                static constexpr const size_t group_size = 8;
+
             public:
 
                 using element_type   = typename std::pair<TId, TValue>;
@@ -186,6 +218,54 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Looks up a group of ids at a time. The binary searches for
+                 * all ids in a group run in lockstep, the elements needed in
+                 * the next step are prefetched for all of them before any of
+                 * them is compared. This way the cache misses of different
+                 * searches overlap.
+                 */
+                size_t get_many(const TId* ids, TValue* values, const size_t n) const final {
+                    const element_type* const first = m_vector.data();
+                    const element_type* const last = first + m_vector.size();
+
+                    size_t not_found_count = 0;
+                    const element_type* base[group_size];
+                    for (size_t start = 0; start < n; start += group_size) {
+                        const size_t count = std::min(group_size, n - start);
+                        const TId* group_ids = ids + start;
+
+                        std::fill_n(base, count, first);
+                        size_t len = m_vector.size();
+                        while (len > 1) {
+                            const size_t half = len / 2;
+                            for (size_t k = 0; k < count; ++k) {
+                                OSMIUM_PREFETCH(base[k] + half);
+                            }
+                            for (size_t k = 0; k < count; ++k) {
+                                if (base[k][half].first < group_ids[k]) {
+                                    base[k] += half;
+                                }
+                            }
+                            len -= half;
+                        }
+
+                        for (size_t k = 0; k < count; ++k) {
+                            const element_type* result = base[k];
+                            if (result != last && result->first < group_ids[k]) {
+                                ++result;
+                            }
+                            if (result != last && result->first == group_ids[k]) {
+                                values[start + k] = result->second;
+                            } else {
+                                values[start + k] = osmium::index::empty_value<TValue>();
+                                ++not_found_count;
+                            }
+                        }
+                    }
+                    return not_found_count;
+                }
+
                 size_t size() const final {
                     return m_vector.size();
                 }
@@ -207,6 +287,15 @@ namespace osmium {
                     std::sort(m_vector.begin(), m_vector.end());
                 }
 
+                /**
+                 * Sort the entries using the threads of the pool. This only
+                 * helps for large indexes, small ones are sorted in the
+                 * current thread.
+                 */
+                void sort(osmium::thread::Pool& pool) final {
+                    osmium::thread::parallel_sort(m_vector.begin(), m_vector.end(), pool);
+                }
+
                 void dump_as_list(const int fd) final {
                     osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_vector.data()), byte_size());
                 }
@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
 
 namespace osmium {
 
@@ -126,6 +128,15 @@ namespace osmium {
                     std::sort(m_vector.begin(), m_vector.end());
                 }
 
+                /**
+                 * Sort the entries using the threads of the pool. This only
+                 * helps for large indexes, small ones are sorted in the
+                 * current thread.
+                 */
+                void sort(osmium::thread::Pool& pool) final {
+                    osmium::thread::parallel_sort(m_vector.begin(), m_vector.end(), pool);
+                }
+
                 void remove(const TId id, const TValue value) {
                     auto r = get_all(id);
                     for (auto it = r.first; it != r.second; ++it) {
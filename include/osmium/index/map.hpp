@@ -43,11 +43,18 @@ DEALINGS IN THE SOFTWARE.
 #include <type_traits>
 #include <vector>
 
+#include <osmium/index/index.hpp>
 #include <osmium/util/compatibility.hpp>
 #include <osmium/util/string.hpp>
 
 namespace osmium {
 
+    namespace thread {
+
+        class Pool;
+
+    } // namespace thread
+
     namespace index {
 
         /**
@@ -117,6 +124,30 @@ namespace osmium {
                 /// Retrieve value by id. Does not check for overflow or empty fields.
                 virtual const TValue get(const TId id) const = 0;
 
+                /**
+                 * Retrieve the values for n ids at once. Values that are not
+                 * found are set to the empty value, no exception is thrown.
+                 * Implementations can use this to overlap the memory
+                 * accesses for the different ids.
+                 *
+                 * @param ids Pointer to n ids.
+                 * @param values Pointer to space for n values.
+                 * @param n Number of ids.
+                 * @returns Number of values not found.
+                 */
+                virtual size_t get_many(const TId* ids, TValue* values, const size_t n) const {
+                    size_t not_found_count = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        try {
+                            values[i] = get(ids[i]);
+                        } catch (const osmium::not_found&) {
+                            values[i] = osmium::index::empty_value<TValue>();
+                            ++not_found_count;
+                        }
+                    }
+                    return not_found_count;
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
@@ -148,6 +179,15 @@ namespace osmium {
                     // default implementation is empty
                 }
 
+                /**
+                 * Sort data in map using the threads of the pool. The
+                 * default implementation calls sort(). Implementations
+                 * which benefit from sorting in parallel override this.
+                 */
+                virtual void sort(osmium::thread::Pool& /*pool*/) {
+                    sort();
+                }
+
                 // This function could usually be const in derived classes,
                 // but not always. It could, for instance, sort internal data.
                 // This is why it is not declared const here.
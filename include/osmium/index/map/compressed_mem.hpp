@@ -0,0 +1,320 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_MEM_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_MEM_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <protozero/varint.hpp>
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * The CompressedMem index stores locations sorted by ID in
+             * blocks of up to block_entries entries. Inside a block the
+             * IDs and the coordinates are delta encoded from one entry to
+             * the next and written as varints. A small index with the
+             * first ID and the offset of each block is used to find the
+             * block an ID is in, the block is then decoded up to the ID.
+             *
+             * This needs a lot less memory than the SparseMemArray (16
+             * bytes per entry) or, for sparse data, the DenseMemArray (8
+             * bytes per possible ID), but lookups are slower.
+             *
+             * Data is encoded as it comes in if the IDs are set in
+             * ascending order which is the case for sorted OSM files.
+             * Otherwise entries are collected and encoded when sort() is
+             * called. Call sort() before reading.
+             */
+            template <typename TId, typename TValue>
+            class CompressedMem : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value, "CompressedMem only works with osmium::Location values");
+
+                using element_type = std::pair<TId, TValue>;
+
+                // Maximum number of entries in a block.
+                static constexpr const std::size_t block_entries = 64;
+
+                // Maximum number of bytes needed for a block: one varint
+                // for the ID delta and two for the coordinate deltas per
+                // entry.
+                static constexpr const std::size_t max_block_size = block_entries * 3 * protozero::max_varint_length;
+
+                // Encoded data is stored in chunks of this size, they are
+                // never reallocated.
+                static constexpr const std::size_t chunk_size = 1024 * 1024;
+
+                struct block_info {
+                    TId first_id;
+                    std::size_t offset;
+                }; // struct block_info
+
+                std::vector<std::vector<char>> m_chunks;
+
+                std::vector<block_info> m_blocks;
+
+                // Entries not encoded yet, at most block_entries of them
+                // in ascending ID order.
+                std::vector<element_type> m_pending;
+
+                // Entries that were set out of order.
+                std::vector<element_type> m_unsorted;
+
+                std::size_t m_size = 0;
+
+                // The last ID set in ascending order.
+                TId m_last_id = 0;
+
+                void encode_block(typename std::vector<element_type>::const_iterator begin,
+                                  typename std::vector<element_type>::const_iterator end) {
+                    if (m_chunks.empty() || chunk_size - m_chunks.back().size() < max_block_size) {
+                        m_chunks.emplace_back();
+                        m_chunks.back().reserve(chunk_size);
+                    }
+                    auto& chunk = m_chunks.back();
+
+                    m_blocks.push_back(block_info{begin->first, (m_chunks.size() - 1) * chunk_size + chunk.size()});
+
+                    TId last_id = begin->first;
+                    int64_t last_x = 0;
+                    int64_t last_y = 0;
+                    for (auto it = begin; it != end; ++it) {
+                        protozero::write_varint(std::back_inserter(chunk), it->first - last_id);
+                        protozero::write_varint(std::back_inserter(chunk), protozero::encode_zigzag64(it->second.x() - last_x));
+                        protozero::write_varint(std::back_inserter(chunk), protozero::encode_zigzag64(it->second.y() - last_y));
+                        last_id = it->first;
+                        last_x = it->second.x();
+                        last_y = it->second.y();
+                    }
+                }
+
+                void flush_pending() {
+                    if (!m_pending.empty()) {
+                        encode_block(m_pending.cbegin(), m_pending.cend());
+                        m_pending.clear();
+                    }
+                }
+
+                /**
+                 * Call func(id, location) for all encoded entries in the
+                 * block with the given index until it returns true.
+                 */
+                template <typename TFunc>
+                void decode_block(std::size_t block, TFunc&& func) const {
+                    const std::size_t offset = m_blocks[block].offset;
+                    const auto& chunk = m_chunks[offset / chunk_size];
+                    const char* data = chunk.data() + offset % chunk_size;
+
+                    // A block ends where the next block in the same chunk
+                    // starts or at the end of the chunk.
+                    const char* end = chunk.data() + chunk.size();
+                    if (block + 1 < m_blocks.size() && m_blocks[block + 1].offset / chunk_size == offset / chunk_size) {
+                        end = chunk.data() + m_blocks[block + 1].offset % chunk_size;
+                    }
+
+                    TId id = m_blocks[block].first_id;
+                    int64_t x = 0;
+                    int64_t y = 0;
+                    while (data != end) {
+                        id += static_cast<TId>(protozero::decode_varint(&data, end));
+                        x += protozero::decode_zigzag64(protozero::decode_varint(&data, end));
+                        y += protozero::decode_zigzag64(protozero::decode_varint(&data, end));
+                        if (func(id, TValue{static_cast<int32_t>(x), static_cast<int32_t>(y)})) {
+                            return;
+                        }
+                    }
+                }
+
+                std::vector<element_type> decode_all() const {
+                    std::vector<element_type> elements;
+                    elements.reserve(m_size);
+                    for (std::size_t block = 0; block < m_blocks.size(); ++block) {
+                        decode_block(block, [&elements](TId id, TValue value) {
+                            elements.emplace_back(id, value);
+                            return false;
+                        });
+                    }
+                    return elements;
+                }
+
+                void clear_encoded() {
+                    m_chunks.clear();
+                    m_chunks.shrink_to_fit();
+                    m_blocks.clear();
+                    m_blocks.shrink_to_fit();
+                }
+
+            public:
+
+                CompressedMem() = default;
+
+                ~CompressedMem() noexcept final = default;
+
+                void set(const TId id, const TValue value) final {
+                    if (!m_unsorted.empty() || (m_size > 0 && id <= m_last_id)) {
+                        m_unsorted.emplace_back(id, value);
+                        ++m_size;
+                        return;
+                    }
+
+                    ++m_size;
+                    m_last_id = id;
+                    m_pending.emplace_back(id, value);
+                    if (m_pending.size() == block_entries) {
+                        flush_pending();
+                    }
+                }
+
+                const TValue get(const TId id) const final {
+                    const auto it = std::upper_bound(m_blocks.cbegin(), m_blocks.cend(), id, [](TId value, const block_info& info) {
+                        return value < info.first_id;
+                    });
+
+                    if (it != m_blocks.cbegin()) {
+                        TValue result{};
+                        bool found = false;
+                        decode_block(std::distance(m_blocks.cbegin(), it) - 1, [&](TId entry_id, TValue value) {
+                            if (entry_id >= id) {
+                                if (entry_id == id) {
+                                    result = value;
+                                    found = true;
+                                }
+                                return true;
+                            }
+                            return false;
+                        });
+                        if (found) {
+                            return result;
+                        }
+                    }
+
+                    for (const auto& element : m_pending) {
+                        if (element.first == id) {
+                            return element.second;
+                        }
+                    }
+
+                    not_found_error(id);
+                }
+
+                size_t size() const final {
+                    return m_size;
+                }
+
+                size_t used_memory() const final {
+                    return m_chunks.size() * chunk_size +
+                           m_blocks.size() * sizeof(block_info) +
+                           (m_pending.capacity() + m_unsorted.size()) * sizeof(element_type);
+                }
+
+                void clear() final {
+                    clear_encoded();
+                    m_pending.clear();
+                    m_pending.shrink_to_fit();
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                    m_size = 0;
+                    m_last_id = 0;
+                }
+
+                void sort() final {
+                    if (m_unsorted.empty()) {
+                        flush_pending();
+                        return;
+                    }
+
+                    std::vector<element_type> elements = decode_all();
+                    clear_encoded();
+                    elements.insert(elements.end(), m_pending.cbegin(), m_pending.cend());
+                    m_pending.clear();
+                    elements.insert(elements.end(), m_unsorted.cbegin(), m_unsorted.cend());
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+
+                    std::stable_sort(elements.begin(), elements.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+
+                    // If an ID was set more than once, the last value wins.
+                    auto out = elements.begin();
+                    for (auto it = elements.begin(); it != elements.end(); ++it) {
+                        if (out != elements.begin() && std::prev(out)->first == it->first) {
+                            *std::prev(out) = *it;
+                        } else {
+                            *out++ = *it;
+                        }
+                    }
+                    elements.erase(out, elements.end());
+                    m_size = elements.size();
+                    m_last_id = elements.back().first;
+
+                    for (auto it = elements.cbegin(); it != elements.cend();) {
+                        const auto block_end = elements.cend() - it > static_cast<std::ptrdiff_t>(block_entries) ? it + block_entries : elements.cend();
+                        encode_block(it, block_end);
+                        it = block_end;
+                    }
+                }
+
+                void dump_as_list(const int fd) final {
+                    sort();
+                    const std::vector<element_type> elements = decode_all();
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(elements.data()), sizeof(element_type) * elements.size());
+                }
+
+            }; // class CompressedMem
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_MEM_HPP
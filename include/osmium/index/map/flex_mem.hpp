@@ -0,0 +1,295 @@
+#ifndef OSMIUM_INDEX_MAP_FLEX_MEM_HPP
+#define OSMIUM_INDEX_MAP_FLEX_MEM_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+#include <osmium/util/compatibility.hpp>
+
+#define OSMIUM_HAS_INDEX_MAP_FLEX_MEM
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * The FlexMem index starts out storing (id, value) pairs in a
+             * vector like the SparseMemArray. While values are added it
+             * watches how densely the IDs are populated. Once storing the
+             * values in an array indexed by ID needs less memory than the
+             * list of pairs, it switches to such a dense layout.
+             *
+             * The dense array is allocated in blocks, blocks that no ID
+             * falls into are never allocated.
+             *
+             * Use this index if you don't know beforehand whether you will
+             * work with a small extract or with the whole planet.
+             */
+            template <typename TId, typename TValue>
+            class FlexMem : public osmium::index::map::Map<TId, TValue> {
+
+                using element_type = std::pair<TId, TValue>;
+
+                // The dense array is allocated in blocks of 2^block_bits
+                // values.
+                static constexpr const std::size_t block_bits = 16;
+                static constexpr const std::size_t block_size = 1ull << block_bits;
+
+                // Never switch to the dense layout before there are at
+                // least this many entries.
+                static constexpr const std::size_t default_min_dense_entries = 1ull << 20;
+
+                std::vector<element_type> m_sparse_entries;
+
+                std::vector<std::vector<TValue>> m_dense_blocks;
+
+                std::size_t m_min_dense_entries;
+
+                TId m_max_id = 0;
+
+                // Layout we started out with, clear() goes back to it.
+                bool m_initial_dense;
+
+                bool m_dense;
+
+                std::size_t allocated_blocks() const noexcept {
+                    return std::count_if(m_dense_blocks.cbegin(), m_dense_blocks.cend(), [](const std::vector<TValue>& block) {
+                        return !block.empty();
+                    });
+                }
+
+                bool dense_is_cheaper() const noexcept {
+                    // Upper bound for the memory needed by the dense array,
+                    // it might be less if there are large gaps in the IDs.
+                    return m_sparse_entries.size() >= m_min_dense_entries &&
+                           static_cast<double>(m_max_id) * sizeof(TValue) < static_cast<double>(m_sparse_entries.size()) * sizeof(element_type);
+                }
+
+                void set_dense(const TId id, const TValue value) {
+                    const std::size_t block = id >> block_bits;
+                    if (block >= m_dense_blocks.size()) {
+                        m_dense_blocks.resize(block + 1);
+                    }
+                    if (m_dense_blocks[block].empty()) {
+                        m_dense_blocks[block].assign(block_size, osmium::index::empty_value<TValue>());
+                    }
+                    m_dense_blocks[block][id & (block_size - 1)] = value;
+                }
+
+                const TValue get_dense(const TId id) const {
+                    const std::size_t block = id >> block_bits;
+                    if (block >= m_dense_blocks.size() || m_dense_blocks[block].empty()) {
+                        not_found_error(id);
+                    }
+                    const TValue value = m_dense_blocks[block][id & (block_size - 1)];
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        not_found_error(id);
+                    }
+                    return value;
+                }
+
+                const TValue get_sparse(const TId id) const {
+                    const auto it = std::lower_bound(m_sparse_entries.cbegin(), m_sparse_entries.cend(), id, [](const element_type& element, TId value) {
+                        return element.first < value;
+                    });
+                    if (it == m_sparse_entries.cend() || it->first != id) {
+                        not_found_error(id);
+                    }
+                    return it->second;
+                }
+
+                void switch_to_dense() {
+                    for (const auto& element : m_sparse_entries) {
+                        set_dense(element.first, element.second);
+                    }
+                    m_sparse_entries.clear();
+                    m_sparse_entries.shrink_to_fit();
+                    m_dense = true;
+                }
+
+            public:
+
+                /**
+                 * Constructor.
+                 *
+                 * @param dense Start out with the dense layout.
+                 * @param min_dense_entries Never switch to the dense layout
+                 *                          before there are at least this
+                 *                          many entries.
+                 */
+                explicit FlexMem(bool dense = false, std::size_t min_dense_entries = default_min_dense_entries) :
+                    m_sparse_entries(),
+                    m_dense_blocks(),
+                    m_min_dense_entries(min_dense_entries),
+                    m_initial_dense(dense),
+                    m_dense(dense) {
+                }
+
+                ~FlexMem() noexcept final = default;
+
+                /// Is the dense layout used?
+                bool is_dense() const noexcept {
+                    return m_dense;
+                }
+
+                void set(const TId id, const TValue value) final {
+                    if (m_dense) {
+                        set_dense(id, value);
+                        return;
+                    }
+
+                    m_sparse_entries.emplace_back(id, value);
+                    if (id > m_max_id) {
+                        m_max_id = id;
+                    }
+                    if (dense_is_cheaper()) {
+                        switch_to_dense();
+                    }
+                }
+
+                const TValue get(const TId id) const final {
+                    return m_dense ? get_dense(id) : get_sparse(id);
+                }
+
+                size_t get_many(const TId* ids, TValue* values, const size_t n) const final {
+                    if (!m_dense) {
+                        return Map<TId, TValue>::get_many(ids, values, n);
+                    }
+
+                    // prefetch the values one way node ahead
+                    size_t not_found_count = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        if (i + 1 < n) {
+                            const std::size_t block = ids[i + 1] >> block_bits;
+                            if (block < m_dense_blocks.size() && !m_dense_blocks[block].empty()) {
+                                OSMIUM_PREFETCH(m_dense_blocks[block].data() + (ids[i + 1] & (block_size - 1)));
+                            }
+                        }
+                        const std::size_t block = ids[i] >> block_bits;
+                        if (block < m_dense_blocks.size() && !m_dense_blocks[block].empty()) {
+                            values[i] = m_dense_blocks[block][ids[i] & (block_size - 1)];
+                        } else {
+                            values[i] = osmium::index::empty_value<TValue>();
+                        }
+                        if (values[i] == osmium::index::empty_value<TValue>()) {
+                            ++not_found_count;
+                        }
+                    }
+                    return not_found_count;
+                }
+
+                size_t size() const final {
+                    return m_dense ? allocated_blocks() * block_size : m_sparse_entries.size();
+                }
+
+                size_t used_memory() const final {
+                    if (m_dense) {
+                        return allocated_blocks() * block_size * sizeof(TValue) +
+                               m_dense_blocks.size() * sizeof(std::vector<TValue>);
+                    }
+                    return m_sparse_entries.size() * sizeof(element_type);
+                }
+
+                void clear() final {
+                    m_sparse_entries.clear();
+                    m_sparse_entries.shrink_to_fit();
+                    m_dense_blocks.clear();
+                    m_dense_blocks.shrink_to_fit();
+                    m_max_id = 0;
+                    m_dense = m_initial_dense;
+                }
+
+                void sort() final {
+                    if (!m_dense) {
+                        std::sort(m_sparse_entries.begin(), m_sparse_entries.end(), [](const element_type& a, const element_type& b) {
+                            return a.first < b.first;
+                        });
+                    }
+                }
+
+                /**
+                 * Sort the sparse entries using the threads of the pool.
+                 * This only helps for large indexes, small ones are sorted
+                 * in the current thread.
+                 */
+                void sort(osmium::thread::Pool& pool) final {
+                    if (!m_dense) {
+                        osmium::thread::parallel_sort(m_sparse_entries.begin(), m_sparse_entries.end(), [](const element_type& a, const element_type& b) {
+                            return a.first < b.first;
+                        }, pool);
+                    }
+                }
+
+                void dump_as_list(const int fd) final {
+                    if (m_dense) {
+                        std::vector<element_type> v;
+                        TId id = 0;
+                        for (const auto& block : m_dense_blocks) {
+                            if (block.empty()) {
+                                id += block_size;
+                                continue;
+                            }
+                            for (const TValue value : block) {
+                                if (value != osmium::index::empty_value<TValue>()) {
+                                    v.emplace_back(id, value);
+                                }
+                                ++id;
+                            }
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(element_type) * v.size());
+                    } else {
+                        sort();
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_sparse_entries.data()), sizeof(element_type) * m_sparse_entries.size());
+                    }
+                }
+
+            }; // class FlexMem
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_FLEX_MEM_HPP
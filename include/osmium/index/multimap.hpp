@@ -40,6 +40,12 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace thread {
+
+        class Pool;
+
+    } // namespace thread
+
     namespace index {
 
         /**
@@ -112,6 +118,15 @@ namespace osmium {
                     // default implementation is empty
                 }
 
+                /**
+                 * Sort data in map using the threads of the pool. The
+                 * default implementation calls sort(). Implementations
+                 * which benefit from sorting in parallel override this.
+                 */
+                virtual void sort(osmium::thread::Pool& /*pool*/) {
+                    sort();
+                }
+
                 virtual void dump_as_list(const int /*fd*/) {
                     std::runtime_error("can't dump as list");
                 }
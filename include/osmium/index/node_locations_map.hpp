@@ -35,6 +35,10 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/map.hpp> // IWYU pragma: keep
 
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedMem, compressed_mem)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
 #endif
@@ -47,6 +51,10 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseMmapArray, dense_mmap_array)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_FLEX_MEM
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::FlexMem, flex_mem)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseFileArray, sparse_file_array)
 #endif
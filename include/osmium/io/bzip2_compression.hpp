@@ -42,11 +42,18 @@ DEALINGS IN THE SOFTWARE.
  * @attention If you include this file, you'll need to link with `libbz2`.
  */
 
+#include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <system_error>
+#include <utility>
 
 #include <bzlib.h>
 
@@ -58,8 +65,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/cast.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/config.hpp>
 
 namespace osmium {
 
@@ -297,13 +306,420 @@ namespace osmium {
 
         }; // class Bzip2BufferDecompressor
 
+        namespace detail {
+
+            /// The 48 bit magic number at the start of each bzip2 block.
+            constexpr const uint64_t bzip2_block_magic = 0x314159265359ULL;
+
+            /// The 48 bit magic number at the end of each bzip2 stream.
+            constexpr const uint64_t bzip2_eos_magic = 0x177245385090ULL;
+
+            /**
+             * After a block failed to decompress, try at most this many
+             * pieces merged together.
+             */
+            constexpr const int bzip2_max_merge_pieces = 4;
+
+            /**
+             * Helper class for building a string of bits which don't start
+             * on byte boundaries. Bits are stored most significant bit first
+             * like in bzip2 streams.
+             */
+            class bit_string {
+
+                std::string m_data;
+                uint64_t m_acc = 0;
+                unsigned int m_acc_bits = 0;
+
+            public:
+
+                /// Append the lowest count bits of value. count must be <= 32.
+                void append_bits(uint64_t value, unsigned int count) {
+                    assert(count <= 32);
+                    m_acc = (m_acc << count) | (value & ((1ULL << count) - 1));
+                    m_acc_bits += count;
+                    while (m_acc_bits >= 8) {
+                        m_acc_bits -= 8;
+                        m_data += static_cast<char>((m_acc >> m_acc_bits) & 0xff);
+                    }
+                }
+
+                /// Append num_bits bits starting at bit start_bit of data.
+                void append(const char* data, unsigned int start_bit, size_t num_bits) {
+                    const auto d = reinterpret_cast<const unsigned char*>(data) + start_bit / 8;
+                    const unsigned int shift = start_bit % 8;
+                    size_t n = 0;
+                    for (; num_bits >= 8; num_bits -= 8, ++n) {
+                        const unsigned int byte = shift == 0 ? d[n] : ((unsigned(d[n]) << 8 | d[n + 1]) >> (8 - shift));
+                        append_bits(byte, 8);
+                    }
+                    for (unsigned int i = 0; i < num_bits; ++i) {
+                        const unsigned int bit = shift + i;
+                        append_bits(d[n + bit / 8] >> (7 - bit % 8), 1);
+                    }
+                }
+
+                size_t num_bits() const noexcept {
+                    return m_data.size() * 8 + m_acc_bits;
+                }
+
+                /// The complete bytes appended so far.
+                const std::string& data() const noexcept {
+                    return m_data;
+                }
+
+                /// Pad to the next byte boundary with 0 bits and return the data.
+                std::string finish() {
+                    if (m_acc_bits > 0) {
+                        append_bits(0, 8 - m_acc_bits);
+                    }
+                    return std::move(m_data);
+                }
+
+            }; // class bit_string
+
+            /**
+             * Part of a bzip2 file between two magic numbers. The bits
+             * start at start_bit in the first byte of data.
+             */
+            struct bzip2_piece {
+
+                std::string data;
+                unsigned int start_bit = 0;
+                size_t num_bits = 0;
+
+                // true if this piece starts with a block magic, false
+                // if it starts with an end-of-stream magic
+                bool block = true;
+
+            }; // struct bzip2_piece
+
+            /**
+             * Concatenate two adjacent pieces. This is needed if a piece
+             * was split at something that looked like a magic number but
+             * was part of the compressed data.
+             */
+            inline bzip2_piece bzip2_merge_pieces(const bzip2_piece& first, const bzip2_piece& second) {
+                bit_string bits;
+                bits.append(first.data.data(), first.start_bit, first.num_bits);
+                bits.append(second.data.data(), second.start_bit, second.num_bits);
+
+                bzip2_piece piece;
+                piece.num_bits = bits.num_bits();
+                piece.data = bits.finish();
+                piece.block = first.block;
+                return piece;
+            }
+
+            struct bzip2_block_result {
+                std::string data;
+                int error = BZ_OK;
+            }; // struct bzip2_block_result
+
+            /**
+             * Decompress one block of a bzip2 file. The block is wrapped
+             * into a bzip2 stream of its own, with the header and the
+             * end-of-stream marker. The stream CRC of a stream with only
+             * one block is the CRC of that block.
+             */
+            inline bzip2_block_result bzip2_decompress_piece(const bzip2_piece& piece) {
+                bzip2_block_result result;
+
+                // block magic and block CRC
+                if (!piece.block || piece.num_bits < 80) {
+                    result.error = BZ_DATA_ERROR;
+                    return result;
+                }
+
+                bit_string bits;
+                bits.append_bits(0x425a6839, 32); // "BZh9"
+                bits.append(piece.data.data(), piece.start_bit, piece.num_bits);
+                const auto crc = reinterpret_cast<const unsigned char*>(bits.data().data()) + 10;
+                const uint32_t block_crc = (uint32_t(crc[0]) << 24) | (uint32_t(crc[1]) << 16) | (uint32_t(crc[2]) << 8) | uint32_t(crc[3]);
+                bits.append_bits(bzip2_eos_magic >> 24, 24);
+                bits.append_bits(bzip2_eos_magic, 24);
+                bits.append_bits(block_crc, 32);
+                std::string input = bits.finish();
+
+                bz_stream stream{};
+                result.error = BZ2_bzDecompressInit(&stream, 0, 0);
+                if (result.error != BZ_OK) {
+                    return result;
+                }
+
+                stream.next_in = &input[0];
+                stream.avail_in = static_cast_with_assert<unsigned int>(input.size());
+
+                size_t size = 0;
+                do {
+                    result.data.resize(size + osmium::io::Decompressor::input_buffer_size);
+                    stream.next_out = &result.data[size];
+                    stream.avail_out = static_cast_with_assert<unsigned int>(osmium::io::Decompressor::input_buffer_size);
+                    result.error = BZ2_bzDecompress(&stream);
+                    size = result.data.size() - stream.avail_out;
+                } while (result.error == BZ_OK && (stream.avail_in > 0 || stream.avail_out == 0));
+
+                BZ2_bzDecompressEnd(&stream);
+
+                if (result.error == BZ_STREAM_END) {
+                    result.error = BZ_OK;
+                    result.data.resize(size);
+                } else {
+                    if (result.error == BZ_OK) {
+                        result.error = BZ_UNEXPECTED_EOF;
+                    }
+                    result.data.clear();
+                }
+
+                return result;
+            }
+
+            /**
+             * Functor decompressing one bzip2 block. Runs in the Pool.
+             */
+            class Bzip2BlockDecompressTask {
+
+                std::shared_ptr<const bzip2_piece> m_piece;
+
+            public:
+
+                explicit Bzip2BlockDecompressTask(const std::shared_ptr<const bzip2_piece>& piece) :
+                    m_piece(piece) {
+                }
+
+                bzip2_block_result operator()() const {
+                    return bzip2_decompress_piece(*m_piece);
+                }
+
+            }; // class Bzip2BlockDecompressTask
+
+        } // namespace detail
+
+        /**
+         * Bzip2 decompressor using the thread pool. The input is split
+         * into blocks by looking for the 48 bit block magic numbers (which
+         * are not byte aligned) and each block is decompressed on its own
+         * in the Pool. The results are returned in order. Files with
+         * several concatenated bzip2 streams (as written by pbzip2) are
+         * supported.
+         *
+         * A magic number can, in very rare cases, also appear inside the
+         * compressed data. If a block fails to decompress it is tried
+         * again together with the following piece(s) of the file.
+         */
+        class Bzip2ParallelDecompressor : public Decompressor {
+
+            struct pending_piece {
+                std::shared_ptr<const detail::bzip2_piece> piece;
+                std::future<detail::bzip2_block_result> result;
+            };
+
+            int m_fd;
+
+            // Input data not scanned yet and the current piece.
+            std::string m_input;
+            bool m_input_done = false;
+            bool m_header_checked = false;
+
+            // Position of the next byte to scan in m_input.
+            size_t m_scan_pos = 0;
+
+            // The last 64 bits scanned.
+            uint64_t m_window = 0;
+
+            // Start (in bits in m_input) of the current piece.
+            size_t m_piece_start = 0;
+            bool m_in_piece = false;
+            bool m_piece_is_block = false;
+
+            std::deque<pending_piece> m_pending;
+            size_t m_max_pending;
+
+            void add_piece(size_t end) {
+                const size_t first_byte = m_piece_start / 8;
+                const size_t last_byte = (end + 7) / 8;
+                std::shared_ptr<detail::bzip2_piece> piece{std::make_shared<detail::bzip2_piece>()};
+                piece->data.assign(m_input, first_byte, last_byte - first_byte);
+                piece->start_bit = static_cast<unsigned int>(m_piece_start % 8);
+                piece->num_bits = end - m_piece_start;
+                piece->block = m_piece_is_block;
+
+                pending_piece pending;
+                pending.piece = piece;
+                if (piece->block) {
+                    pending.result = osmium::thread::Pool::instance().submit(detail::Bzip2BlockDecompressTask{pending.piece}, osmium::thread::task_priority::high);
+                }
+                m_pending.push_back(std::move(pending));
+            }
+
+            void found_magic(size_t start, bool block) {
+                if (m_in_piece) {
+                    add_piece(start);
+                }
+                m_piece_start = start;
+                m_in_piece = true;
+                m_piece_is_block = block;
+            }
+
+            void check_header() {
+                while (!m_input_done && m_input.size() < 4) {
+                    read_input();
+                }
+                if (m_input.size() < 4 || m_input.compare(0, 3, "BZh") != 0 || m_input[3] < '1' || m_input[3] > '9') {
+                    throw osmium::bzip2_error{"bzip2 error: not in bzip2 format", BZ_DATA_ERROR_MAGIC};
+                }
+                m_header_checked = true;
+            }
+
+            void read_input() {
+                const size_t old_size = m_input.size();
+                m_input.resize(old_size + osmium::io::Decompressor::input_buffer_size);
+                const auto nread = ::read(m_fd, &m_input[old_size], osmium::io::Decompressor::input_buffer_size);
+                if (nread < 0) {
+                    m_input.resize(old_size);
+                    throw std::system_error(errno, std::system_category(), "Read failed");
+                }
+                m_input.resize(old_size + std::string::size_type(nread));
+                if (nread == 0) {
+                    m_input_done = true;
+                }
+            }
+
+            // Read the next chunk of input and split it into pieces.
+            void scan_input() {
+                if (!m_header_checked) {
+                    check_header();
+                } else {
+                    read_input();
+                }
+
+                const uint64_t mask = (1ULL << 48) - 1;
+                for (; m_scan_pos < m_input.size(); ++m_scan_pos) {
+                    const auto byte = static_cast<unsigned char>(m_input[m_scan_pos]);
+                    for (int bit = 7; bit >= 0; --bit) {
+                        m_window = (m_window << 1) | ((byte >> bit) & 1);
+                        const uint64_t value = m_window & mask;
+                        if (value == detail::bzip2_block_magic || value == detail::bzip2_eos_magic) {
+                            found_magic(m_scan_pos * 8 + 8 - bit - 48, value == detail::bzip2_block_magic);
+                        }
+                    }
+                }
+
+                if (m_input_done) {
+                    if (m_in_piece) {
+                        if (m_piece_is_block) {
+                            throw osmium::bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                        }
+                        add_piece(m_input.size() * 8);
+                        m_in_piece = false;
+                    }
+                    m_input.clear();
+                    m_scan_pos = 0;
+                    return;
+                }
+
+                // remove data we don't need any more
+                const size_t keep = m_in_piece ? m_piece_start / 8 : m_scan_pos;
+                m_input.erase(0, keep);
+                m_scan_pos -= keep;
+                if (m_in_piece) {
+                    m_piece_start -= keep * 8;
+                }
+            }
+
+            // Called if the first pending piece could not be decompressed.
+            // Merge it with the following pieces and try again.
+            detail::bzip2_block_result retry_merged(detail::bzip2_block_result&& failed) {
+                detail::bzip2_piece piece = *m_pending.front().piece;
+                m_pending.pop_front();
+
+                for (int i = 1; i < detail::bzip2_max_merge_pieces; ++i) {
+                    while (m_pending.empty() && !m_input_done) {
+                        scan_input();
+                    }
+                    if (m_pending.empty()) {
+                        break;
+                    }
+                    piece = detail::bzip2_merge_pieces(piece, *m_pending.front().piece);
+                    m_pending.pop_front();
+                    detail::bzip2_block_result result = detail::bzip2_decompress_piece(piece);
+                    if (result.error == BZ_OK) {
+                        return result;
+                    }
+                }
+
+                throw osmium::bzip2_error{"bzip2 error: block decompression failed: " + std::to_string(failed.error), failed.error};
+            }
+
+        public:
+
+            explicit Bzip2ParallelDecompressor(int fd) :
+                Decompressor(),
+                m_fd(fd),
+                m_max_pending(2 * size_t(osmium::thread::Pool::instance().num_threads())) {
+            }
+
+            ~Bzip2ParallelDecompressor() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() final {
+                while (true) {
+                    while (!m_input_done && m_pending.size() < m_max_pending) {
+                        scan_input();
+                    }
+
+                    if (m_pending.empty()) {
+                        return std::string{};
+                    }
+
+                    if (!m_pending.front().piece->block) {
+                        // end-of-stream marker, stream CRC and maybe the
+                        // header of the next stream
+                        m_pending.pop_front();
+                        continue;
+                    }
+
+                    detail::bzip2_block_result result = m_pending.front().result.get();
+                    if (result.error == BZ_OK) {
+                        m_pending.pop_front();
+                    } else {
+                        result = retry_merged(std::move(result));
+                    }
+
+                    if (!result.data.empty()) {
+                        return std::move(result.data);
+                    }
+                }
+            }
+
+            void close() final {
+                m_pending.clear();
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class Bzip2ParallelDecompressor
+
         namespace detail {
 
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_bzip2_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::bzip2,
                 [](int fd, fsync sync) { return new osmium::io::Bzip2Compressor(fd, sync); },
-                [](int fd) { return new osmium::io::Bzip2Decompressor(fd); },
+                [](int fd) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_pool_threads_for_bzip2()) {
+                        return new osmium::io::Bzip2ParallelDecompressor(fd);
+                    }
+                    return new osmium::io::Bzip2Decompressor(fd);
+                },
                 [](const char* buffer, size_t size) { return new osmium::io::Bzip2BufferDecompressor(buffer, size); }
             );
 
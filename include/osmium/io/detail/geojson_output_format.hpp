@@ -0,0 +1,304 @@
+#ifndef OSMIUM_IO_DETAIL_GEOJSON_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_GEOJSON_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cinttypes>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/geojson.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/string_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            struct geojson_output_options {
+
+                /// Should metadata of objects be added to the properties?
+                bool add_metadata;
+
+                /**
+                 * Start each feature with the record separator (RS)
+                 * character as described in RFC 8142 (GeoJSON Text
+                 * Sequences)? Otherwise the features are written into
+                 * one FeatureCollection.
+                 */
+                bool record_separator;
+
+                /// Should areas be written?
+                bool write_areas;
+
+            };
+
+            /**
+             * Writes out one buffer with OSM data as a sequence of GeoJSON
+             * features. Nodes become points, ways linestrings, and areas
+             * multipolygons. Relations and objects for which no geometry
+             * can be built are written with a null geometry.
+             */
+            class GeoJSONOutputBlock : public OutputBlock {
+
+                geojson_output_options m_options;
+
+                osmium::geom::GeoJSONFactory<> m_factory;
+
+                // Is the next feature the first one in the
+                // FeatureCollection? Otherwise it needs a comma in front.
+                bool m_first_feature;
+
+                void append_encoded_string(const char* data) {
+                    osmium::io::detail::append_json_encoded_string(*m_out, data);
+                }
+
+                void start_feature(char type, osmium::object_id_type id) {
+                    if (m_options.record_separator) {
+                        *m_out += '\x1e';
+                    } else if (m_first_feature) {
+                        m_first_feature = false;
+                    } else {
+                        *m_out += ",\n";
+                    }
+                    output_formatted("{\"type\":\"Feature\",\"id\":\"%c%" PRId64 "\",\"geometry\":", type, id);
+                }
+
+                void write_properties(const osmium::OSMObject& object, const char* type, osmium::object_id_type id) {
+                    output_formatted(",\"properties\":{\"@type\":\"%s\",\"@id\":%" PRId64, type, id);
+                    if (m_options.add_metadata) {
+                        output_formatted(",\"@version\":%u,\"@changeset\":%u,\"@timestamp\":\"", object.version(), object.changeset());
+                        *m_out += object.timestamp().to_iso();
+                        output_formatted("\",\"@uid\":%u,\"@user\":\"", object.uid());
+                        append_encoded_string(object.user());
+                        *m_out += '"';
+                        if (!object.visible()) {
+                            *m_out += ",\"@visible\":false";
+                        }
+                    }
+                    for (const auto& tag : object.tags()) {
+                        *m_out += ",\"";
+                        append_encoded_string(tag.key());
+                        *m_out += "\":\"";
+                        append_encoded_string(tag.value());
+                        *m_out += '"';
+                    }
+                    *m_out += "}}";
+                    if (m_options.record_separator) {
+                        *m_out += '\n';
+                    }
+                }
+
+                /**
+                 * Append the geometry created by the function or null if
+                 * it can't be created.
+                 */
+                template <typename TFunc>
+                void write_geometry(TFunc&& func) {
+                    try {
+                        *m_out += std::forward<TFunc>(func)();
+                    } catch (const osmium::geometry_error&) {
+                        *m_out += "null";
+                    } catch (const osmium::invalid_location&) {
+                        *m_out += "null";
+                    }
+                }
+
+            public:
+
+                GeoJSONOutputBlock(osmium::memory::Buffer&& buffer, const geojson_output_options& options, bool first_feature) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options),
+                    m_factory(),
+                    m_first_feature(first_feature) {
+                }
+
+                GeoJSONOutputBlock(const GeoJSONOutputBlock&) = default;
+                GeoJSONOutputBlock& operator=(const GeoJSONOutputBlock&) = default;
+
+                GeoJSONOutputBlock(GeoJSONOutputBlock&&) = default;
+                GeoJSONOutputBlock& operator=(GeoJSONOutputBlock&&) = default;
+
+                ~GeoJSONOutputBlock() noexcept = default;
+
+                std::string operator()() {
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    start_feature('n', node.id());
+                    write_geometry([this, &node]() {
+                        return m_factory.create_point(node);
+                    });
+                    write_properties(node, "node", node.id());
+                }
+
+                void way(const osmium::Way& way) {
+                    start_feature('w', way.id());
+                    write_geometry([this, &way]() {
+                        return m_factory.create_linestring(way);
+                    });
+                    write_properties(way, "way", way.id());
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    start_feature('r', relation.id());
+                    *m_out += "null";
+                    write_properties(relation, "relation", relation.id());
+                }
+
+                void area(const osmium::Area& area) {
+                    if (!m_options.write_areas) {
+                        return;
+                    }
+                    const char type = area.from_way() ? 'w' : 'r';
+                    start_feature(type, area.orig_id());
+                    write_geometry([this, &area]() {
+                        return m_factory.create_multipolygon(area);
+                    });
+                    write_properties(area, area.from_way() ? "way" : "relation", area.orig_id());
+                }
+
+            }; // class GeoJSONOutputBlock
+
+            class GeoJSONOutputFormat : public osmium::io::detail::OutputFormat {
+
+                geojson_output_options m_options;
+
+                // Has no feature been written to the FeatureCollection yet?
+                bool m_first_feature;
+
+                // Will the buffer result in at least one feature?
+                bool has_features(const osmium::memory::Buffer& buffer) const {
+                    for (const auto& entity : buffer) {
+                        switch (entity.type()) {
+                            case osmium::item_type::node:
+                            case osmium::item_type::way:
+                            case osmium::item_type::relation:
+                                return true;
+                            case osmium::item_type::area:
+                                if (m_options.write_areas) {
+                                    return true;
+                                }
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    return false;
+                }
+
+            public:
+
+                GeoJSONOutputFormat(const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(output_queue),
+                    m_options(),
+                    m_first_feature(true) {
+                    m_options.add_metadata     = file.is_not_false("add_metadata");
+                    m_options.record_separator = file.is_true("json_seq");
+                    m_options.write_areas      = file.is_true("json_areas");
+                }
+
+                GeoJSONOutputFormat(const GeoJSONOutputFormat&) = delete;
+                GeoJSONOutputFormat& operator=(const GeoJSONOutputFormat&) = delete;
+
+                ~GeoJSONOutputFormat() noexcept final = default;
+
+                void write_header(const osmium::io::Header&) final {
+                    if (!m_options.record_separator) {
+                        send_to_output_queue(std::string{"{\"type\":\"FeatureCollection\",\"features\":[\n"});
+                    }
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    const auto size = buffer.committed();
+                    const bool first_feature = m_first_feature;
+                    if (!m_options.record_separator && m_first_feature && has_features(buffer)) {
+                        m_first_feature = false;
+                    }
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(GeoJSONOutputBlock{std::move(buffer), m_options, first_feature}), size);
+                }
+
+                void write_end() final {
+                    if (!m_options.record_separator) {
+                        send_to_output_queue(std::string{"\n]}\n"});
+                    }
+                }
+
+            }; // class GeoJSONOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_geojson_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::json,
+                [](const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::GeoJSONOutputFormat(file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_geojson_output() noexcept {
+                return registered_geojson_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_GEOJSON_OUTPUT_FORMAT_HPP
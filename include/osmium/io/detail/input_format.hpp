@@ -43,11 +43,14 @@ DEALINGS IN THE SOFTWARE.
 #include <utility>
 
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/read_filter.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 namespace osmium {
 
@@ -60,6 +63,10 @@ namespace osmium {
                 future_buffer_queue_type& m_output_queue;
                 std::promise<osmium::io::Header>& m_header_promise;
                 queue_wrapper<std::string> m_input_queue;
+                std::shared_ptr<osmium::util::MemoryMapping> m_mapped_input;
+                size_t m_mapped_input_start;
+                std::shared_ptr<osmium::memory::BufferPool> m_buffer_pool;
+                read_filter m_filter;
                 osmium::osm_entity_bits::type m_read_types;
                 bool m_header_is_done;
 
@@ -73,6 +80,45 @@ namespace osmium {
                     return m_input_queue.has_reached_end_of_data();
                 }
 
+                /**
+                 * The complete input file mapped into memory. This is only
+                 * set if the Reader was asked to use a memory mapping and
+                 * the input allowed it (currently only for uncompressed PBF
+                 * files). In that case the input queue will not contain any
+                 * data.
+                 */
+                const std::shared_ptr<osmium::util::MemoryMapping>& mapped_input() const noexcept {
+                    return m_mapped_input;
+                }
+
+                /**
+                 * The offset into the mapped input where reading of the
+                 * OSM data should start (after the header has been read).
+                 * 0 means: read everything.
+                 */
+                size_t mapped_input_start() const noexcept {
+                    return m_mapped_input_start;
+                }
+
+                /**
+                 * Pool of buffers returned by the user of the Reader for
+                 * reuse. Parsers can take new buffers from here instead of
+                 * allocating them. Can be empty.
+                 */
+                const std::shared_ptr<osmium::memory::BufferPool>& buffer_pool() const noexcept {
+                    return m_buffer_pool;
+                }
+
+                /**
+                 * Restrictions on the objects that should be read. Parsers
+                 * can use this to skip objects early. The Reader filters
+                 * the objects afterwards for parsers that don't support
+                 * this (see Reader::read()).
+                 */
+                const read_filter& filter() const noexcept {
+                    return m_filter;
+                }
+
                 osmium::osm_entity_bits::type read_types() const {
                     return m_read_types;
                 }
@@ -102,8 +148,17 @@ namespace osmium {
                     add_to_queue(m_output_queue, std::move(buffer));
                 }
 
-                void send_to_output_queue(std::future<osmium::memory::Buffer>&& future) {
-                    m_output_queue.push(std::move(future));
+                /**
+                 * Add a buffer that is still being worked on to the output
+                 * queue.
+                 *
+                 * @param future Future for the buffer.
+                 * @param estimated_size Estimated size of the buffer in
+                 *                       bytes, used for limiting the
+                 *                       memory use of the queue.
+                 */
+                void send_to_output_queue(std::future<osmium::memory::Buffer>&& future, size_t estimated_size = 0) {
+                    m_output_queue.push(std::move(future), estimated_size);
                 }
 
             public:
@@ -115,6 +170,10 @@ namespace osmium {
                     m_output_queue(output_queue),
                     m_header_promise(header_promise),
                     m_input_queue(input_queue),
+                    m_mapped_input(),
+                    m_mapped_input_start(0),
+                    m_buffer_pool(),
+                    m_filter(),
                     m_read_types(read_types),
                     m_header_is_done(false) {
                 }
@@ -129,6 +188,19 @@ namespace osmium {
 
                 virtual void run() = 0;
 
+                void set_mapped_input(const std::shared_ptr<osmium::util::MemoryMapping>& mapping, size_t start = 0) {
+                    m_mapped_input = mapping;
+                    m_mapped_input_start = start;
+                }
+
+                void set_buffer_pool(const std::shared_ptr<osmium::memory::BufferPool>& buffer_pool) {
+                    m_buffer_pool = buffer_pool;
+                }
+
+                void set_filter(const read_filter& filter) {
+                    m_filter = filter;
+                }
+
                 void parse() {
                     try {
                         run();
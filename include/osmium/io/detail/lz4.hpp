@@ -0,0 +1,148 @@
+#ifndef OSMIUM_IO_DETAIL_LZ4_HPP
+#define OSMIUM_IO_DETAIL_LZ4_HPP
+
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef OSMIUM_WITH_LZ4
+# include <lz4.h>
+# include <lz4hc.h>
+#endif
+
+#include <osmium/io/error.hpp>
+#include <osmium/util/cast.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Is lz4 compression available? This is the case if libosmium
+             * was compiled with OSMIUM_WITH_LZ4 defined.
+             */
+            constexpr bool lz4_available() noexcept {
+#ifdef OSMIUM_WITH_LZ4
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            /**
+             * The largest compression level lz4 accepts. Levels above 0
+             * use lz4hc.
+             */
+            constexpr int lz4_max_compression_level() noexcept {
+                return 12;
+            }
+
+            /**
+             * Compress data using lz4.
+             *
+             * @param input Data to compress.
+             * @param level Compression level. If this is 0 or smaller, the
+             *              fast default lz4 compression is used, otherwise
+             *              lz4hc with this level.
+             * @returns Compressed data.
+             * @throws io_error If lz4 is not available or compression fails.
+             */
+            inline std::string lz4_compress(const std::string& input, int level = 0) {
+#ifdef OSMIUM_WITH_LZ4
+                const int input_size = osmium::static_cast_with_assert<int>(input.size());
+                std::string output(static_cast<std::size_t>(LZ4_compressBound(input_size)), '\0');
+
+                const int size = level > 0 ?
+                    LZ4_compress_HC(input.data(), &output[0], input_size, static_cast<int>(output.size()), level) :
+                    LZ4_compress_default(input.data(), &output[0], input_size, static_cast<int>(output.size()));
+
+                if (size <= 0) {
+                    throw io_error{"failed to compress data with lz4"};
+                }
+
+                output.resize(static_cast<std::size_t>(size));
+
+                return output;
+#else
+                (void)input;
+                (void)level;
+                throw io_error{"lz4 compression not available (compile with OSMIUM_WITH_LZ4)"};
+#endif
+            }
+
+            /**
+             * Uncompress data using lz4.
+             *
+             * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to uncompressed data.
+             * @throws io_error If lz4 is not available or the data is
+             *         corrupted.
+             */
+            inline std::pair<const char*, std::size_t> lz4_uncompress_string(const char* input, std::size_t input_size, std::size_t raw_size, std::string& output) {
+#ifdef OSMIUM_WITH_LZ4
+                output.resize(raw_size);
+
+                const int size = LZ4_decompress_safe(input,
+                                                     &output[0],
+                                                     osmium::static_cast_with_assert<int>(input_size),
+                                                     osmium::static_cast_with_assert<int>(raw_size));
+
+                if (size < 0 || static_cast<std::size_t>(size) != raw_size) {
+                    throw io_error{"failed to uncompress lz4 data"};
+                }
+
+                return std::make_pair(output.data(), output.size());
+#else
+                (void)input;
+                (void)input_size;
+                (void)raw_size;
+                (void)output;
+                throw io_error{"lz4 compression not available (compile with OSMIUM_WITH_LZ4)"};
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_LZ4_HPP
@@ -295,76 +295,117 @@ namespace osmium {
                     return std::make_pair(static_cast_with_assert<osmium::user_id_type>(uid), user);
                 }
 
-                void decode_tags(osmium::builder::Builder* builder, const char** dataptr, const char* const end) {
-                    osmium::builder::TagListBuilder tl_builder(m_buffer, builder);
-
-                    while(*dataptr != end) {
-                        bool update_pointer = (**dataptr == 0x00);
-                        const char* data = decode_string(dataptr, end);
-                        const char* start = data;
+                std::pair<const char*, const char*> decode_tag(const char** dataptr, const char* const end) {
+                    bool update_pointer = (**dataptr == 0x00);
+                    const char* data = decode_string(dataptr, end);
+                    const char* start = data;
 
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error("no null byte in tag key");
-                            }
+                    while (*data++) {
+                        if (data == end) {
+                            throw o5m_error("no null byte in tag key");
                         }
+                    }
 
-                        const char* value = data;
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error("no null byte in tag value");
-                            }
+                    const char* value = data;
+                    while (*data++) {
+                        if (data == end) {
+                            throw o5m_error("no null byte in tag value");
                         }
+                    }
 
-                        if (update_pointer) {
-                            m_reference_table.add(start, data - start);
-                            *dataptr = data;
-                        }
+                    if (update_pointer) {
+                        m_reference_table.add(start, data - start);
+                        *dataptr = data;
+                    }
 
-                        tl_builder.add_tag(start, value);
+                    return std::make_pair(start, value);
+                }
+
+                void decode_tags(osmium::builder::Builder* builder, const char** dataptr, const char* const end) {
+                    osmium::builder::TagListBuilder tl_builder(m_buffer, builder);
+
+                    while(*dataptr != end) {
+                        const auto tag = decode_tag(dataptr, end);
+                        tl_builder.add_tag(tag.first, tag.second);
                     }
                 }
 
-                const char* decode_info(osmium::OSMObject& object, const char** dataptr, const char* const end) {
+                // Decode tags of an object that will not be built. This is
+                // needed to keep the reference table up to date.
+                void skip_tags(const char** dataptr, const char* const end) {
+                    while(*dataptr != end) {
+                        decode_tag(dataptr, end);
+                    }
+                }
+
+                struct object_info {
+                    osmium::object_version_type version = 0;
+                    int64_t timestamp = 0;
+                    osmium::changeset_id_type changeset = 0;
+                    osmium::user_id_type uid = 0;
                     const char* user = "";
+                };
+
+                object_info decode_info(const char** dataptr, const char* const end) {
+                    object_info info;
 
                     if (**dataptr == 0x00) { // no info section
                         ++*dataptr;
                     } else { // has info section
-                        object.set_version(static_cast_with_assert<object_version_type>(protozero::decode_varint(dataptr, end)));
-                        auto timestamp = m_delta_timestamp.update(zvarint(dataptr, end));
-                        if (timestamp != 0) { // has timestamp
-                            object.set_timestamp(timestamp);
-                            object.set_changeset(m_delta_changeset.update(zvarint(dataptr, end)));
+                        info.version = static_cast_with_assert<object_version_type>(protozero::decode_varint(dataptr, end));
+                        info.timestamp = m_delta_timestamp.update(zvarint(dataptr, end));
+                        if (info.timestamp != 0) { // has timestamp
+                            info.changeset = m_delta_changeset.update(zvarint(dataptr, end));
                             if (*dataptr != end) {
                                 auto uid_user = decode_user(dataptr, end);
-                                object.set_uid(uid_user.first);
-                                user = uid_user.second;
-                            } else {
-                                object.set_uid(user_id_type(0));
+                                info.uid = uid_user.first;
+                                info.user = uid_user.second;
                             }
                         }
                     }
 
-                    return user;
+                    return info;
+                }
+
+                template <typename TBuilder>
+                static void set_info(TBuilder& builder, osmium::object_id_type id, const object_info& info) {
+                    auto& object = builder.object();
+                    object.set_id(id);
+                    object.set_version(info.version);
+                    if (info.timestamp != 0) {
+                        object.set_timestamp(info.timestamp);
+                        object.set_changeset(info.changeset);
+                        object.set_uid(info.uid);
+                    }
+                    builder.add_user(info.user);
                 }
 
                 void decode_node(const char* data, const char* const end) {
-                    osmium::builder::NodeBuilder builder(m_buffer);
-                    osmium::Node& node = builder.object();
+                    const auto id = m_delta_id.update(zvarint(&data, end));
+                    const auto info = decode_info(&data, end);
 
-                    node.set_id(m_delta_id.update(zvarint(&data, end)));
+                    // no location means the object is deleted
+                    const bool visible = data != end;
+                    osmium::Location location;
+                    if (visible) {
+                        auto lon = m_delta_lon.update(zvarint(&data, end));
+                        auto lat = m_delta_lat.update(zvarint(&data, end));
+                        location = osmium::Location{lon, lat};
+                    }
 
-                    builder.add_user(decode_info(node, &data, end));
+                    if (!filter().id_matches(id) || !filter().location_matches(location)) {
+                        skip_tags(&data, end);
+                        return;
+                    }
 
-                    if (data == end) {
-                        // no location, object is deleted
+                    osmium::builder::NodeBuilder builder(m_buffer);
+                    set_info(builder, id, info);
+
+                    if (!visible) {
                         builder.object().set_visible(false);
                         builder.object().set_location(osmium::Location{});
                     } else {
-                        auto lon = m_delta_lon.update(zvarint(&data, end));
-                        auto lat = m_delta_lat.update(zvarint(&data, end));
-                        builder.object().set_location(osmium::Location{lon, lat});
+                        builder.object().set_location(location);
 
                         if (data != end) {
                             decode_tags(&builder, &data, end);
@@ -375,12 +416,26 @@ namespace osmium {
                 }
 
                 void decode_way(const char* data, const char* const end) {
-                    osmium::builder::WayBuilder builder(m_buffer);
-                    osmium::Way& way = builder.object();
+                    const auto id = m_delta_id.update(zvarint(&data, end));
+                    const auto info = decode_info(&data, end);
 
-                    way.set_id(m_delta_id.update(zvarint(&data, end)));
+                    if (!filter().id_matches(id)) {
+                        if (data != end) {
+                            const auto reference_section_length = protozero::decode_varint(&data, end);
+                            const char* const end_refs = data + reference_section_length;
+                            if (end_refs > end) {
+                                throw o5m_error("way nodes ref section too long");
+                            }
+                            while (data < end_refs) {
+                                m_delta_way_node_id.update(zvarint(&data, end));
+                            }
+                            skip_tags(&data, end);
+                        }
+                        return;
+                    }
 
-                    builder.add_user(decode_info(way, &data, end));
+                    osmium::builder::WayBuilder builder(m_buffer);
+                    set_info(builder, id, info);
 
                     if (data == end) {
                         // no reference section, object is deleted
@@ -441,12 +496,31 @@ namespace osmium {
                 }
 
                 void decode_relation(const char* data, const char* const end) {
-                    osmium::builder::RelationBuilder builder(m_buffer);
-                    osmium::Relation& relation = builder.object();
+                    const auto id = m_delta_id.update(zvarint(&data, end));
+                    const auto info = decode_info(&data, end);
 
-                    relation.set_id(m_delta_id.update(zvarint(&data, end)));
+                    if (!filter().id_matches(id)) {
+                        if (data != end) {
+                            const auto reference_section_length = protozero::decode_varint(&data, end);
+                            const char* const end_refs = data + reference_section_length;
+                            if (end_refs > end) {
+                                throw o5m_error("relation format error");
+                            }
+                            while (data < end_refs) {
+                                const auto delta_id = zvarint(&data, end);
+                                if (data == end) {
+                                    throw o5m_error("relation member format error");
+                                }
+                                const auto type_role = decode_role(&data, end);
+                                m_delta_member_ids[osmium::item_type_to_nwr_index(type_role.first)].update(delta_id);
+                            }
+                            skip_tags(&data, end);
+                        }
+                        return;
+                    }
 
-                    builder.add_user(decode_info(relation, &data, end));
+                    osmium::builder::RelationBuilder builder(m_buffer);
+                    set_info(builder, id, info);
 
                     if (data == end) {
                         // no reference section, object is deleted
@@ -0,0 +1,414 @@
+#ifndef OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <protozero/varint.hpp>
+
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/delta.hpp>
+#include <osmium/visitor.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Implementation of the o5m/o5c file formats according to the
+            // description at http://wiki.openstreetmap.org/wiki/O5m .
+
+            enum class o5m_dataset_type : unsigned char {
+                node         = 0x10,
+                way          = 0x11,
+                relation     = 0x12,
+                bounding_box = 0xdb,
+                timestamp    = 0xdc,
+                header       = 0xe0,
+                end_of_file  = 0xfe,
+                reset        = 0xff
+            };
+
+            inline void o5m_append_varint(std::string& out, uint64_t value) {
+                protozero::write_varint(std::back_inserter(out), value);
+            }
+
+            inline void o5m_append_zvarint(std::string& out, int64_t value) {
+                o5m_append_varint(out, protozero::encode_zigzag64(value));
+            }
+
+            /**
+             * The writing side of the o5m string reference table. It has
+             * to add exactly the same strings as the ReferenceTable in the
+             * O5mParser, so that the references written point to the
+             * right entries.
+             */
+            class O5mStringTable {
+
+                // The following settings are from the o5m description:
+
+                // The maximum number of entries in the table.
+                static constexpr const uint64_t number_of_entries = 15000;
+
+                // The maximum length of a string in the table including
+                // two \0 bytes.
+                static constexpr const size_t max_length = 250 + 2;
+
+                // For each string the number of the entry it was last
+                // added as.
+                std::unordered_map<std::string, uint64_t> m_index;
+
+                // Number of entries added since the last reset.
+                uint64_t m_count = 0;
+
+            public:
+
+                void clear() {
+                    m_index.clear();
+                    m_count = 0;
+                }
+
+                /**
+                 * Append a string (pair) to the output. If it is still in
+                 * the table, a reference is written, otherwise the string
+                 * is written inline and added to the table.
+                 */
+                void append(std::string& out, const std::string& str) {
+                    const auto it = m_index.find(str);
+                    if (it != m_index.end() && m_count - it->second <= number_of_entries) {
+                        o5m_append_varint(out, m_count - it->second);
+                        return;
+                    }
+
+                    out += '\0';
+                    out += str;
+
+                    if (str.size() <= max_length) {
+                        m_index[str] = m_count++;
+                    }
+                }
+
+                /**
+                 * Append the user. An anonymous user is always written
+                 * inline. It takes up an entry in the table but can not be
+                 * referenced.
+                 */
+                void append_user(std::string& out, osmium::user_id_type uid, const char* user, std::string& buffer) {
+                    if (uid == 0) {
+                        out.append(3, '\0');
+                        ++m_count;
+                        return;
+                    }
+
+                    buffer.clear();
+                    o5m_append_varint(buffer, uid);
+                    buffer += '\0';
+                    buffer += user;
+                    buffer += '\0';
+                    append(out, buffer);
+                }
+
+            }; // class O5mStringTable
+
+            struct o5m_output_options {
+
+                /// Should metadata of objects be written?
+                bool add_metadata;
+
+            };
+
+            /**
+             * Writes out one buffer with OSM data in o5m format. Each block
+             * starts with a reset, so the string table and the delta
+             * encoding only depend on the block and the blocks can be
+             * encoded in parallel.
+             */
+            class O5mOutputBlock : public OutputBlock {
+
+                o5m_output_options m_options;
+
+                O5mStringTable m_string_table;
+
+                osmium::util::DeltaEncode<osmium::object_id_type> m_delta_id;
+
+                osmium::util::DeltaEncode<int64_t> m_delta_timestamp;
+                osmium::util::DeltaEncode<osmium::changeset_id_type> m_delta_changeset;
+                osmium::util::DeltaEncode<int64_t> m_delta_lon;
+                osmium::util::DeltaEncode<int64_t> m_delta_lat;
+
+                osmium::util::DeltaEncode<osmium::object_id_type> m_delta_way_node_id;
+                osmium::util::DeltaEncode<osmium::object_id_type> m_delta_member_ids[3];
+
+                // Data of the current dataset
+                std::string m_data;
+
+                // Reference section of the current way or relation
+                std::string m_refs;
+
+                // Temporary string for building string table entries
+                std::string m_str;
+
+                void write_info(const osmium::OSMObject& object) {
+                    if (!m_options.add_metadata || object.version() == 0) {
+                        m_data += '\0';
+                        return;
+                    }
+
+                    o5m_append_varint(m_data, object.version());
+                    const int64_t timestamp = uint32_t(object.timestamp());
+                    o5m_append_zvarint(m_data, m_delta_timestamp.update(timestamp));
+                    if (timestamp != 0) {
+                        o5m_append_zvarint(m_data, m_delta_changeset.update(object.changeset()));
+                        m_string_table.append_user(m_data, object.uid(), object.user(), m_str);
+                    }
+                }
+
+                void write_tags(const osmium::TagList& tags) {
+                    for (const auto& tag : tags) {
+                        m_str = tag.key();
+                        m_str += '\0';
+                        m_str += tag.value();
+                        m_str += '\0';
+                        m_string_table.append(m_data, m_str);
+                    }
+                }
+
+                void write_refs() {
+                    o5m_append_varint(m_data, m_refs.size());
+                    m_data += m_refs;
+                    m_refs.clear();
+                }
+
+                void write_dataset(o5m_dataset_type type) {
+                    *m_out += static_cast<char>(type);
+                    o5m_append_varint(*m_out, m_data.size());
+                    *m_out += m_data;
+                    m_data.clear();
+                }
+
+            public:
+
+                O5mOutputBlock(osmium::memory::Buffer&& buffer, const o5m_output_options& options) :
+                    OutputBlock(std::move(buffer)),
+                    m_options(options),
+                    m_string_table(),
+                    m_delta_id(),
+                    m_delta_timestamp(),
+                    m_delta_changeset(),
+                    m_delta_lon(),
+                    m_delta_lat(),
+                    m_delta_way_node_id(),
+                    m_delta_member_ids(),
+                    m_data(),
+                    m_refs(),
+                    m_str() {
+                }
+
+                O5mOutputBlock(const O5mOutputBlock&) = default;
+                O5mOutputBlock& operator=(const O5mOutputBlock&) = default;
+
+                O5mOutputBlock(O5mOutputBlock&&) = default;
+                O5mOutputBlock& operator=(O5mOutputBlock&&) = default;
+
+                ~O5mOutputBlock() noexcept = default;
+
+                std::string operator()() {
+                    *m_out += static_cast<char>(o5m_dataset_type::reset);
+
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    o5m_append_zvarint(m_data, m_delta_id.update(node.id()));
+                    write_info(node);
+
+                    // deleted nodes have no location
+                    if (node.visible()) {
+                        o5m_append_zvarint(m_data, m_delta_lon.update(node.location().x()));
+                        o5m_append_zvarint(m_data, m_delta_lat.update(node.location().y()));
+                        write_tags(node.tags());
+                    }
+
+                    write_dataset(o5m_dataset_type::node);
+                }
+
+                void way(const osmium::Way& way) {
+                    o5m_append_zvarint(m_data, m_delta_id.update(way.id()));
+                    write_info(way);
+
+                    // deleted ways have no reference section
+                    if (way.visible()) {
+                        for (const auto& node_ref : way.nodes()) {
+                            o5m_append_zvarint(m_refs, m_delta_way_node_id.update(node_ref.ref()));
+                        }
+                        write_refs();
+                        write_tags(way.tags());
+                    }
+
+                    write_dataset(o5m_dataset_type::way);
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    o5m_append_zvarint(m_data, m_delta_id.update(relation.id()));
+                    write_info(relation);
+
+                    // deleted relations have no reference section
+                    if (relation.visible()) {
+                        for (const auto& member : relation.members()) {
+                            const auto index = osmium::item_type_to_nwr_index(member.type());
+                            o5m_append_zvarint(m_refs, m_delta_member_ids[index].update(member.ref()));
+                            m_str = static_cast<char>('0' + index);
+                            m_str += member.role();
+                            m_str += '\0';
+                            m_string_table.append(m_refs, m_str);
+                        }
+                        write_refs();
+                        write_tags(relation.tags());
+                    }
+
+                    write_dataset(o5m_dataset_type::relation);
+                }
+
+            }; // class O5mOutputBlock
+
+            class O5mOutputFormat : public osmium::io::detail::OutputFormat {
+
+                o5m_output_options m_options;
+
+                bool m_change_format;
+
+            public:
+
+                O5mOutputFormat(const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(output_queue),
+                    m_options(),
+                    m_change_format(file.has_multiple_object_versions()) {
+                    m_options.add_metadata = file.is_not_false("add_metadata");
+                }
+
+                O5mOutputFormat(const O5mOutputFormat&) = delete;
+                O5mOutputFormat& operator=(const O5mOutputFormat&) = delete;
+
+                ~O5mOutputFormat() noexcept final = default;
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string out{"\xff\xe0\x04o5"};
+                    out += m_change_format ? 'c' : 'm';
+                    out += '2';
+
+                    std::string data;
+                    if (!header.boxes().empty()) {
+                        const osmium::Box box = header.joined_boxes();
+                        o5m_append_zvarint(data, box.bottom_left().x());
+                        o5m_append_zvarint(data, box.bottom_left().y());
+                        o5m_append_zvarint(data, box.top_right().x());
+                        o5m_append_zvarint(data, box.top_right().y());
+                        out += static_cast<char>(o5m_dataset_type::bounding_box);
+                        o5m_append_varint(out, data.size());
+                        out += data;
+                    }
+
+                    std::string timestamp = header.get("o5m_timestamp");
+                    if (timestamp.empty()) {
+                        timestamp = header.get("osmosis_replication_timestamp");
+                    }
+                    if (!timestamp.empty()) {
+                        data.clear();
+                        o5m_append_zvarint(data, uint32_t(osmium::Timestamp{timestamp}));
+                        out += static_cast<char>(o5m_dataset_type::timestamp);
+                        o5m_append_varint(out, data.size());
+                        out += data;
+                    }
+
+                    send_to_output_queue(std::move(out));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    const auto size = buffer.committed();
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(O5mOutputBlock{std::move(buffer), m_options}), size);
+                }
+
+                void write_end() final {
+                    send_to_output_queue(std::string(1, static_cast<char>(o5m_dataset_type::end_of_file)));
+                }
+
+            }; // class O5mOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_o5m_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::o5m,
+                [](const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::O5mOutputFormat(file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_o5m_output() noexcept {
+                return registered_o5m_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
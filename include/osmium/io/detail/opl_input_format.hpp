@@ -0,0 +1,788 @@
+#ifndef OSMIUM_IO_DETAIL_OPL_INPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_OPL_INPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <utf8.h>
+
+#include <osmium/builder/builder.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when the OPL parser failed. The message contains
+     * the beginning of the data where the error happened.
+     */
+    struct opl_error : public io_error {
+
+        explicit opl_error(const std::string& what, const char* data = nullptr) :
+            io_error(std::string("OPL error: ") + what + (data ? std::string(" at '") + std::string(data, ::strnlen(data, 20)) + "'" : std::string{})) {
+        }
+
+    }; // struct opl_error
+
+    namespace io {
+
+        namespace detail {
+
+            // Parser for the OPL format as written by the OPLOutputFormat.
+            // All functions work on zero-terminated lines, the end of line
+            // is marked by a 0 byte.
+
+            inline bool opl_is_space(const char c) noexcept {
+                return c == ' ' || c == '\t';
+            }
+
+            // Is this the end of a field?
+            inline bool opl_is_field_end(const char c) noexcept {
+                return c == '\0' || opl_is_space(c);
+            }
+
+            // Is this the end of a string inside a field?
+            inline bool opl_is_string_end(const char c) noexcept {
+                return opl_is_field_end(c) || c == ',' || c == '=' || c == '@';
+            }
+
+            inline void opl_skip_space(const char** data) noexcept {
+                while (opl_is_space(**data)) {
+                    ++*data;
+                }
+            }
+
+            inline void opl_skip_field(const char** data) noexcept {
+                while (!opl_is_field_end(**data)) {
+                    ++*data;
+                }
+            }
+
+            inline void opl_parse_char(const char** data, const char c) {
+                if (**data != c) {
+                    throw opl_error{std::string{"expected '"} + c + "'", *data};
+                }
+                ++*data;
+            }
+
+            /**
+             * Parse a decimal integer with optional minus sign.
+             *
+             * @throws opl_error If there is no integer or it doesn't fit
+             *         into the range of T.
+             */
+            template <typename T>
+            inline T opl_parse_int(const char** data) {
+                const char* str = *data;
+                const bool negative = *str == '-';
+                if (negative) {
+                    ++str;
+                }
+
+                if (*str < '0' || *str > '9') {
+                    throw opl_error{"expected integer", *data};
+                }
+
+                int64_t value = 0;
+                int digits = 0;
+                while (*str >= '0' && *str <= '9') {
+                    if (++digits > 15) {
+                        throw opl_error{"integer too long", *data};
+                    }
+                    value = value * 10 + (*str - '0');
+                    ++str;
+                }
+
+                if (negative) {
+                    value = -value;
+                }
+
+                if (value < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+                    value > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+                    throw opl_error{"integer out of range", *data};
+                }
+
+                *data = str;
+                return static_cast<T>(value);
+            }
+
+            /**
+             * Parse an unsigned 32 bit value. The OPL writer formats some
+             * of those (changeset IDs, user IDs) as signed integers, so
+             * negative values are accepted.
+             */
+            inline uint32_t opl_parse_uint32(const char** data) {
+                const char* str = *data;
+                const auto value = opl_parse_int<int64_t>(data);
+                if (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<uint32_t>::max()) {
+                    throw opl_error{"integer out of range", str};
+                }
+                return static_cast<uint32_t>(value);
+            }
+
+            /**
+             * Parse a coordinate with up to seven decimal places directly
+             * into the fixed point format used by osmium::Location. Any
+             * further digits are ignored.
+             */
+            inline int32_t opl_parse_coordinate(const char** data) {
+                const char* str = *data;
+                const bool negative = *str == '-';
+                if (negative) {
+                    ++str;
+                }
+
+                int64_t value = 0;
+                int digits = 0;
+                while (*str >= '0' && *str <= '9') {
+                    if (++digits > 3) {
+                        throw opl_error{"coordinate too large", *data};
+                    }
+                    value = value * 10 + (*str - '0');
+                    ++str;
+                }
+
+                int scale = 7;
+                if (*str == '.') {
+                    ++str;
+                    while (*str >= '0' && *str <= '9') {
+                        if (scale > 0) {
+                            value = value * 10 + (*str - '0');
+                            --scale;
+                        }
+                        ++digits;
+                        ++str;
+                    }
+                }
+
+                if (digits == 0) {
+                    throw opl_error{"expected coordinate", *data};
+                }
+
+                for (; scale > 0; --scale) {
+                    value *= 10;
+                }
+
+                if (value > std::numeric_limits<int32_t>::max()) {
+                    throw opl_error{"coordinate too large", *data};
+                }
+
+                *data = str;
+                return static_cast<int32_t>(negative ? -value : value);
+            }
+
+            /**
+             * Parse a location written as "x<lon> y<lat>" (or with other
+             * characters instead of 'x' and 'y' for changeset bounds). The
+             * coordinates can be empty.
+             */
+            inline void opl_parse_x(const char** data, osmium::Location& location) {
+                if (!opl_is_field_end(**data)) {
+                    location.set_x(opl_parse_coordinate(data));
+                }
+            }
+
+            inline void opl_parse_y(const char** data, osmium::Location& location) {
+                if (!opl_is_field_end(**data)) {
+                    location.set_y(opl_parse_coordinate(data));
+                }
+            }
+
+            inline uint32_t opl_parse_hex_digit(const char** data) {
+                const char c = **data;
+                if (c >= '0' && c <= '9') {
+                    return static_cast<uint32_t>(c - '0');
+                }
+                if (c >= 'a' && c <= 'f') {
+                    return static_cast<uint32_t>(c - 'a' + 10);
+                }
+                if (c >= 'A' && c <= 'F') {
+                    return static_cast<uint32_t>(c - 'A' + 10);
+                }
+                throw opl_error{"expected hex digit", *data};
+            }
+
+            /**
+             * Parse a string up to the next space, comma, equal sign, or
+             * @ sign and append it to result. Characters encoded as
+             * %<hex code point>% are decoded.
+             */
+            inline void opl_parse_string(const char** data, std::string& result) {
+                const char* str = *data;
+                while (!opl_is_string_end(*str)) {
+                    if (*str == '%') {
+                        const char* escape = str;
+                        ++str;
+                        uint32_t value = 0;
+                        int digits = 0;
+                        while (*str != '%') {
+                            if (++digits > 8) {
+                                throw opl_error{"escape sequence too long", escape};
+                            }
+                            value = (value << 4) | opl_parse_hex_digit(&str);
+                            ++str;
+                        }
+                        if (digits == 0) {
+                            throw opl_error{"empty escape sequence", escape};
+                        }
+                        ++str;
+                        try {
+                            utf8::append(value, std::back_inserter(result));
+                        } catch (const utf8::exception&) {
+                            throw opl_error{"invalid code point in escape sequence", escape};
+                        }
+                    } else {
+                        const char* start = str;
+                        while (!opl_is_string_end(*str) && *str != '%') {
+                            ++str;
+                        }
+                        result.append(start, str);
+                    }
+                }
+                *data = str;
+            }
+
+            inline osmium::Timestamp opl_parse_timestamp(const char** data) {
+                if (opl_is_field_end(**data)) {
+                    return osmium::Timestamp{};
+                }
+
+                // timestamps always have the format yyyy-mm-ddThh:mm:ssZ
+                constexpr const size_t timestamp_length = 20;
+                if (::strnlen(*data, timestamp_length) < timestamp_length || (*data)[timestamp_length - 1] != 'Z') {
+                    throw opl_error{"can not parse timestamp", *data};
+                }
+
+                try {
+                    const osmium::Timestamp timestamp{std::string{*data, timestamp_length}};
+                    *data += timestamp_length;
+                    return timestamp;
+                } catch (const std::invalid_argument&) {
+                    throw opl_error{"can not parse timestamp", *data};
+                }
+            }
+
+            inline void opl_parse_tags(const char* data, osmium::memory::Buffer& buffer, osmium::builder::Builder* parent, std::string& key, std::string& value) {
+                osmium::builder::TagListBuilder builder{buffer, parent};
+                while (!opl_is_field_end(*data)) {
+                    key.clear();
+                    value.clear();
+                    opl_parse_string(&data, key);
+                    opl_parse_char(&data, '=');
+                    opl_parse_string(&data, value);
+                    builder.add_tag(key, value);
+                    if (*data != ',') {
+                        break;
+                    }
+                    ++data;
+                }
+                if (!opl_is_field_end(*data)) {
+                    throw opl_error{"expected ','", data};
+                }
+            }
+
+            inline void opl_parse_way_nodes(const char* data, osmium::memory::Buffer& buffer, osmium::builder::WayBuilder* parent) {
+                osmium::builder::WayNodeListBuilder builder{buffer, parent};
+                while (!opl_is_field_end(*data)) {
+                    opl_parse_char(&data, 'n');
+                    const auto ref = opl_parse_int<osmium::object_id_type>(&data);
+                    osmium::Location location;
+                    if (*data == 'x') {
+                        ++data;
+                        if (*data != 'y') {
+                            location.set_x(opl_parse_coordinate(&data));
+                        }
+                        opl_parse_char(&data, 'y');
+                        if (!opl_is_string_end(*data)) {
+                            location.set_y(opl_parse_coordinate(&data));
+                        }
+                    }
+                    builder.add_node_ref(ref, location);
+                    if (*data != ',') {
+                        break;
+                    }
+                    ++data;
+                }
+                if (!opl_is_field_end(*data)) {
+                    throw opl_error{"expected ','", data};
+                }
+            }
+
+            inline void opl_parse_relation_members(const char* data, osmium::memory::Buffer& buffer, osmium::builder::RelationBuilder* parent, std::string& role) {
+                osmium::builder::RelationMemberListBuilder builder{buffer, parent};
+                while (!opl_is_field_end(*data)) {
+                    const auto type = osmium::char_to_item_type(*data);
+                    if (type != osmium::item_type::node && type != osmium::item_type::way && type != osmium::item_type::relation) {
+                        throw opl_error{"unknown member type", data};
+                    }
+                    ++data;
+                    const auto ref = opl_parse_int<osmium::object_id_type>(&data);
+                    opl_parse_char(&data, '@');
+                    role.clear();
+                    opl_parse_string(&data, role);
+                    builder.add_member(type, ref, role);
+                    if (*data != ',') {
+                        break;
+                    }
+                    ++data;
+                }
+                if (!opl_is_field_end(*data)) {
+                    throw opl_error{"expected ','", data};
+                }
+            }
+
+            /**
+             * Parses lines of OPL data into a buffer.
+             */
+            class OPLDecoder {
+
+                osmium::memory::Buffer& m_buffer;
+
+                // reused for all strings to avoid allocations
+                std::string m_user;
+                std::string m_key;
+                std::string m_value;
+
+                /**
+                 * Parse the attributes common to nodes, ways, and relations.
+                 * The user name is stored in m_user, pointers to the tags
+                 * and the other fields with lists are returned in the
+                 * arguments, because these can only be added to the buffer
+                 * after the user name. Attributes not handled here are
+                 * given to the callback.
+                 */
+                template <typename TFunc>
+                void parse_object_fields(const char* data, osmium::OSMObject& object, const char** tags, TFunc&& func) {
+                    m_user.clear();
+                    while (true) {
+                        opl_skip_space(&data);
+                        const char c = *data;
+                        if (c == '\0') {
+                            break;
+                        }
+                        ++data;
+                        switch (c) {
+                            case 'v':
+                                object.set_version(opl_parse_int<osmium::object_version_type>(&data));
+                                break;
+                            case 'd':
+                                if (*data == 'V') {
+                                    object.set_visible(true);
+                                } else if (*data == 'D') {
+                                    object.set_visible(false);
+                                } else {
+                                    throw opl_error{"invalid visible flag", data};
+                                }
+                                ++data;
+                                break;
+                            case 'c':
+                                object.set_changeset(opl_parse_uint32(&data));
+                                break;
+                            case 't':
+                                object.set_timestamp(opl_parse_timestamp(&data));
+                                break;
+                            case 'i':
+                                object.set_uid(opl_parse_uint32(&data));
+                                break;
+                            case 'u':
+                                opl_parse_string(&data, m_user);
+                                break;
+                            case 'T':
+                                *tags = data;
+                                opl_skip_field(&data);
+                                break;
+                            default:
+                                if (!std::forward<TFunc>(func)(c, &data)) {
+                                    throw opl_error{"unknown attribute", data - 1};
+                                }
+                        }
+                        if (!opl_is_field_end(*data)) {
+                            throw opl_error{"expected space", data};
+                        }
+                    }
+                }
+
+                void parse_node(const char* data) {
+                    {
+                        osmium::builder::NodeBuilder builder{m_buffer};
+                        osmium::Node& node = builder.object();
+                        node.set_id(opl_parse_int<osmium::object_id_type>(&data));
+
+                        const char* tags = nullptr;
+                        osmium::Location location;
+                        parse_object_fields(data, node, &tags, [&location](const char c, const char** str) {
+                            if (c == 'x') {
+                                opl_parse_x(str, location);
+                            } else if (c == 'y') {
+                                opl_parse_y(str, location);
+                            } else {
+                                return false;
+                            }
+                            return true;
+                        });
+                        node.set_location(location);
+
+                        builder.add_user(m_user);
+                        if (tags) {
+                            opl_parse_tags(tags, m_buffer, &builder, m_key, m_value);
+                        }
+                    }
+                    m_buffer.commit();
+                }
+
+                void parse_way(const char* data) {
+                    {
+                        osmium::builder::WayBuilder builder{m_buffer};
+                        osmium::Way& way = builder.object();
+                        way.set_id(opl_parse_int<osmium::object_id_type>(&data));
+
+                        const char* tags = nullptr;
+                        const char* nodes = nullptr;
+                        parse_object_fields(data, way, &tags, [&nodes](const char c, const char** str) {
+                            if (c != 'N') {
+                                return false;
+                            }
+                            nodes = *str;
+                            opl_skip_field(str);
+                            return true;
+                        });
+
+                        builder.add_user(m_user);
+                        if (tags) {
+                            opl_parse_tags(tags, m_buffer, &builder, m_key, m_value);
+                        }
+                        if (nodes) {
+                            opl_parse_way_nodes(nodes, m_buffer, &builder);
+                        }
+                    }
+                    m_buffer.commit();
+                }
+
+                void parse_relation(const char* data) {
+                    {
+                        osmium::builder::RelationBuilder builder{m_buffer};
+                        osmium::Relation& relation = builder.object();
+                        relation.set_id(opl_parse_int<osmium::object_id_type>(&data));
+
+                        const char* tags = nullptr;
+                        const char* members = nullptr;
+                        parse_object_fields(data, relation, &tags, [&members](const char c, const char** str) {
+                            if (c != 'M') {
+                                return false;
+                            }
+                            members = *str;
+                            opl_skip_field(str);
+                            return true;
+                        });
+
+                        builder.add_user(m_user);
+                        if (tags) {
+                            opl_parse_tags(tags, m_buffer, &builder, m_key, m_value);
+                        }
+                        if (members) {
+                            opl_parse_relation_members(members, m_buffer, &builder, m_value);
+                        }
+                    }
+                    m_buffer.commit();
+                }
+
+                void parse_changeset(const char* data) {
+                    {
+                        osmium::builder::ChangesetBuilder builder{m_buffer};
+                        osmium::Changeset& changeset = builder.object();
+                        changeset.set_id(opl_parse_uint32(&data));
+
+                        m_user.clear();
+                        const char* tags = nullptr;
+                        osmium::Location min;
+                        osmium::Location max;
+                        while (true) {
+                            opl_skip_space(&data);
+                            const char c = *data;
+                            if (c == '\0') {
+                                break;
+                            }
+                            ++data;
+                            switch (c) {
+                                case 'k':
+                                    changeset.set_num_changes(opl_parse_int<osmium::num_changes_type>(&data));
+                                    break;
+                                case 's':
+                                    changeset.set_created_at(opl_parse_timestamp(&data));
+                                    break;
+                                case 'e':
+                                    changeset.set_closed_at(opl_parse_timestamp(&data));
+                                    break;
+                                case 'd':
+                                    changeset.set_num_comments(opl_parse_int<osmium::num_comments_type>(&data));
+                                    break;
+                                case 'i':
+                                    changeset.set_uid(opl_parse_uint32(&data));
+                                    break;
+                                case 'u':
+                                    opl_parse_string(&data, m_user);
+                                    break;
+                                case 'x':
+                                    opl_parse_x(&data, min);
+                                    break;
+                                case 'y':
+                                    opl_parse_y(&data, min);
+                                    break;
+                                case 'X':
+                                    opl_parse_x(&data, max);
+                                    break;
+                                case 'Y':
+                                    opl_parse_y(&data, max);
+                                    break;
+                                case 'T':
+                                    tags = data;
+                                    opl_skip_field(&data);
+                                    break;
+                                default:
+                                    throw opl_error{"unknown attribute", data - 1};
+                            }
+                            if (!opl_is_field_end(*data)) {
+                                throw opl_error{"expected space", data};
+                            }
+                        }
+
+                        changeset.bounds().extend(min);
+                        changeset.bounds().extend(max);
+
+                        builder.add_user(m_user);
+                        if (tags) {
+                            opl_parse_tags(tags, m_buffer, &builder, m_key, m_value);
+                        }
+                    }
+                    m_buffer.commit();
+                }
+
+            public:
+
+                explicit OPLDecoder(osmium::memory::Buffer& buffer) :
+                    m_buffer(buffer),
+                    m_user(),
+                    m_key(),
+                    m_value() {
+                }
+
+                /**
+                 * Parse one line of OPL data. The line must be terminated
+                 * by a 0 byte instead of the newline. Empty lines and lines
+                 * starting with '#' are ignored.
+                 */
+                void parse_line(const char* data, osmium::osm_entity_bits::type read_types) {
+                    switch (*data) {
+                        case '\0':
+                        case '#':
+                            break;
+                        case 'n':
+                            if (read_types & osmium::osm_entity_bits::node) {
+                                parse_node(data + 1);
+                            }
+                            break;
+                        case 'w':
+                            if (read_types & osmium::osm_entity_bits::way) {
+                                parse_way(data + 1);
+                            }
+                            break;
+                        case 'r':
+                            if (read_types & osmium::osm_entity_bits::relation) {
+                                parse_relation(data + 1);
+                            }
+                            break;
+                        case 'c':
+                            if (read_types & osmium::osm_entity_bits::changeset) {
+                                parse_changeset(data + 1);
+                            }
+                            break;
+                        default:
+                            throw opl_error{"unknown object type", data};
+                    }
+                }
+
+            }; // class OPLDecoder
+
+            /**
+             * Decodes a chunk of OPL data consisting of complete lines.
+             * This runs as a task in the thread pool.
+             */
+            class OPLChunkDecoder {
+
+                std::string m_data;
+                osmium::osm_entity_bits::type m_read_types;
+
+            public:
+
+                OPLChunkDecoder(std::string&& data, osmium::osm_entity_bits::type read_types) :
+                    m_data(std::move(data)),
+                    m_read_types(read_types) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    // The buffer grows if needed, OPL data is usually
+                    // somewhat larger than the buffer contents.
+                    const auto align = osmium::memory::align_bytes;
+                    osmium::memory::Buffer buffer{(m_data.size() + align) / align * align, osmium::memory::Buffer::auto_grow::yes};
+                    OPLDecoder decoder{buffer};
+
+                    char* line = &m_data[0];
+                    char* const end = line + m_data.size();
+                    while (line < end) {
+                        char* eol = static_cast<char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+                        if (!eol) {
+                            eol = end;
+                        }
+                        *eol = '\0';
+                        if (eol != line && eol[-1] == '\r') {
+                            eol[-1] = '\0';
+                        }
+                        decoder.parse_line(line, m_read_types);
+                        line = eol + 1;
+                    }
+
+                    return buffer;
+                }
+
+            }; // class OPLChunkDecoder
+
+            class OPLParser : public Parser {
+
+                /**
+                 * Size of the chunks of OPL data handed to the pool threads.
+                 */
+                static constexpr size_t chunk_size = 4 * 1000 * 1000;
+
+                void submit_chunk(std::string&& data) {
+                    const auto estimated_size = data.size();
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(OPLChunkDecoder{std::move(data), read_types()}, osmium::thread::task_priority::high), estimated_size);
+                }
+
+            public:
+
+                OPLParser(future_string_queue_type& input_queue,
+                          future_buffer_queue_type& output_queue,
+                          std::promise<osmium::io::Header>& header_promise,
+                          osmium::osm_entity_bits::type read_types) :
+                    Parser(input_queue, output_queue, header_promise, read_types) {
+                }
+
+                ~OPLParser() noexcept final = default;
+
+                /**
+                 * OPL files have no header. The input is cut into chunks at
+                 * the end of lines and the chunks are parsed on the thread
+                 * pool. The results are queued in order.
+                 */
+                void run() final {
+                    osmium::thread::set_thread_name("_osmium_opl_in");
+
+                    set_header_value(osmium::io::Header{});
+
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    std::string data;
+                    while (!input_done()) {
+                        data += get_input();
+                        if (data.size() >= chunk_size) {
+                            const auto pos = data.rfind('\n');
+                            if (pos != std::string::npos) {
+                                std::string rest{data.substr(pos + 1)};
+                                data.resize(pos + 1);
+
+                                using std::swap;
+                                swap(data, rest);
+
+                                submit_chunk(std::move(rest));
+                            }
+                        }
+                    }
+
+                    if (!data.empty()) {
+                        submit_chunk(std::move(data));
+                    }
+                }
+
+            }; // class OPLParser
+
+            // we want the register_parser() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_opl_parser = ParserFactory::instance().register_parser(
+                file_format::opl,
+                [](future_string_queue_type& input_queue,
+                    future_buffer_queue_type& output_queue,
+                    std::promise<osmium::io::Header>& header_promise,
+                    osmium::osm_entity_bits::type read_which_entities) {
+                    return std::unique_ptr<Parser>(new OPLParser(input_queue, output_queue, header_promise, read_which_entities));
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_opl_parser() noexcept {
+                return registered_opl_parser;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_OPL_INPUT_FORMAT_HPP
@@ -259,7 +259,8 @@ namespace osmium {
                 ~OPLOutputFormat() noexcept final = default;
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(osmium::thread::Pool::instance().submit(OPLOutputBlock{std::move(buffer), m_options}));
+                    const auto size = buffer.committed();
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(OPLOutputBlock{std::move(buffer), m_options}), size);
                 }
 
             }; // class OPLOutputFormat
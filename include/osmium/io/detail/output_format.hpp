@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <stdexcept>
@@ -98,6 +99,19 @@ namespace osmium {
                     add_to_queue(m_output_queue, std::move(data));
                 }
 
+                /**
+                 * Add data that is still being worked on to the output
+                 * queue.
+                 *
+                 * @param future Future for the data.
+                 * @param estimated_size Estimated size of the data in bytes,
+                 *                       used for limiting the memory use
+                 *                       of the queue.
+                 */
+                void send_to_output_queue(std::future<std::string>&& future, size_t estimated_size = 0) {
+                    m_output_queue.push(std::move(future), estimated_size);
+                }
+
             public:
 
                 explicit OutputFormat(future_string_queue_type& output_queue) :
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -41,20 +42,27 @@ DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <protozero/exception.hpp>
 #include <protozero/pbf_message.hpp>
+#include <protozero/varint.hpp>
 
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/lz4.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_filter.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#include <osmium/io/detail/zstd.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/util/cast.hpp>
 #include <osmium/util/delta.hpp>
@@ -70,8 +78,12 @@ namespace osmium {
 
             class PBFPrimitiveBlockDecoder {
 
+            public:
+
                 static constexpr size_t initial_buffer_size = 2 * 1024 * 1024;
 
+            private:
+
                 ptr_len_type m_data;
                 std::vector<osm_string_len_type> m_stringtable;
 
@@ -82,7 +94,33 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer { initial_buffer_size };
+                osmium::memory::Buffer m_buffer;
+
+                // Only objects matching this filter are decoded.
+                read_filter m_filter;
+
+                // Results of the tag filter for pairs of key and value
+                // indexes into the string table of this block.
+                std::unordered_map<uint64_t, bool> m_tag_filter_results;
+
+                // Buffer for null-terminated copies of key and value passed
+                // to the tag filter.
+                std::string m_tag_buffer;
+
+                // Decoded packed fields. These are kept between objects so
+                // that their memory can be reused for the whole block.
+                std::vector<int64_t> m_ids;
+                std::vector<int64_t> m_lats;
+                std::vector<int64_t> m_lons;
+                std::vector<int32_t> m_roles;
+                std::vector<int32_t> m_types;
+                std::vector<int32_t> m_tags;
+                std::vector<int32_t> m_versions;
+                std::vector<int64_t> m_timestamps;
+                std::vector<int64_t> m_changesets;
+                std::vector<int32_t> m_uids;
+                std::vector<int32_t> m_user_sids;
+                std::vector<int32_t> m_visibles;
 
                 void decode_stringtable(const ptr_len_type& data) {
                     if (!m_stringtable.empty()) {
@@ -228,6 +266,90 @@ namespace osmium {
                     }
                 }
 
+                bool tag_matches(uint32_t key, uint32_t value) {
+                    const uint64_t id = (uint64_t(key) << 32) | value;
+                    const auto it = m_tag_filter_results.find(id);
+                    if (it != m_tag_filter_results.end()) {
+                        return it->second;
+                    }
+
+                    // The strings in the string table are not null-terminated,
+                    // so key and value are copied into a buffer that is reused
+                    // for all calls.
+                    const auto& k = m_stringtable.at(key);
+                    const auto& v = m_stringtable.at(value);
+                    m_tag_buffer.assign(k.first, k.second);
+                    m_tag_buffer += '\0';
+                    m_tag_buffer.append(v.first, v.second);
+                    const char* data = m_tag_buffer.data();
+                    const bool result = (*m_filter.tags)(data, data + k.second + 1);
+                    m_tag_filter_results.emplace(id, result);
+                    return result;
+                }
+
+                bool tags_match(const kv_type& keys, const kv_type& vals) {
+                    auto vit = vals.first;
+                    for (auto kit = keys.first; kit != keys.second && vit != vals.second; ++kit, ++vit) {
+                        if (tag_matches(*kit, *vit)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                /**
+                 * Check the ID and tags of a way or relation against the
+                 * filter without decoding the rest of the message.
+                 */
+                template <typename T>
+                bool object_matches(const ptr_len_type& data, T id_tag, T keys_tag, T vals_tag) {
+                    osmium::object_id_type id = 0;
+                    kv_type keys;
+                    kv_type vals;
+
+                    protozero::pbf_message<T> pbf_object(data);
+                    while (pbf_object.next()) {
+                        if (pbf_object.tag() == id_tag) {
+                            id = pbf_object.get_int64();
+                        } else if (pbf_object.tag() == keys_tag) {
+                            keys = pbf_object.get_packed_uint32();
+                        } else if (pbf_object.tag() == vals_tag) {
+                            vals = pbf_object.get_packed_uint32();
+                        } else {
+                            pbf_object.skip();
+                        }
+                    }
+
+                    return m_filter.id_matches(id) &&
+                           (!m_filter.has_tags() || tags_match(keys, vals));
+                }
+
+                template <typename TIterator>
+                bool dense_tags_match(TIterator it, TIterator end) {
+                    while (it != end && *it != 0) {
+                        const auto key = *it++;
+                        if (it == end) {
+                            throw osmium::pbf_error("PBF format error"); // this is against the spec, keys/vals must come in pairs
+                        }
+                        if (tag_matches(static_cast<uint32_t>(key), static_cast<uint32_t>(*it++))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                template <typename TIterator>
+                bool dense_node_matches(osmium::object_id_type id, int64_t lon, int64_t lat, bool visible, TIterator tag_it, TIterator tag_end) {
+                    if (!m_filter.id_matches(id)) {
+                        return false;
+                    }
+                    if (m_filter.has_box() &&
+                        !(visible && m_filter.location_matches(osmium::Location(convert_pbf_coordinate(lon), convert_pbf_coordinate(lat))))) {
+                        return false;
+                    }
+                    return !m_filter.has_tags() || dense_tags_match(tag_it, tag_end);
+                }
+
                 int32_t convert_pbf_coordinate(int64_t c) const {
                     return int32_t((c * m_granularity + m_lon_offset) / resolution_convert);
                 }
@@ -280,6 +402,15 @@ namespace osmium {
                         ));
                     }
 
+                    if (!m_filter.empty()) {
+                        if (!m_filter.id_matches(node.id()) ||
+                            !m_filter.location_matches(node.location()) ||
+                            (m_filter.has_tags() && !tags_match(keys, vals))) {
+                            m_buffer.rollback();
+                            return;
+                        }
+                    }
+
                     builder.add_user(user.first, user.second);
 
                     build_tag_list(builder, keys, vals);
@@ -288,13 +419,21 @@ namespace osmium {
                 }
 
                 void decode_way(const ptr_len_type& data) {
+                    if (!m_filter.empty() &&
+                        !object_matches(data,
+                                        OSMFormat::Way::required_int64_id,
+                                        OSMFormat::Way::packed_uint32_keys,
+                                        OSMFormat::Way::packed_uint32_vals)) {
+                        return;
+                    }
+
                     osmium::builder::WayBuilder builder(m_buffer);
 
                     kv_type keys;
                     kv_type vals;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> refs;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> lats;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> lons;
+                    m_ids.clear();
+                    m_lats.clear();
+                    m_lons.clear();
 
                     osm_string_len_type user = { "", 0 };
 
@@ -314,13 +453,13 @@ namespace osmium {
                                 user = decode_info(pbf_way.get_data(), builder.object());
                                 break;
                             case OSMFormat::Way::packed_sint64_refs:
-                                refs = pbf_way.get_packed_sint64();
+                                pbf_way.get_packed_sint64(m_ids);
                                 break;
                             case OSMFormat::Way::packed_sint64_lat:
-                                lats = pbf_way.get_packed_sint64();
+                                pbf_way.get_packed_sint64(m_lats);
                                 break;
                             case OSMFormat::Way::packed_sint64_lon:
-                                lons = pbf_way.get_packed_sint64();
+                                pbf_way.get_packed_sint64(m_lons);
                                 break;
                             default:
                                 pbf_way.skip();
@@ -329,21 +468,22 @@ namespace osmium {
 
                     builder.add_user(user.first, user.second);
 
-                    if (refs.first != refs.second) {
+                    if (!m_ids.empty()) {
                         osmium::builder::WayNodeListBuilder wnl_builder(m_buffer, &builder);
                         osmium::util::DeltaDecode<int64_t> ref;
-                        if (lats.first == lats.second) {
-                            while (refs.first != refs.second) {
-                                wnl_builder.add_node_ref(ref.update(*refs.first++));
+                        if (m_lats.empty()) {
+                            for (const auto id : m_ids) {
+                                wnl_builder.add_node_ref(ref.update(id));
                             }
                         } else {
                             osmium::util::DeltaDecode<int64_t> lon;
                             osmium::util::DeltaDecode<int64_t> lat;
-                            while (refs.first != refs.second && lons.first != lons.second && lats.first != lats.second) {
+                            const auto size = std::min({m_ids.size(), m_lons.size(), m_lats.size()});
+                            for (std::size_t i = 0; i < size; ++i) {
                                 wnl_builder.add_node_ref(
-                                    ref.update(*refs.first++),
-                                    osmium::Location{convert_pbf_coordinate(lon.update(*lons.first++)),
-                                                     convert_pbf_coordinate(lat.update(*lats.first++))}
+                                    ref.update(m_ids[i]),
+                                    osmium::Location{convert_pbf_coordinate(lon.update(m_lons[i])),
+                                                     convert_pbf_coordinate(lat.update(m_lats[i]))}
                                 );
                             }
                         }
@@ -355,13 +495,21 @@ namespace osmium {
                 }
 
                 void decode_relation(const ptr_len_type& data) {
+                    if (!m_filter.empty() &&
+                        !object_matches(data,
+                                        OSMFormat::Relation::required_int64_id,
+                                        OSMFormat::Relation::packed_uint32_keys,
+                                        OSMFormat::Relation::packed_uint32_vals)) {
+                        return;
+                    }
+
                     osmium::builder::RelationBuilder builder(m_buffer);
 
                     kv_type keys;
                     kv_type vals;
-                    std::pair<protozero::pbf_reader::const_int32_iterator,  protozero::pbf_reader::const_int32_iterator> roles;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> refs;
-                    std::pair<protozero::pbf_reader::const_int32_iterator,  protozero::pbf_reader::const_int32_iterator> types;
+                    m_roles.clear();
+                    m_ids.clear();
+                    m_types.clear();
 
                     osm_string_len_type user = { "", 0 };
 
@@ -381,13 +529,13 @@ namespace osmium {
                                 user = decode_info(pbf_relation.get_data(), builder.object());
                                 break;
                             case OSMFormat::Relation::packed_int32_roles_sid:
-                                roles = pbf_relation.get_packed_int32();
+                                pbf_relation.get_packed_int32(m_roles);
                                 break;
                             case OSMFormat::Relation::packed_sint64_memids:
-                                refs = pbf_relation.get_packed_sint64();
+                                pbf_relation.get_packed_sint64(m_ids);
                                 break;
                             case OSMFormat::Relation::packed_MemberType_types:
-                                types = pbf_relation.get_packed_enum();
+                                pbf_relation.get_packed_enum(m_types);
                                 break;
                             default:
                                 pbf_relation.skip();
@@ -396,18 +544,19 @@ namespace osmium {
 
                     builder.add_user(user.first, user.second);
 
-                    if (refs.first != refs.second) {
+                    if (!m_ids.empty()) {
                         osmium::builder::RelationMemberListBuilder rml_builder(m_buffer, &builder);
                         osmium::util::DeltaDecode<int64_t> ref;
-                        while (roles.first != roles.second && refs.first != refs.second && types.first != types.second) {
-                            const auto& r = m_stringtable.at(*roles.first++);
-                            int type = *types.first++;
+                        const auto size = std::min({m_roles.size(), m_ids.size(), m_types.size()});
+                        for (std::size_t i = 0; i < size; ++i) {
+                            const auto& r = m_stringtable.at(m_roles[i]);
+                            int type = m_types[i];
                             if (type < 0 || type > 2) {
                                 throw osmium::pbf_error("unknown relation member type");
                             }
                             rml_builder.add_member(
                                 osmium::item_type(type + 1),
-                                ref.update(*refs.first++),
+                                ref.update(m_ids[i]),
                                 r.first,
                                 r.second
                             );
@@ -423,24 +572,22 @@ namespace osmium {
                     bool has_info     = false;
                     bool has_visibles = false;
 
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> ids;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> lats;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> lons;
-
-                    std::pair<protozero::pbf_reader::const_int32_iterator,  protozero::pbf_reader::const_int32_iterator>  tags;
-
-                    std::pair<protozero::pbf_reader::const_int32_iterator,  protozero::pbf_reader::const_int32_iterator>  versions;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> timestamps;
-                    std::pair<protozero::pbf_reader::const_sint64_iterator, protozero::pbf_reader::const_sint64_iterator> changesets;
-                    std::pair<protozero::pbf_reader::const_sint32_iterator, protozero::pbf_reader::const_sint32_iterator> uids;
-                    std::pair<protozero::pbf_reader::const_sint32_iterator, protozero::pbf_reader::const_sint32_iterator> user_sids;
-                    std::pair<protozero::pbf_reader::const_int32_iterator,  protozero::pbf_reader::const_int32_iterator>  visibles;
+                    m_ids.clear();
+                    m_lats.clear();
+                    m_lons.clear();
+                    m_tags.clear();
+                    m_versions.clear();
+                    m_timestamps.clear();
+                    m_changesets.clear();
+                    m_uids.clear();
+                    m_user_sids.clear();
+                    m_visibles.clear();
 
                     protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes(data);
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag()) {
                             case OSMFormat::DenseNodes::packed_sint64_id:
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                pbf_dense_nodes.get_packed_sint64(m_ids);
                                 break;
                             case OSMFormat::DenseNodes::optional_DenseInfo_denseinfo:
                                 {
@@ -449,23 +596,23 @@ namespace osmium {
                                     while (pbf_dense_info.next()) {
                                         switch (pbf_dense_info.tag()) {
                                             case OSMFormat::DenseInfo::packed_int32_version:
-                                                versions = pbf_dense_info.get_packed_int32();
+                                                pbf_dense_info.get_packed_int32(m_versions);
                                                 break;
                                             case OSMFormat::DenseInfo::packed_sint64_timestamp:
-                                                timestamps = pbf_dense_info.get_packed_sint64();
+                                                pbf_dense_info.get_packed_sint64(m_timestamps);
                                                 break;
                                             case OSMFormat::DenseInfo::packed_sint64_changeset:
-                                                changesets = pbf_dense_info.get_packed_sint64();
+                                                pbf_dense_info.get_packed_sint64(m_changesets);
                                                 break;
                                             case OSMFormat::DenseInfo::packed_sint32_uid:
-                                                uids = pbf_dense_info.get_packed_sint32();
+                                                pbf_dense_info.get_packed_sint32(m_uids);
                                                 break;
                                             case OSMFormat::DenseInfo::packed_sint32_user_sid:
-                                                user_sids = pbf_dense_info.get_packed_sint32();
+                                                pbf_dense_info.get_packed_sint32(m_user_sids);
                                                 break;
                                             case OSMFormat::DenseInfo::packed_bool_visible:
                                                 has_visibles = true;
-                                                visibles = pbf_dense_info.get_packed_bool();
+                                                pbf_dense_info.get_packed_bool(m_visibles);
                                                 break;
                                             default:
                                                 pbf_dense_info.skip();
@@ -474,19 +621,39 @@ namespace osmium {
                                 }
                                 break;
                             case OSMFormat::DenseNodes::packed_sint64_lat:
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                pbf_dense_nodes.get_packed_sint64(m_lats);
                                 break;
                             case OSMFormat::DenseNodes::packed_sint64_lon:
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                pbf_dense_nodes.get_packed_sint64(m_lons);
                                 break;
                             case OSMFormat::DenseNodes::packed_int32_keys_vals:
-                                tags = pbf_dense_nodes.get_packed_int32();
+                                pbf_dense_nodes.get_packed_int32(m_tags);
                                 break;
                             default:
                                 pbf_dense_nodes.skip();
                         }
                     }
 
+                    const std::size_t count = m_ids.size();
+
+                    if (m_lons.size() < count ||
+                        m_lats.size() < count) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error("PBF format error");
+                    }
+
+                    if (has_info) {
+                        if (m_versions.size() < count ||
+                            m_changesets.size() < count ||
+                            m_timestamps.size() < count ||
+                            m_uids.size() < count ||
+                            m_user_sids.size() < count ||
+                            (has_visibles && m_visibles.size() < count)) {
+                            // this is against the spec, must have same number of elements
+                            throw osmium::pbf_error("PBF format error");
+                        }
+                    }
+
                     osmium::util::DeltaDecode<int64_t> dense_id;
                     osmium::util::DeltaDecode<int64_t> dense_latitude;
                     osmium::util::DeltaDecode<int64_t> dense_longitude;
@@ -495,13 +662,36 @@ namespace osmium {
                     osmium::util::DeltaDecode<int64_t> dense_changeset;
                     osmium::util::DeltaDecode<int64_t> dense_timestamp;
 
-                    auto tag_it = tags.first;
+                    auto tag_it = m_tags.cbegin();
+                    const auto tag_end = m_tags.cend();
 
-                    while (ids.first != ids.second) {
-                        if (lons.first == lons.second ||
-                            lats.first == lats.second) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error("PBF format error");
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const auto id = dense_id.update(m_ids[i]);
+
+                        // even if the node isn't visible, there's still a record
+                        // of its lat/lon in the dense arrays.
+                        const auto lon = dense_longitude.update(m_lons[i]);
+                        const auto lat = dense_latitude.update(m_lats[i]);
+
+                        if (!m_filter.empty()) {
+                            const bool visible = !(has_visibles && m_visibles[i] == 0);
+                            if (!dense_node_matches(id, lon, lat, visible, tag_it, tag_end)) {
+                                // skip this node, but keep the delta decoding
+                                // of all fields in sync
+                                if (has_info) {
+                                    dense_changeset.update(m_changesets[i]);
+                                    dense_timestamp.update(m_timestamps[i]);
+                                    dense_uid.update(m_uids[i]);
+                                    dense_user_sid.update(m_user_sids[i]);
+                                }
+                                while (tag_it != tag_end && *tag_it != 0) {
+                                    ++tag_it;
+                                }
+                                if (tag_it != tag_end) {
+                                    ++tag_it;
+                                }
+                                continue;
+                            }
                         }
 
                         bool visible = true;
@@ -509,52 +699,35 @@ namespace osmium {
                         osmium::builder::NodeBuilder builder(m_buffer);
                         osmium::Node& node = builder.object();
 
-                        node.set_id(dense_id.update(*ids.first++));
+                        node.set_id(id);
 
                         if (has_info) {
-                            if (versions.first == versions.second ||
-                                changesets.first == changesets.second ||
-                                timestamps.first == timestamps.second ||
-                                uids.first == uids.second ||
-                                user_sids.first == user_sids.second) {
-                                // this is against the spec, must have same number of elements
-                                throw osmium::pbf_error("PBF format error");
-                            }
-
-                            auto version = *versions.first++;
+                            auto version = m_versions[i];
                             if (version < 0) {
                                 throw osmium::pbf_error("object version must not be negative");
                             }
                             node.set_version(static_cast<osmium::object_version_type>(version));
 
-                            auto changeset_id = dense_changeset.update(*changesets.first++);
+                            auto changeset_id = dense_changeset.update(m_changesets[i]);
                             if (changeset_id < 0) {
                                 throw osmium::pbf_error("object changeset_id must not be negative");
                             }
                             node.set_changeset(static_cast<osmium::changeset_id_type>(changeset_id));
 
-                            node.set_timestamp(dense_timestamp.update(*timestamps.first++) * m_date_factor / 1000);
-                            node.set_uid_from_signed(static_cast<osmium::signed_user_id_type>(dense_uid.update(*uids.first++)));
+                            node.set_timestamp(dense_timestamp.update(m_timestamps[i]) * m_date_factor / 1000);
+                            node.set_uid_from_signed(static_cast<osmium::signed_user_id_type>(dense_uid.update(m_uids[i])));
 
                             if (has_visibles) {
-                                if (visibles.first == visibles.second) {
-                                    // this is against the spec, must have same number of elements
-                                    throw osmium::pbf_error("PBF format error");
-                                }
-                                visible = (*visibles.first++) != 0;
+                                visible = m_visibles[i] != 0;
                             }
                             node.set_visible(visible);
 
-                            const auto& u = m_stringtable.at(dense_user_sid.update(*user_sids.first++));
+                            const auto& u = m_stringtable.at(dense_user_sid.update(m_user_sids[i]));
                             builder.add_user(u.first, u.second);
                         } else {
                             builder.add_user("");
                         }
 
-                        // even if the node isn't visible, there's still a record
-                        // of its lat/lon in the dense arrays.
-                        const auto lon = dense_longitude.update(*lons.first++);
-                        const auto lat = dense_latitude.update(*lats.first++);
                         if (visible) {
                             builder.object().set_location(osmium::Location(
                                     convert_pbf_coordinate(lon),
@@ -562,18 +735,18 @@ namespace osmium {
                             ));
                         }
 
-                        if (tag_it != tags.second) {
+                        if (tag_it != tag_end) {
                             osmium::builder::TagListBuilder tl_builder(m_buffer, &builder);
-                            while (tag_it != tags.second && *tag_it != 0) {
+                            while (tag_it != tag_end && *tag_it != 0) {
                                 const auto& k = m_stringtable.at(*tag_it++);
-                                if (tag_it == tags.second) {
+                                if (tag_it == tag_end) {
                                     throw osmium::pbf_error("PBF format error"); // this is against the spec, keys/vals must come in pairs
                                 }
                                 const auto& v = m_stringtable.at(*tag_it++);
                                 tl_builder.add_tag(k.first, k.second, v.first, v.second);
                             }
 
-                            if (tag_it != tags.second) {
+                            if (tag_it != tag_end) {
                                 ++tag_it;
                             }
                         }
@@ -587,7 +760,50 @@ namespace osmium {
 
                 PBFPrimitiveBlockDecoder(const ptr_len_type& data, osmium::osm_entity_bits::type read_types) :
                     m_data(data),
-                    m_read_types(read_types) {
+                    m_read_types(read_types),
+                    m_buffer(initial_buffer_size),
+                    m_filter(),
+                    m_tag_filter_results(),
+                    m_tag_buffer(),
+                    m_ids(),
+                    m_lats(),
+                    m_lons(),
+                    m_roles(),
+                    m_types(),
+                    m_tags(),
+                    m_versions(),
+                    m_timestamps(),
+                    m_changesets(),
+                    m_uids(),
+                    m_user_sids(),
+                    m_visibles() {
+                }
+
+                /**
+                 * Construct a decoder that adds the decoded objects to the
+                 * given (usually recycled) buffer. The buffer must be empty
+                 * and auto-growing.
+                 */
+                PBFPrimitiveBlockDecoder(const ptr_len_type& data, osmium::osm_entity_bits::type read_types, osmium::memory::Buffer&& buffer) :
+                    m_data(data),
+                    m_read_types(read_types),
+                    m_buffer(std::move(buffer)),
+                    m_filter(),
+                    m_tag_filter_results(),
+                    m_tag_buffer(),
+                    m_ids(),
+                    m_lats(),
+                    m_lons(),
+                    m_roles(),
+                    m_types(),
+                    m_tags(),
+                    m_versions(),
+                    m_timestamps(),
+                    m_changesets(),
+                    m_uids(),
+                    m_user_sids(),
+                    m_visibles() {
+                    assert(m_buffer.committed() == 0);
                 }
 
                 PBFPrimitiveBlockDecoder(const PBFPrimitiveBlockDecoder&) = delete;
@@ -598,6 +814,16 @@ namespace osmium {
 
                 ~PBFPrimitiveBlockDecoder() noexcept = default;
 
+                /**
+                 * Only decode objects matching the filter. IDs and
+                 * locations are checked before any objects are built. The
+                 * tag predicate is evaluated only once for each combination
+                 * of key and value in the string table.
+                 */
+                void set_filter(const read_filter& filter) {
+                    m_filter = filter;
+                }
+
                 osmium::memory::Buffer operator()() {
                     try {
                         decode_primitive_block_metadata();
@@ -611,9 +837,43 @@ namespace osmium {
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline ptr_len_type decode_blob(const std::string& blob_data, std::string& output) {
+            /**
+             * Decode the BlobHeader. Make sure it contains the expected
+             * type. Return the size of the following Blob.
+             */
+            inline size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
+                std::pair<const char*, size_t> blob_header_type;
+                size_t blob_header_datasize = 0;
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag()) {
+                        case FileFormat::BlobHeader::required_string_type:
+                            blob_header_type = pbf_blob_header.get_data();
+                            break;
+                        case FileFormat::BlobHeader::required_int32_datasize:
+                            blob_header_datasize = pbf_blob_header.get_int32();
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (blob_header_datasize == 0) {
+                    throw osmium::pbf_error("PBF format error: BlobHeader.datasize missing or zero.");
+                }
+
+                if (strncmp(expected_type, blob_header_type.first, blob_header_type.second)) {
+                    throw osmium::pbf_error("blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)");
+                }
+
+                return blob_header_datasize;
+            }
+
+            inline ptr_len_type decode_blob(const ptr_len_type& blob_data, std::string& output) {
                 int32_t raw_size = 0;
                 std::pair<const char*, protozero::pbf_length_type> zlib_data = {nullptr, 0};
+                std::pair<const char*, protozero::pbf_length_type> lz4_data = {nullptr, 0};
+                std::pair<const char*, protozero::pbf_length_type> zstd_data = {nullptr, 0};
 
                 protozero::pbf_message<FileFormat::Blob> pbf_blob(blob_data);
                 while (pbf_blob.next()) {
@@ -637,6 +897,12 @@ namespace osmium {
                             break;
                         case FileFormat::Blob::optional_bytes_lzma_data:
                             throw osmium::pbf_error("lzma blobs not implemented");
+                        case FileFormat::Blob::optional_bytes_lz4_data:
+                            lz4_data = pbf_blob.get_data();
+                            break;
+                        case FileFormat::Blob::optional_bytes_zstd_data:
+                            zstd_data = pbf_blob.get_data();
+                            break;
                         default:
                             throw osmium::pbf_error("unknown compression");
                     }
@@ -651,9 +917,232 @@ namespace osmium {
                     );
                 }
 
+                if (lz4_data.second != 0 && raw_size != 0) {
+                    if (!lz4_available()) {
+                        throw osmium::pbf_error("lz4 blobs not supported (compile with OSMIUM_WITH_LZ4)");
+                    }
+                    return osmium::io::detail::lz4_uncompress_string(
+                        lz4_data.first,
+                        lz4_data.second,
+                        static_cast<size_t>(raw_size),
+                        output
+                    );
+                }
+
+                if (zstd_data.second != 0 && raw_size != 0) {
+                    if (!zstd_available()) {
+                        throw osmium::pbf_error("zstd blobs not supported (compile with OSMIUM_WITH_ZSTD)");
+                    }
+                    return osmium::io::detail::zstd_uncompress_string(
+                        zstd_data.first,
+                        zstd_data.second,
+                        static_cast<size_t>(raw_size),
+                        output
+                    );
+                }
+
                 throw osmium::pbf_error("blob contains no data");
             }
 
+            inline ptr_len_type decode_blob(const std::string& blob_data, std::string& output) {
+                return decode_blob(ptr_len_type{blob_data.data(), blob_data.size()}, output);
+            }
+
+            // Reads bytes from memory for first_group_type().
+            class pbf_memory_byte_reader {
+
+                const char* m_ptr;
+                const char* m_end;
+
+            public:
+
+                explicit pbf_memory_byte_reader(const ptr_len_type& data) noexcept :
+                    m_ptr(data.first),
+                    m_end(data.first + data.second) {
+                }
+
+                bool get(unsigned char& byte) noexcept {
+                    if (m_ptr == m_end) {
+                        return false;
+                    }
+                    byte = static_cast<unsigned char>(*m_ptr++);
+                    return true;
+                }
+
+                bool skip(uint64_t size) noexcept {
+                    if (uint64_t(m_end - m_ptr) < size) {
+                        return false;
+                    }
+                    m_ptr += size;
+                    return true;
+                }
+
+            }; // class pbf_memory_byte_reader
+
+            template <typename TReader>
+            inline bool read_varint_from(TReader& reader, uint64_t& value) {
+                value = 0;
+                for (unsigned int shift = 0; shift < 64; shift += 7) {
+                    unsigned char byte;
+                    if (!reader.get(byte)) {
+                        return false;
+                    }
+                    value |= uint64_t(byte & 0x7fu) << shift;
+                    if ((byte & 0x80u) == 0) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Get the type of the objects in the first PrimitiveGroup of a
+             * PrimitiveBlock read from the reader. All fields before the
+             * first group (usually the StringTable) are skipped over.
+             *
+             * @tparam TReader Class with functions bool get(unsigned char&)
+             *                 and bool skip(uint64_t) returning false if
+             *                 there is not enough data.
+             * @returns The type or osmium::osm_entity_bits::nothing if it
+             *          can not be found in the data.
+             */
+            template <typename TReader>
+            inline osmium::osm_entity_bits::type first_group_type(TReader& reader) {
+                uint64_t key;
+                while (read_varint_from(reader, key)) {
+                    switch (key & 0x07) {
+                        case 0: // varint
+                            {
+                                uint64_t value;
+                                if (!read_varint_from(reader, value)) {
+                                    return osmium::osm_entity_bits::nothing;
+                                }
+                            }
+                            break;
+                        case 2: // length-delimited
+                            {
+                                uint64_t length;
+                                if (!read_varint_from(reader, length)) {
+                                    return osmium::osm_entity_bits::nothing;
+                                }
+                                if (protozero::pbf_tag_type(key >> 3) == protozero::pbf_tag_type(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup) && length > 0) {
+                                    uint64_t group_key;
+                                    if (!read_varint_from(reader, group_key)) {
+                                        return osmium::osm_entity_bits::nothing;
+                                    }
+                                    switch (static_cast<OSMFormat::PrimitiveGroup>(group_key >> 3)) {
+                                        case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                                        case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                                            return osmium::osm_entity_bits::node;
+                                        case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                                            return osmium::osm_entity_bits::way;
+                                        case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                                            return osmium::osm_entity_bits::relation;
+                                        case OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets:
+                                            return osmium::osm_entity_bits::changeset;
+                                        default:
+                                            return osmium::osm_entity_bits::nothing;
+                                    }
+                                }
+                                if (!reader.skip(length)) {
+                                    return osmium::osm_entity_bits::nothing;
+                                }
+                            }
+                            break;
+                        default:
+                            return osmium::osm_entity_bits::nothing;
+                    }
+                }
+
+                return osmium::osm_entity_bits::nothing;
+            }
+
+            /**
+             * Get the type of the objects in the first PrimitiveGroup of a
+             * PrimitiveBlock. The data can be just the beginning of the
+             * block, only as much is decoded as is needed.
+             *
+             * @param data Complete PrimitiveBlock or a prefix of it.
+             * @returns The type or osmium::osm_entity_bits::nothing if it
+             *          can not be found in the data.
+             */
+            inline osmium::osm_entity_bits::type get_first_group_type(const ptr_len_type& data) {
+                pbf_memory_byte_reader reader{data};
+                return first_group_type(reader);
+            }
+
+            /**
+             * Get the type of the objects in the first PrimitiveGroup of
+             * the PrimitiveBlock in a blob. For zlib compressed blobs only
+             * the beginning of the blob is uncompressed (and not stored),
+             * so this is much cheaper than decoding the whole blob. Blobs
+             * with other compressions are uncompressed completely into
+             * output, the uncompressed data is returned in data, so that
+             * it can be used for decoding the blob.
+             *
+             * @param blob_data Input data
+             * @param output Buffer for uncompressed data.
+             * @param data Set to the uncompressed data if the blob was
+             *             uncompressed completely, unchanged otherwise.
+             * @returns The type or osmium::osm_entity_bits::nothing if the
+             *          block doesn't contain any groups.
+             * @throws osmium::pbf_error If the blob can not be decoded.
+             */
+            inline osmium::osm_entity_bits::type peek_blob_first_group_type(const ptr_len_type& blob_data, std::string& output, ptr_len_type& data) {
+                int32_t raw_size = 0;
+                std::pair<const char*, protozero::pbf_length_type> zlib_data = {nullptr, 0};
+
+                protozero::pbf_message<FileFormat::Blob> pbf_blob(blob_data);
+                while (pbf_blob.next()) {
+                    switch (pbf_blob.tag()) {
+                        case FileFormat::Blob::optional_int32_raw_size:
+                            raw_size = pbf_blob.get_int32();
+                            break;
+                        case FileFormat::Blob::optional_bytes_zlib_data:
+                            zlib_data = pbf_blob.get_data();
+                            break;
+                        default:
+                            pbf_blob.skip();
+                    }
+                }
+
+                if (zlib_data.second == 0 || raw_size <= 0 || uint32_t(raw_size) > max_uncompressed_blob_size) {
+                    data = decode_blob(blob_data, output);
+                    return get_first_group_type(data);
+                }
+
+                // The StringTable comes first in the block. It is
+                // uncompressed in one pass, but not stored.
+                ZlibInflateStream stream{zlib_data.first, zlib_data.second};
+                return first_group_type(stream);
+            }
+
+            /**
+             * Get the type of the objects in the first PrimitiveGroup of
+             * the PrimitiveBlock in a blob. See above for details.
+             */
+            inline osmium::osm_entity_bits::type peek_blob_first_group_type(const ptr_len_type& blob_data) {
+                std::string output;
+                ptr_len_type data;
+                return peek_blob_first_group_type(blob_data, output, data);
+            }
+
+            /**
+             * Get the types of objects a blob can contain in a file
+             * sorted by type given the types of the first objects in
+             * this and the next blob.
+             */
+            inline osmium::osm_entity_bits::type possible_blob_types(osmium::osm_entity_bits::type first_type, osmium::osm_entity_bits::type next_first_type) noexcept {
+                if (first_type == osmium::osm_entity_bits::nothing ||
+                    next_first_type == osmium::osm_entity_bits::nothing ||
+                    next_first_type < first_type) {
+                    return osmium::osm_entity_bits::all;
+                }
+
+                // all bits from first_type up to next_first_type
+                return static_cast<osmium::osm_entity_bits::type>(((next_first_type << 1) - 1) & ~(first_type - 1));
+            }
+
             inline osmium::Box decode_header_bbox(const ptr_len_type& data) {
                     int64_t left   = std::numeric_limits<int64_t>::max();
                     int64_t right  = std::numeric_limits<int64_t>::max();
@@ -721,7 +1210,13 @@ namespace osmium {
                             }
                             break;
                         case OSMFormat::HeaderBlock::repeated_string_optional_features:
-                            header.set("pbf_optional_feature_" + std::to_string(i++), pbf_header_block.get_string());
+                            {
+                                const auto feature = pbf_header_block.get_string();
+                                if (feature == "Sort.Type_then_ID") {
+                                    header.set("sorting", "Type_then_ID");
+                                }
+                                header.set("pbf_optional_feature_" + std::to_string(i++), feature);
+                            }
                             break;
                         case OSMFormat::HeaderBlock::optional_string_writingprogram:
                             header.set("generator", pbf_header_block.get_string());
@@ -754,22 +1249,84 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const ptr_len_type& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
             }
 
+            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+                return decode_header(ptr_len_type{header_block_data.data(), header_block_data.size()});
+            }
+
             class PBFDataBlobDecoder {
 
-                std::shared_ptr<std::string> m_input_buffer;
+                // Keeps the memory m_data points into alive.
+                std::shared_ptr<const void> m_input_buffer;
+                ptr_len_type m_data;
                 osmium::osm_entity_bits::type m_read_types;
 
+                // If set, output buffers are taken from this pool.
+                std::shared_ptr<osmium::memory::BufferPool> m_buffer_pool;
+
+                read_filter m_filter;
+
+                // Only decode the blob if it can contain objects of the
+                // wanted types. See skip_unwanted_types().
+                bool m_skip_unwanted_types = false;
+
+                // The next blob in the file (if any) for finding out which
+                // types this blob can contain.
+                std::shared_ptr<const void> m_next_input_buffer;
+                ptr_len_type m_next_data;
+
+                osmium::memory::Buffer new_buffer() {
+                    return m_buffer_pool ? m_buffer_pool->get(PBFPrimitiveBlockDecoder::initial_buffer_size)
+                                         : osmium::memory::Buffer{PBFPrimitiveBlockDecoder::initial_buffer_size};
+                }
+
+                bool can_contain_wanted_types(osmium::osm_entity_bits::type first_type) const {
+                    if (first_type == osmium::osm_entity_bits::nothing || (first_type & m_read_types)) {
+                        return true;
+                    }
+                    const auto next_first_type = m_next_data.first ? peek_blob_first_group_type(m_next_data)
+                                                                   : osmium::osm_entity_bits::changeset;
+                    return (possible_blob_types(first_type, next_first_type) & m_read_types) != 0;
+                }
+
             public:
 
                 PBFDataBlobDecoder(std::string&& input_buffer, osmium::osm_entity_bits::type read_types) :
-                    m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
-                    m_read_types(read_types) {
+                    m_input_buffer(),
+                    m_data(),
+                    m_read_types(read_types),
+                    m_buffer_pool(),
+                    m_filter(),
+                    m_next_input_buffer(),
+                    m_next_data() {
+                    const auto buffer = std::make_shared<std::string>(std::move(input_buffer));
+                    m_data = ptr_len_type{buffer->data(), buffer->size()};
+                    m_input_buffer = buffer;
+                }
+
+                /**
+                 * Construct a decoder for data owned by somebody else, for
+                 * instance a memory mapping of the input file. No copy of
+                 * the data is made.
+                 *
+                 * @param owner Shared pointer to the owner of the data. It
+                 *              will be kept alive as long as the decoder.
+                 * @param data Pointer to and length of the blob.
+                 * @param read_types Which entities to decode.
+                 */
+                PBFDataBlobDecoder(std::shared_ptr<const void> owner, const ptr_len_type& data, osmium::osm_entity_bits::type read_types) :
+                    m_input_buffer(std::move(owner)),
+                    m_data(data),
+                    m_read_types(read_types),
+                    m_buffer_pool(),
+                    m_filter(),
+                    m_next_input_buffer(),
+                    m_next_data() {
                 }
 
                 PBFDataBlobDecoder(const PBFDataBlobDecoder&) = default;
@@ -780,9 +1337,61 @@ namespace osmium {
 
                 ~PBFDataBlobDecoder() noexcept = default;
 
+                const ptr_len_type& data() const noexcept {
+                    return m_data;
+                }
+
+                /**
+                 * Use buffers from the given pool for the decoded data
+                 * instead of allocating new ones.
+                 */
+                void set_buffer_pool(const std::shared_ptr<osmium::memory::BufferPool>& buffer_pool) {
+                    m_buffer_pool = buffer_pool;
+                }
+
+                /**
+                 * Only decode objects matching the filter.
+                 */
+                void set_filter(const read_filter& filter) {
+                    m_filter = filter;
+                }
+
+                /**
+                 * Skip the blob (return an empty buffer) if it can not
+                 * contain objects of the wanted types. This only works if
+                 * the file is sorted by type. The types in this blob are
+                 * found out from the types of the first objects in this
+                 * and the next blob. This is done when the decoder runs,
+                 * so it is done on the thread pool.
+                 *
+                 * @param next Decoder for the next blob in the file or
+                 *             nullptr if this is the last blob.
+                 */
+                void skip_unwanted_types(const PBFDataBlobDecoder* next) {
+                    m_skip_unwanted_types = true;
+                    if (next) {
+                        m_next_input_buffer = next->m_input_buffer;
+                        m_next_data = next->m_data;
+                    }
+                }
+
                 osmium::memory::Buffer operator()() {
                     std::string output;
-                    PBFPrimitiveBlockDecoder decoder(decode_blob(*m_input_buffer, output), m_read_types);
+                    ptr_len_type data;
+
+                    if (m_skip_unwanted_types) {
+                        const auto first_type = peek_blob_first_group_type(m_data, output, data);
+                        if (!can_contain_wanted_types(first_type)) {
+                            return new_buffer();
+                        }
+                    }
+
+                    if (!data.first) {
+                        data = decode_blob(m_data, output);
+                    }
+
+                    PBFPrimitiveBlockDecoder decoder(data, m_read_types, new_buffer());
+                    decoder.set_filter(m_filter);
                     return decoder();
                 }
 
@@ -71,6 +71,33 @@ namespace osmium {
 
                 std::string m_input_buffer;
 
+                // Used when reading from a memory mapped file only.
+                const char* m_mapped_data = nullptr;
+                size_t m_mapped_size = 0;
+                size_t m_mapped_offset = 0;
+
+                // Set if the file header says the data is sorted by type.
+                bool m_sorted_by_type = false;
+
+                /**
+                 * Get the given number of bytes from the memory mapped
+                 * input file. No data is copied.
+                 *
+                 * @param size Number of bytes to read
+                 * @returns Pointer to and length of the data
+                 * @throws osmium::pbf_error If size bytes can't be read
+                 */
+                ptr_len_type read_from_mapped_input(size_t size) {
+                    if (m_mapped_size - m_mapped_offset < size) {
+                        throw osmium::pbf_error("truncated data (EOF encountered)");
+                    }
+
+                    const ptr_len_type data{m_mapped_data + m_mapped_offset, size};
+                    m_mapped_offset += size;
+
+                    return data;
+                }
+
                 /**
                  * Read the given number of bytes from the input queue.
                  *
@@ -104,8 +131,13 @@ namespace osmium {
                     uint32_t size_in_network_byte_order;
 
                     try {
-                        const std::string input_data = read_from_input_queue(sizeof(size_in_network_byte_order));
-                        size_in_network_byte_order = *reinterpret_cast<const uint32_t*>(input_data.data());
+                        if (mapped_input()) {
+                            const auto input_data = read_from_mapped_input(sizeof(size_in_network_byte_order));
+                            std::memcpy(&size_in_network_byte_order, input_data.first, sizeof(size_in_network_byte_order));
+                        } else {
+                            const std::string input_data = read_from_input_queue(sizeof(size_in_network_byte_order));
+                            size_in_network_byte_order = *reinterpret_cast<const uint32_t*>(input_data.data());
+                        }
                     } catch (osmium::pbf_error&) {
                         return 0; // EOF
                     }
@@ -118,38 +150,6 @@ namespace osmium {
                     return size;
                 }
 
-                /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
-                 */
-                size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
-                    std::pair<const char*, size_t> blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag()) {
-                            case FileFormat::BlobHeader::required_string_type:
-                                blob_header_type = pbf_blob_header.get_data();
-                                break;
-                            case FileFormat::BlobHeader::required_int32_datasize:
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
-                        }
-                    }
-
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error("PBF format error: BlobHeader.datasize missing or zero.");
-                    }
-
-                    if (strncmp(expected_type, blob_header_type.first, blob_header_type.second)) {
-                        throw osmium::pbf_error("blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)");
-                    }
-
-                    return blob_header_datasize;
-                }
-
                 size_t check_type_and_get_blob_size(const char* expected_type) {
                     assert(expected_type);
 
@@ -158,38 +158,108 @@ namespace osmium {
                         return 0;
                     }
 
+                    if (mapped_input()) {
+                        return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(read_from_mapped_input(size)), expected_type);
+                    }
+
                     const std::string blob_header = read_from_input_queue(size);
 
                     return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header), expected_type);
                 }
 
-                std::string read_from_input_queue_with_check(size_t size) {
+                static void check_blob_size(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error(std::string("invalid blob size: " +
                                                 std::to_string(size)));
                     }
+                }
+
+                std::string read_from_input_queue_with_check(size_t size) {
+                    check_blob_size(size);
                     return read_from_input_queue(size);
                 }
 
+                ptr_len_type read_from_mapped_input_with_check(size_t size) {
+                    check_blob_size(size);
+                    return read_from_mapped_input(size);
+                }
+
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
                     osmium::io::Header header;
                     const auto size = check_type_and_get_blob_size("OSMHeader");
-                    header = decode_header(read_from_input_queue_with_check(size));
+                    if (mapped_input()) {
+                        header = decode_header(read_from_mapped_input_with_check(size));
+                    } else {
+                        header = decode_header(read_from_input_queue_with_check(size));
+                    }
+                    m_sorted_by_type = header.get("sorting") == "Type_then_ID";
                     set_header_value(header);
                 }
 
-                void parse_data_blobs() {
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer = read_from_input_queue_with_check(size);
+                PBFDataBlobDecoder get_data_blob_decoder(size_t size) {
+                    PBFDataBlobDecoder decoder = mapped_input() ?
+                        PBFDataBlobDecoder{ mapped_input(), read_from_mapped_input_with_check(size), read_types() } :
+                        PBFDataBlobDecoder{ read_from_input_queue_with_check(size), read_types() };
+                    decoder.set_buffer_pool(buffer_pool());
+                    decoder.set_filter(filter());
+                    return decoder;
+                }
 
-                        PBFDataBlobDecoder data_blob_parser{ std::move(input_buffer), read_types() };
+                void decode_data_blob(PBFDataBlobDecoder&& data_blob_parser) {
+                    if (osmium::config::use_pool_threads_for_pbf_parsing()) {
+                        // The decoded buffer is usually several times larger
+                        // than the compressed blob.
+                        const auto estimated_size = 4 * data_blob_parser.data().second;
+                        send_to_output_queue(osmium::thread::Pool::instance().submit(std::move(data_blob_parser), osmium::thread::task_priority::high), estimated_size);
+                    } else {
+                        send_to_output_queue(data_blob_parser());
+                    }
+                }
 
-                        if (osmium::config::use_pool_threads_for_pbf_parsing()) {
-                            send_to_output_queue(osmium::thread::Pool::instance().submit(std::move(data_blob_parser)));
-                        } else {
-                            send_to_output_queue(data_blob_parser());
-                        }
+                /**
+                 * Can whole blobs be skipped without decoding them? This is
+                 * only possible if some types are not wanted and the file
+                 * is sorted by type. In that case the types of objects in
+                 * a blob are between the type of the first object in the
+                 * blob and the type of the first object in the next blob.
+                 */
+                bool skip_blobs() const noexcept {
+                    return m_sorted_by_type &&
+                           (read_types() & osmium::osm_entity_bits::all) != osmium::osm_entity_bits::all;
+                }
+
+                /**
+                 * Each decoder gets the next blob, too. The decision whether
+                 * to skip a blob is made by the decoder on the thread pool.
+                 */
+                void parse_data_blobs_skipping() {
+                    auto size = check_type_and_get_blob_size("OSMData");
+                    if (size == 0) {
+                        return;
+                    }
+
+                    PBFDataBlobDecoder data_blob_parser{ get_data_blob_decoder(size) };
+
+                    while ((size = check_type_and_get_blob_size("OSMData"))) {
+                        PBFDataBlobDecoder next_data_blob_parser{ get_data_blob_decoder(size) };
+                        data_blob_parser.skip_unwanted_types(&next_data_blob_parser);
+                        decode_data_blob(std::move(data_blob_parser));
+                        data_blob_parser = std::move(next_data_blob_parser);
+                    }
+
+                    data_blob_parser.skip_unwanted_types(nullptr);
+                    decode_data_blob(std::move(data_blob_parser));
+                }
+
+                void parse_data_blobs() {
+                    if (skip_blobs()) {
+                        parse_data_blobs_skipping();
+                        return;
+                    }
+
+                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
+                        decode_data_blob(get_data_blob_decoder(size));
                     }
                 }
 
@@ -208,8 +278,20 @@ namespace osmium {
                 void run() final {
                     osmium::thread::set_thread_name("_osmium_pbf_in");
 
+                    if (mapped_input()) {
+                        m_mapped_data = mapped_input()->get_addr<const char>();
+                        m_mapped_size = mapped_input()->size();
+                    }
+
                     parse_header_blob();
 
+                    if (mapped_input_start() != 0) {
+                        if (mapped_input_start() < m_mapped_offset || mapped_input_start() > m_mapped_size) {
+                            throw osmium::pbf_error("invalid start offset");
+                        }
+                        m_mapped_offset = mapped_input_start();
+                    }
+
                     if (read_types() != osmium::osm_entity_bits::nothing) {
                         parse_data_blobs();
                     }
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
@@ -43,21 +44,26 @@ DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <time.h>
 #include <utility>
+#include <vector>
 
 #include <protozero/pbf_builder.hpp>
 
 #include <osmium/handler.hpp>
+#include <osmium/io/detail/lz4.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/string_table.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#include <osmium/io/detail/zstd.hpp>
+#include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/collection.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
@@ -77,20 +83,109 @@ namespace osmium {
 
         namespace detail {
 
+            /// Compression used for PBF blobs.
+            enum class pbf_compression {
+                none = 0,
+                zlib = 1,
+                lz4  = 2,
+                zstd = 3
+            };
+
+            /**
+             * Get the compression from the value of the pbf_compression
+             * option. Empty or true values mean zlib, false values mean
+             * none.
+             *
+             * @throws io_error If the value is unknown or the compression
+             *         library is not available.
+             */
+            inline pbf_compression get_pbf_compression(const std::string& value) {
+                if (value.empty() || value == "zlib" || value == "true" || value == "yes") {
+                    return pbf_compression::zlib;
+                }
+                if (value == "none" || value == "false" || value == "no") {
+                    return pbf_compression::none;
+                }
+                if (value == "lz4") {
+                    if (!lz4_available()) {
+                        throw io_error{"lz4 compression not available (compile with OSMIUM_WITH_LZ4)"};
+                    }
+                    return pbf_compression::lz4;
+                }
+                if (value == "zstd") {
+                    if (!zstd_available()) {
+                        throw io_error{"zstd compression not available (compile with OSMIUM_WITH_ZSTD)"};
+                    }
+                    return pbf_compression::zstd;
+                }
+                throw io_error{std::string{"unknown value for pbf_compression option: "} + value};
+            }
+
+            /**
+             * Get the compression level from the value of the
+             * pbf_compression_level option. If it is empty, the default
+             * level of the compression library is used.
+             *
+             * The allowed range depends on the compression: -1 to 9 for
+             * zlib, 0 to 12 for lz4 and whatever the zstd library supports
+             * for zstd. The level is ignored if compression is disabled.
+             *
+             * @throws io_error If the value is not an integer or out of
+             *         range for the compression.
+             */
+            inline int get_pbf_compression_level(const std::string& value, pbf_compression compression) {
+                if (value.empty()) {
+                    return compression == pbf_compression::zlib ? -1 : 0;
+                }
+
+                long min = 0;
+                long max = 0;
+                switch (compression) {
+                    case pbf_compression::none:
+                        break;
+                    case pbf_compression::zlib:
+                        min = -1;
+                        max = 9;
+                        break;
+                    case pbf_compression::lz4:
+                        max = lz4_max_compression_level();
+                        break;
+                    case pbf_compression::zstd:
+                        min = zstd_min_compression_level();
+                        max = zstd_max_compression_level();
+                        break;
+                }
+
+                char* end = nullptr;
+                errno = 0;
+                const long level = std::strtol(value.c_str(), &end, 10);
+                if (end == value.c_str() || *end != '\0' || errno != 0 ||
+                    (compression != pbf_compression::none && (level < min || level > max))) {
+                    throw io_error{std::string{"illegal value for pbf_compression_level option: "} + value};
+                }
+
+                return compression == pbf_compression::none ? 0 : static_cast<int>(level);
+            }
+
             struct pbf_output_options {
 
                 /// Should nodes be encoded in DenseNodes?
                 bool use_dense_nodes;
 
                 /**
-                 * Should the PBF blobs contain zlib compressed data?
+                 * How should the PBF blobs be compressed?
                  *
-                 * The zlib compression is optional, it's possible to store the
+                 * The compression is optional, it's possible to store the
                  * blobs in raw format. Disabling the compression can improve
                  * the writing speed a little but the output will be 2x to 3x
-                 * bigger.
+                 * bigger. lz4 and zstd compressed blobs are much faster to
+                 * read than zlib compressed ones, but not all programs can
+                 * read them.
                  */
-                bool use_compression;
+                pbf_compression compression;
+
+                /// Compression level, meaning depends on compression.
+                int compression_level;
 
                 /// Should metadata of objects be written?
                 bool add_metadata;
@@ -104,6 +199,14 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways;
 
+                /**
+                 * Should the string tables be sorted by frequency? This
+                 * needs an extra pass over the objects of each block, but
+                 * the most often used strings get the shortest indexes,
+                 * so the blocks are smaller and faster to decode.
+                 */
+                bool sort_string_table;
+
             };
 
             /**
@@ -140,7 +243,9 @@ namespace osmium {
 
                 pbf_blob_type m_blob_type;
 
-                bool m_use_compression;
+                pbf_compression m_compression;
+
+                int m_compression_level;
 
             public:
 
@@ -149,13 +254,14 @@ namespace osmium {
                  *
                  * @param msg Protobuf-message containing the blob data
                  * @param type Type of blob.
-                 * @param use_compression Should the output be compressed using
-                 *        zlib?
+                 * @param compression How should the output be compressed?
+                 * @param compression_level Compression level.
                  */
-                SerializeBlob(std::string&& msg, pbf_blob_type type, bool use_compression) :
+                SerializeBlob(std::string&& msg, pbf_blob_type type, pbf_compression compression, int compression_level) :
                     m_msg(std::move(msg)),
                     m_blob_type(type),
-                    m_use_compression(use_compression) {
+                    m_compression(compression),
+                    m_compression_level(compression_level) {
                 }
 
                 /**
@@ -169,11 +275,22 @@ namespace osmium {
                     std::string blob_data;
                     protozero::pbf_builder<FileFormat::Blob> pbf_blob(blob_data);
 
-                    if (m_use_compression) {
-                        pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
-                        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, osmium::io::detail::zlib_compress(m_msg));
-                    } else {
-                        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_raw, m_msg);
+                    switch (m_compression) {
+                        case pbf_compression::none:
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_raw, m_msg);
+                            break;
+                        case pbf_compression::zlib:
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, osmium::io::detail::zlib_compress(m_msg, m_compression_level));
+                            break;
+                        case pbf_compression::lz4:
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_lz4_data, osmium::io::detail::lz4_compress(m_msg, m_compression_level));
+                            break;
+                        case pbf_compression::zstd:
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
                     }
 
                     std::string blob_header_data;
@@ -359,6 +476,12 @@ namespace osmium {
                 }
 
                 void write_stringtable(protozero::pbf_builder<OSMFormat::StringTable>& pbf_string_table) {
+                    if (m_stringtable.sorted()) {
+                        for (const char* s : m_stringtable.sorted_strings()) {
+                            pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
+                        }
+                        return;
+                    }
                     for (const char* s : m_stringtable) {
                         pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
                     }
@@ -378,6 +501,14 @@ namespace osmium {
                     return m_stringtable.add(s);
                 }
 
+                void count_in_stringtable(const char* s) {
+                    m_stringtable.count(s);
+                }
+
+                void sort_stringtable() {
+                    m_stringtable.sort_by_frequency();
+                }
+
                 int count() const {
                     return m_count;
                 }
@@ -398,46 +529,18 @@ namespace osmium {
                  */
                 constexpr static size_t max_used_blob_size = max_uncompressed_blob_size * 95 / 100;
 
-                bool can_add(OSMFormat::PrimitiveGroup type) const {
-                    if (type != m_type) {
-                        return false;
-                    }
-                    if (count() >= max_entities_per_block) {
-                        return false;
-                    }
-                    return size() < max_used_blob_size;
-                }
-
             }; // class PrimitiveBlock
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * Handler encoding OSM objects of one type into a single
+             * PrimitiveBlock.
+             */
+            class PrimitiveBlockEncoder : public osmium::handler::Handler {
 
-                pbf_output_options m_options;
+                const pbf_output_options& m_options;
 
                 PrimitiveBlock m_primitive_block;
 
-                void store_primitive_block() {
-                    if (m_primitive_block.count() == 0) {
-                        return;
-                    }
-
-                    std::string primitive_block_data;
-                    protozero::pbf_builder<OSMFormat::PrimitiveBlock> primitive_block(primitive_block_data);
-
-                    {
-                        protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table(primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable);
-                        m_primitive_block.write_stringtable(pbf_string_table);
-                    }
-
-                    primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
-
-                    m_output_queue.push(osmium::thread::Pool::instance().submit(
-                        SerializeBlob{std::move(primitive_block_data),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression}
-                    ));
-                }
-
                 template <typename T>
                 void add_meta(const osmium::OSMObject& object, T& pbf_object) {
                     {
@@ -468,101 +571,59 @@ namespace osmium {
                     }
                 }
 
-                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
-                    if (!m_primitive_block.can_add(type)) {
-                        store_primitive_block();
-                        m_primitive_block.reset(type);
-                    }
-                }
-
             public:
 
-                PBFOutputFormat(const osmium::io::File& file, future_string_queue_type& output_queue) :
-                    OutputFormat(output_queue),
-                    m_options(),
-                    m_primitive_block(m_options) {
-                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
-                    m_options.use_compression = file.get("pbf_compression") != "none" && file.is_not_false("pbf_compression");
-                    m_options.add_metadata = file.is_not_false("pbf_add_metadata") && file.is_not_false("add_metadata");
-                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
-                    m_options.add_visible_flag = file.has_multiple_object_versions();
-                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                PrimitiveBlockEncoder(const pbf_output_options& options, OSMFormat::PrimitiveGroup type) :
+                    m_options(options),
+                    m_primitive_block(options) {
+                    m_primitive_block.reset(type);
                 }
 
-                PBFOutputFormat(const PBFOutputFormat&) = delete;
-                PBFOutputFormat& operator=(const PBFOutputFormat&) = delete;
-
-                ~PBFOutputFormat() noexcept final = default;
-
-                void write_header(const osmium::io::Header& header) final {
-                    std::string data;
-                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block(data);
-
-                    if (!header.boxes().empty()) {
-                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox(pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox);
-
-                        osmium::Box box = header.joined_boxes();
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
-                    }
-
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
-
-                    if (m_options.use_dense_nodes) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
+                /**
+                 * Count the strings used by this object. If this is called
+                 * for all objects before they are added, the string table
+                 * will be sorted by frequency.
+                 */
+                void count_strings(const osmium::OSMObject& object) {
+                    for (const auto& tag : object.tags()) {
+                        m_primitive_block.count_in_stringtable(tag.key());
+                        m_primitive_block.count_in_stringtable(tag.value());
                     }
-
-                    if (m_options.add_historical_information_flag) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                    if (m_options.add_metadata) {
+                        m_primitive_block.count_in_stringtable(object.user());
                     }
-
-                    if (m_options.locations_on_ways) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                    if (object.type() == osmium::item_type::relation) {
+                        for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                            m_primitive_block.count_in_stringtable(member.role());
+                        }
                     }
+                }
 
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
-
-                    std::string osmosis_replication_timestamp = header.get("osmosis_replication_timestamp");
-                    if (!osmosis_replication_timestamp.empty()) {
-                        osmium::Timestamp ts(osmosis_replication_timestamp.c_str());
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
-                    }
+                void sort_string_table() {
+                    m_primitive_block.sort_stringtable();
+                }
 
-                    std::string osmosis_replication_sequence_number = header.get("osmosis_replication_sequence_number");
-                    if (!osmosis_replication_sequence_number.empty()) {
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, std::atoll(osmosis_replication_sequence_number.c_str()));
-                    }
+                /// Get the encoded PrimitiveBlock.
+                std::string data() {
+                    std::string primitive_block_data;
+                    protozero::pbf_builder<OSMFormat::PrimitiveBlock> primitive_block(primitive_block_data);
 
-                    std::string osmosis_replication_base_url = header.get("osmosis_replication_base_url");
-                    if (!osmosis_replication_base_url.empty()) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                    {
+                        protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table(primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable);
+                        m_primitive_block.write_stringtable(pbf_string_table);
                     }
 
-                    m_output_queue.push(osmium::thread::Pool::instance().submit(
-                        SerializeBlob{std::move(data),
-                                      pbf_blob_type::header,
-                                      m_options.use_compression}
-                        ));
-                }
-
-                void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
-                }
+                    primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
 
-                void write_end() final {
-                    store_primitive_block();
+                    return primitive_block_data;
                 }
 
                 void node(const osmium::Node& node) {
                     if (m_options.use_dense_nodes) {
-                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
                         m_primitive_block.add_dense_node(node);
                         return;
                     }
 
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
                     protozero::pbf_builder<OSMFormat::Node> pbf_node{ m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes };
 
                     pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
@@ -573,7 +634,6 @@ namespace osmium {
                 }
 
                 void way(const osmium::Way& way) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
                     protozero::pbf_builder<OSMFormat::Way> pbf_way{ m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Way_ways };
 
                     pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
@@ -610,7 +670,6 @@ namespace osmium {
                 }
 
                 void relation(const osmium::Relation& relation) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
                     protozero::pbf_builder<OSMFormat::Relation> pbf_relation { m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations };
 
                     pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
@@ -640,6 +699,266 @@ namespace osmium {
                     }
                 }
 
+            }; // class PrimitiveBlockEncoder
+
+            /**
+             * A range of OSM objects in a buffer. The shared pointer keeps
+             * the buffer alive until the objects have been encoded.
+             */
+            struct pbf_buffer_range {
+                std::shared_ptr<const osmium::memory::Buffer> buffer;
+                osmium::memory::Buffer::const_iterator first;
+                osmium::memory::Buffer::const_iterator last;
+            };
+
+            /**
+             * Encode OSM objects into a PrimitiveBlock and serialize it
+             * into a Blob. This runs as a task in the thread pool, so
+             * several blocks can be built at the same time.
+             *
+             * The objects are chosen by their size in the buffer which is
+             * only an estimate of the encoded size. If the encoded block
+             * turns out to be larger than max_uncompressed_blob_size, the
+             * objects are split into two blocks which are encoded
+             * separately. The result then contains both blobs.
+             */
+            class EncodePrimitiveBlock {
+
+                pbf_output_options m_options;
+
+                std::vector<pbf_buffer_range> m_ranges;
+
+                OSMFormat::PrimitiveGroup m_type;
+
+                std::string encode(const std::vector<const osmium::OSMObject*>& objects, std::size_t first, std::size_t last) const {
+                    PrimitiveBlockEncoder encoder{m_options, m_type};
+
+                    if (m_options.sort_string_table) {
+                        for (std::size_t i = first; i < last; ++i) {
+                            encoder.count_strings(*objects[i]);
+                        }
+                        encoder.sort_string_table();
+                    }
+
+                    for (std::size_t i = first; i < last; ++i) {
+                        osmium::apply_item(*objects[i], encoder);
+                    }
+
+                    std::string data{encoder.data()};
+                    if (data.size() > max_uncompressed_blob_size) {
+                        if (last - first == 1) {
+                            throw io_error{"OSM object too large for PBF block"};
+                        }
+                        const std::size_t middle = first + (last - first) / 2;
+                        return encode(objects, first, middle) + encode(objects, middle, last);
+                    }
+
+                    return SerializeBlob{std::move(data),
+                                         pbf_blob_type::data,
+                                         m_options.compression,
+                                         m_options.compression_level}();
+                }
+
+            public:
+
+                EncodePrimitiveBlock(const pbf_output_options& options, std::vector<pbf_buffer_range>&& ranges, OSMFormat::PrimitiveGroup type) :
+                    m_options(options),
+                    m_ranges(std::move(ranges)),
+                    m_type(type) {
+                }
+
+                std::string operator()() {
+                    std::vector<const osmium::OSMObject*> objects;
+                    objects.reserve(max_entities_per_block);
+
+                    for (const auto& range : m_ranges) {
+                        for (auto it = range.first; it != range.last; ++it) {
+                            if (osmium::osm_entity_bits::from_item_type(it->type()) & osmium::osm_entity_bits::nwr) {
+                                objects.push_back(static_cast<const osmium::OSMObject*>(&*it));
+                            }
+                        }
+                    }
+
+                    return encode(objects, 0, objects.size());
+                }
+
+            }; // class EncodePrimitiveBlock
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                /// Objects collected for the next PrimitiveBlock.
+                std::vector<pbf_buffer_range> m_ranges;
+
+                OSMFormat::PrimitiveGroup m_type;
+
+                int m_count;
+
+                /// Estimated size of the next PrimitiveBlock.
+                size_t m_size;
+
+                OSMFormat::PrimitiveGroup group_type(osmium::item_type type) const noexcept {
+                    switch (type) {
+                        case osmium::item_type::node:
+                            return m_options.use_dense_nodes ? OSMFormat::PrimitiveGroup::optional_DenseNodes_dense
+                                                             : OSMFormat::PrimitiveGroup::repeated_Node_nodes;
+                        case osmium::item_type::way:
+                            return OSMFormat::PrimitiveGroup::repeated_Way_ways;
+                        case osmium::item_type::relation:
+                            return OSMFormat::PrimitiveGroup::repeated_Relation_relations;
+                        default:
+                            break;
+                    }
+                    return OSMFormat::PrimitiveGroup::unknown;
+                }
+
+                /**
+                 * The size of an object in the buffer is used as an estimate
+                 * for its encoded size. This is not an upper bound: a node
+                 * ref with location takes 16 bytes in the buffer, but up to
+                 * 20 bytes encoded, and short tags or metadata can also grow.
+                 * EncodePrimitiveBlock splits blocks that get too large.
+                 */
+                bool can_add(OSMFormat::PrimitiveGroup type) const noexcept {
+                    return type == m_type &&
+                           m_count < max_entities_per_block &&
+                           m_size < PrimitiveBlock::max_used_blob_size;
+                }
+
+                void store_primitive_block() {
+                    if (m_count > 0) {
+                        const auto size = m_size;
+                        send_to_output_queue(osmium::thread::Pool::instance().submit(
+                            EncodePrimitiveBlock{m_options, std::move(m_ranges), m_type}
+                        ), size);
+                    }
+
+                    m_ranges.clear();
+                    m_count = 0;
+                    m_size = 0;
+                }
+
+
+            public:
+
+                PBFOutputFormat(const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(output_queue),
+                    m_options(),
+                    m_ranges(),
+                    m_type(OSMFormat::PrimitiveGroup::unknown),
+                    m_count(0),
+                    m_size(0) {
+                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
+                    m_options.compression = get_pbf_compression(file.get("pbf_compression"));
+                    m_options.compression_level = get_pbf_compression_level(file.get("pbf_compression_level"), m_options.compression);
+                    m_options.add_metadata = file.is_not_false("pbf_add_metadata") && file.is_not_false("add_metadata");
+                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
+                    m_options.add_visible_flag = file.has_multiple_object_versions();
+                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.sort_string_table = file.is_true("pbf_sort_string_table");
+                }
+
+                PBFOutputFormat(const PBFOutputFormat&) = delete;
+                PBFOutputFormat& operator=(const PBFOutputFormat&) = delete;
+
+                ~PBFOutputFormat() noexcept final = default;
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string data;
+                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block(data);
+
+                    if (!header.boxes().empty()) {
+                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox(pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox);
+
+                        osmium::Box box = header.joined_boxes();
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
+
+                    if (m_options.use_dense_nodes) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
+                    }
+
+                    if (m_options.add_historical_information_flag) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                    }
+
+                    if (m_options.locations_on_ways) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                    }
+
+                    if (header.get("sorting") == "Type_then_ID") {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
+
+                    std::string osmosis_replication_timestamp = header.get("osmosis_replication_timestamp");
+                    if (!osmosis_replication_timestamp.empty()) {
+                        osmium::Timestamp ts(osmosis_replication_timestamp.c_str());
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
+                    }
+
+                    std::string osmosis_replication_sequence_number = header.get("osmosis_replication_sequence_number");
+                    if (!osmosis_replication_sequence_number.empty()) {
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, std::atoll(osmosis_replication_sequence_number.c_str()));
+                    }
+
+                    std::string osmosis_replication_base_url = header.get("osmosis_replication_base_url");
+                    if (!osmosis_replication_base_url.empty()) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                    }
+
+                    const auto size = data.size();
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(
+                        SerializeBlob{std::move(data),
+                                      pbf_blob_type::header,
+                                      m_options.compression,
+                                      m_options.compression_level}
+                        ), size);
+                }
+
+                /**
+                 * Cut the buffer into ranges of objects for PrimitiveBlocks.
+                 * The blocks are built in the thread pool. The objects at
+                 * the end of the buffer are kept for the next block which
+                 * might be filled up from the next buffer.
+                 */
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    const std::shared_ptr<const osmium::memory::Buffer> shared_buffer{new osmium::memory::Buffer{std::move(buffer)}};
+
+                    auto first = shared_buffer->cbegin();
+                    for (auto it = first; it != shared_buffer->cend(); ++it) {
+                        const auto type = group_type(it->type());
+                        if (type == OSMFormat::PrimitiveGroup::unknown) {
+                            continue;
+                        }
+                        if (!can_add(type)) {
+                            if (first != it) {
+                                m_ranges.push_back(pbf_buffer_range{shared_buffer, first, it});
+                            }
+                            store_primitive_block();
+                            m_type = type;
+                            first = it;
+                        }
+                        ++m_count;
+                        m_size += it->byte_size();
+                    }
+
+                    if (first != shared_buffer->cend()) {
+                        m_ranges.push_back(pbf_buffer_range{shared_buffer, first, shared_buffer->cend()});
+                    }
+                }
+
+                void write_end() final {
+                    store_primitive_block();
+                }
+
             }; // class PBFOutputFormat
 
             // we want the register_output_format() function to run, setting
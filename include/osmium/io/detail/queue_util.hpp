@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <string>
 
 #include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/thread/queue.hpp>
 
 namespace osmium {
@@ -76,10 +77,36 @@ namespace osmium {
              */
             using future_string_queue_type = future_queue_type<std::string>;
 
+            /**
+             * Default maximum number of entries in the queues between the
+             * threads of Reader and Writer. It grows with the number of
+             * threads in the Pool, because each of them can work on one
+             * entry.
+             */
+            inline size_t default_queue_length() {
+                return std::max(size_t(20), 4 * size_t(osmium::thread::Pool::instance().num_threads()));
+            }
+
+            /**
+             * Default maximum number of bytes in the queues between the
+             * threads of Reader and Writer.
+             */
+            inline size_t default_queue_bytes() {
+                return std::max(size_t(256) * 1024 * 1024, size_t(32) * 1024 * 1024 * size_t(osmium::thread::Pool::instance().num_threads()));
+            }
+
+            inline size_t data_size(const std::string& data) noexcept {
+                return data.size();
+            }
+
+            inline size_t data_size(const osmium::memory::Buffer& buffer) noexcept {
+                return buffer.committed();
+            }
+
             template <typename T>
             inline void add_to_queue(future_queue_type<T>& queue, T&& data) {
                 std::promise<T> promise;
-                queue.push(promise.get_future());
+                queue.push(promise.get_future(), data_size(data));
                 promise.set_value(std::forward<T>(data));
             }
 
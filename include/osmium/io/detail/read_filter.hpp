@@ -0,0 +1,155 @@
+#ifndef OSMIUM_IO_DETAIL_READ_FILTER_HPP
+#define OSMIUM_IO_DETAIL_READ_FILTER_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include <osmium/io/reader_options.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Restrictions on the objects the Reader should return, set
+             * with the tag_filter, osmium::Box, and id_range options.
+             * Parsers can use this to avoid building objects nobody wants.
+             * For parsers that don't, the Reader filters the objects
+             * afterwards.
+             */
+            struct read_filter {
+
+                /// Predicate objects must have a matching tag for (if set).
+                std::shared_ptr<const osmium::io::tag_filter::predicate_type> tags;
+
+                /// Nodes must be inside this box (if valid).
+                osmium::Box box;
+
+                /// Objects must have an ID in this range (inclusive).
+                osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::min();
+                osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::max();
+
+                bool has_tags() const noexcept {
+                    return bool(tags);
+                }
+
+                bool has_box() const noexcept {
+                    return box.valid();
+                }
+
+                bool has_id_range() const noexcept {
+                    return min_id != std::numeric_limits<osmium::object_id_type>::min() ||
+                           max_id != std::numeric_limits<osmium::object_id_type>::max();
+                }
+
+                bool empty() const noexcept {
+                    return !has_tags() && !has_box() && !has_id_range();
+                }
+
+                bool id_matches(osmium::object_id_type id) const noexcept {
+                    return id >= min_id && id <= max_id;
+                }
+
+                /**
+                 * Does a node with this location match? Nodes without a
+                 * valid location never match if a box is set.
+                 */
+                bool location_matches(const osmium::Location& location) const noexcept {
+                    return !has_box() || (location.valid() && box.contains(location));
+                }
+
+                bool tags_match(const osmium::TagList& tag_list) const {
+                    return !has_tags() || std::any_of(tag_list.cbegin(), tag_list.cend(), [this](const osmium::Tag& tag) {
+                        return (*tags)(tag.key(), tag.value());
+                    });
+                }
+
+                /**
+                 * Check all restrictions on an entity. Entities that are
+                 * not nodes, ways, or relations always match.
+                 */
+                bool matches(const osmium::OSMEntity& entity) const {
+                    if (entity.type() == osmium::item_type::node &&
+                        !location_matches(static_cast<const osmium::Node&>(entity).location())) {
+                        return false;
+                    }
+
+                    if (entity.type() == osmium::item_type::node ||
+                        entity.type() == osmium::item_type::way ||
+                        entity.type() == osmium::item_type::relation) {
+                        const auto& object = static_cast<const osmium::OSMObject&>(entity);
+                        return id_matches(object.id()) && tags_match(object.tags());
+                    }
+
+                    return true;
+                }
+
+            }; // struct read_filter
+
+            /**
+             * Copy all entities matching the filter from the buffer into a
+             * new buffer.
+             */
+            inline osmium::memory::Buffer filter_buffer(const osmium::memory::Buffer& buffer, const read_filter& filter) {
+                osmium::memory::Buffer output{buffer.committed(), osmium::memory::Buffer::auto_grow::yes};
+
+                for (const auto& entity : buffer) {
+                    if (filter.matches(entity)) {
+                        output.add_item(entity);
+                        output.commit();
+                    }
+                }
+
+                return output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_READ_FILTER_HPP
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
@@ -41,6 +42,7 @@ DEALINGS IN THE SOFTWARE.
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <osmium/io/detail/pbf.hpp>
 
@@ -217,12 +219,32 @@ namespace osmium {
                 std::map<const char*, size_t, StrComp> m_index;
                 uint32_t m_size;
 
+                // Number of times each string was counted, indexed by the
+                // ID it got when it was first seen.
+                std::vector<uint32_t> m_counts;
+
+                // Strings in ID order after sort_by_frequency() was called.
+                std::vector<const char*> m_sorted;
+
+                const char* insert(const char* s) {
+                    const char* cs = m_strings.add(s);
+                    m_index[cs] = ++m_size;
+
+                    if (m_size > max_entries) {
+                        throw osmium::pbf_error("string table has too many entries");
+                    }
+
+                    return cs;
+                }
+
             public:
 
                 StringTable() :
                     m_strings(1024 * 1024),
                     m_index(),
-                    m_size(0) {
+                    m_size(0),
+                    m_counts(),
+                    m_sorted() {
                     m_strings.add("");
                 }
 
@@ -230,6 +252,8 @@ namespace osmium {
                     m_strings.clear();
                     m_index.clear();
                     m_size = 0;
+                    m_counts.clear();
+                    m_sorted.clear();
                     m_strings.add("");
                 }
 
@@ -243,16 +267,75 @@ namespace osmium {
                         return uint32_t(f->second);
                     }
 
-                    const char* cs = m_strings.add(s);
-                    m_index[cs] = ++m_size;
-
-                    if (m_size > max_entries) {
-                        throw osmium::pbf_error("string table has too many entries");
+                    const char* cs = insert(s);
+                    if (sorted()) {
+                        m_sorted.push_back(cs);
                     }
 
                     return m_size;
                 }
 
+                /**
+                 * Count an occurrence of a string. Call this for all
+                 * strings before calling sort_by_frequency().
+                 */
+                void count(const char* s) {
+                    auto f = m_index.find(s);
+                    if (f != m_index.end()) {
+                        ++m_counts[f->second];
+                        return;
+                    }
+
+                    insert(s);
+                    m_counts.resize(m_size + 1);
+                    m_counts[m_size] = 1;
+                }
+
+                /**
+                 * Give the most frequent strings the smallest IDs, so
+                 * that they are encoded in fewer bytes. Strings with the
+                 * same count keep the order in which they were first seen.
+                 * After this add() returns the new IDs and the strings
+                 * have to be written in the order given by
+                 * sorted_strings().
+                 */
+                void sort_by_frequency() {
+                    m_counts.resize(m_size + 1);
+
+                    std::vector<uint32_t> ids(m_size);
+                    for (uint32_t i = 0; i < m_size; ++i) {
+                        ids[i] = i + 1;
+                    }
+                    std::stable_sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) {
+                        return m_counts[a] > m_counts[b];
+                    });
+
+                    std::vector<uint32_t> new_ids(m_size + 1);
+                    for (uint32_t i = 0; i < m_size; ++i) {
+                        new_ids[ids[i]] = i + 1;
+                    }
+
+                    m_sorted.assign(m_size + 1, nullptr);
+                    m_sorted[0] = "";
+                    for (auto& entry : m_index) {
+                        entry.second = new_ids[entry.second];
+                        m_sorted[entry.second] = entry.first;
+                    }
+                }
+
+                /// Has sort_by_frequency() been called?
+                bool sorted() const noexcept {
+                    return !m_sorted.empty();
+                }
+
+                /**
+                 * The strings in ID order after sort_by_frequency() was
+                 * called. Empty otherwise.
+                 */
+                const std::vector<const char*>& sorted_strings() const noexcept {
+                    return m_sorted;
+                }
+
                 StringStore::const_iterator begin() const {
                     return m_strings.begin();
                 }
@@ -173,6 +173,25 @@ namespace osmium {
                 }
             }
 
+            inline void append_json_encoded_string(std::string& out, const char* data) {
+                for (; *data != '\0'; ++data) {
+                    switch(*data) {
+                        case '\"': out += "\\\"";  break;
+                        case '\\': out += "\\\\";  break;
+                        case '\n': out += "\\n";   break;
+                        case '\r': out += "\\r";   break;
+                        case '\t': out += "\\t";   break;
+                        default:
+                            if (static_cast<unsigned char>(*data) < 0x20) {
+                                append_printf_formatted_string(out, "\\u%04x", static_cast<unsigned int>(*data));
+                            } else {
+                                out += *data;
+                            }
+                            break;
+                    }
+                }
+            }
+
             inline void append_debug_encoded_string(std::string& out, const char* data, const char* prefix, const char* suffix) {
                 const char* end = data + std::strlen(data);
 
@@ -34,10 +34,12 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cassert>
+#include <cctype>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <functional>
 #include <future>
 #include <memory>
 #include <string>
@@ -61,9 +63,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/types_from_string.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/cast.hpp>
+#include <osmium/util/config.hpp>
 
 namespace osmium {
 
@@ -126,7 +130,25 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser : public Parser {
+            /**
+             * Builds OSM objects from the callbacks of the Expat parser.
+             *
+             * This is used by the XMLParser to parse the whole input in
+             * order and by the XMLChunkDecoder to parse chunks of the input
+             * on the thread pool. The header callback is called once the
+             * header is complete, the buffer callback is called whenever
+             * the buffer is nearly full. If no buffer callback is set, the
+             * buffer will grow as needed and can be retrieved with
+             * get_buffer() at the end.
+             */
+            class XMLDecoder {
+
+            public:
+
+                using header_callback_type = std::function<void(const osmium::io::Header&)>;
+                using buffer_callback_type = std::function<void(osmium::memory::Buffer&&)>;
+
+            private:
 
                 static constexpr int buffer_size = 2 * 1000 * 1000;
 
@@ -172,6 +194,13 @@ namespace osmium {
 
                 std::string m_comment_text;
 
+                osmium::osm_entity_bits::type m_read_types;
+
+                header_callback_type m_header_callback;
+                buffer_callback_type m_buffer_callback;
+
+                bool m_header_is_done;
+
                 /**
                  * A C++ wrapper for the Expat parser that makes sure no memory is leaked.
                  */
@@ -181,15 +210,15 @@ namespace osmium {
                     XML_Parser m_parser;
 
                     static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) {
-                        static_cast<XMLParser*>(data)->start_element(element, attrs);
+                        static_cast<T*>(data)->start_element(element, attrs);
                     }
 
                     static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) {
-                        static_cast<XMLParser*>(data)->end_element(element);
+                        static_cast<T*>(data)->end_element(element);
                     }
 
                     static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) {
-                        static_cast<XMLParser*>(data)->characters(text, len);
+                        static_cast<T*>(data)->characters(text, len);
                     }
 
                     // This handler is called when there are any XML entities
@@ -226,14 +255,20 @@ namespace osmium {
                         XML_ParserFree(m_parser);
                     }
 
-                    void operator()(const std::string& data, bool last) {
-                        if (XML_Parse(m_parser, data.data(), static_cast_with_assert<int>(data.size()), last) == XML_STATUS_ERROR) {
+                    void operator()(const char* data, size_t size, bool last) {
+                        if (XML_Parse(m_parser, data, static_cast_with_assert<int>(size), last) == XML_STATUS_ERROR) {
                             throw osmium::xml_error(m_parser);
                         }
                     }
 
                 }; // class ExpatXMLParser
 
+                ExpatXMLParser<XMLDecoder> m_expat;
+
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_read_types;
+                }
+
                 template <typename T>
                 static void check_attributes(const XML_Char** attrs, T check) {
                     while (*attrs) {
@@ -314,9 +349,6 @@ namespace osmium {
                     m_tl_builder->add_tag(k, v);
                 }
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
 
                 void start_element(const XML_Char* element, const XML_Char** attrs) {
                     switch (m_context) {
@@ -618,8 +650,8 @@ namespace osmium {
                 }
 
                 void flush_buffer() {
-                    if (m_buffer.committed() > buffer_size / 10 * 9) {
-                        send_to_output_queue(std::move(m_buffer));
+                    if (m_buffer_callback && m_buffer.committed() > buffer_size / 10 * 9) {
+                        m_buffer_callback(std::move(m_buffer));
                         osmium::memory::Buffer buffer(buffer_size);
                         using std::swap;
                         swap(m_buffer, buffer);
@@ -628,11 +660,9 @@ namespace osmium {
 
             public:
 
-                XMLParser(future_string_queue_type& input_queue,
-                          future_buffer_queue_type& output_queue,
-                          std::promise<osmium::io::Header>& header_promise,
-                          osmium::osm_entity_bits::type read_types) :
-                    Parser(input_queue, output_queue, header_promise, read_types),
+                explicit XMLDecoder(osmium::osm_entity_bits::type read_types,
+                                    header_callback_type header_callback = nullptr,
+                                    buffer_callback_type buffer_callback = nullptr) :
                     m_context(context::root),
                     m_last_context(context::root),
                     m_in_delete_section(false),
@@ -645,28 +675,341 @@ namespace osmium {
                     m_changeset_discussion_builder(),
                     m_tl_builder(),
                     m_wnl_builder(),
-                    m_rml_builder() {
+                    m_rml_builder(),
+                    m_comment_text(),
+                    m_read_types(read_types),
+                    m_header_callback(std::move(header_callback)),
+                    m_buffer_callback(std::move(buffer_callback)),
+                    m_header_is_done(false),
+                    m_expat(this) {
                 }
 
-                ~XMLParser() noexcept final = default;
+                XMLDecoder(const XMLDecoder&) = delete;
+                XMLDecoder& operator=(const XMLDecoder&) = delete;
 
-                void run() final {
-                    osmium::thread::set_thread_name("_osmium_xml_in");
+                XMLDecoder(XMLDecoder&&) = delete;
+                XMLDecoder& operator=(XMLDecoder&&) = delete;
+
+                ~XMLDecoder() noexcept = default;
+
+                /**
+                 * Parse the next piece of XML data.
+                 *
+                 * @param data Pointer to the data.
+                 * @param size Length of the data.
+                 * @param last Set this to true for the last piece of data.
+                 * @throws osmium::xml_error If the data can not be parsed.
+                 */
+                void parse(const char* data, size_t size, bool last) {
+                    m_expat(data, size, last);
+                }
+
+                void parse(const std::string& data, bool last) {
+                    m_expat(data.data(), data.size(), last);
+                }
+
+                const osmium::io::Header& header() const noexcept {
+                    return m_header;
+                }
+
+                bool header_is_done() const noexcept {
+                    return m_header_is_done;
+                }
+
+                void mark_header_as_done() {
+                    if (!m_header_is_done) {
+                        m_header_is_done = true;
+                        if (m_header_callback) {
+                            m_header_callback(m_header);
+                        }
+                    }
+                }
+
+                /**
+                 * Get the buffer with all the (remaining) objects parsed
+                 * so far.
+                 */
+                osmium::memory::Buffer get_buffer() {
+                    return std::move(m_buffer);
+                }
+
+            }; // class XMLDecoder
+
+            /**
+             * Is there a start tag of an OSM object (node, way, relation,
+             * or changeset) at the given position?
+             *
+             * @param data Pointer to a '<' character.
+             * @param end Pointer to the end of the data.
+             */
+            inline bool is_object_start_tag(const char* data, const char* end) noexcept {
+                static const char* const names[] = { "node", "way", "relation", "changeset" };
+
+                ++data;
+                for (const char* name : names) {
+                    const auto len = std::strlen(name);
+                    if (end - data > static_cast<std::ptrdiff_t>(len) && !std::strncmp(data, name, len)) {
+                        const char c = data[len];
+                        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '>' || c == '/';
+                    }
+                }
+
+                return false;
+            }
+
+            /**
+             * Find the first start tag of an OSM object in the data.
+             *
+             * @returns Position of the '<' character or std::string::npos.
+             */
+            inline size_t find_first_object_start(const std::string& data) noexcept {
+                const char* const end = data.data() + data.size();
+                const char* ptr = data.data();
+                while ((ptr = static_cast<const char*>(std::memchr(ptr, '<', end - ptr)))) {
+                    if (is_object_start_tag(ptr, end)) {
+                        return ptr - data.data();
+                    }
+                    ++ptr;
+                }
+                return std::string::npos;
+            }
+
+            /**
+             * Find the last start tag of an OSM object in the data.
+             *
+             * @returns Position of the '<' character or std::string::npos.
+             */
+            inline size_t find_last_object_start(const std::string& data) noexcept {
+                const char* const end = data.data() + data.size();
+                size_t pos = data.size();
+                while (pos > 0 && (pos = data.rfind('<', pos - 1)) != std::string::npos) {
+                    if (is_object_start_tag(data.data() + pos, end)) {
+                        return pos;
+                    }
+                }
+                return std::string::npos;
+            }
+
+            /**
+             * Update the name of the currently open section ("create",
+             * "modify", or "delete") in an osmChange file by looking at all
+             * tags in the data. An empty section name means that we are not
+             * in any section.
+             */
+            inline void update_change_section(const char* data, const char* end, std::string& section) {
+                static const char* const names[] = { "create", "modify", "delete" };
+
+                while ((data = static_cast<const char*>(std::memchr(data, '<', end - data)))) {
+                    ++data;
+                    const bool is_end_tag = data != end && *data == '/';
+                    const char* name_start = is_end_tag ? data + 1 : data;
+                    for (const char* name : names) {
+                        const auto len = std::strlen(name);
+                        if (end - name_start > static_cast<std::ptrdiff_t>(len) &&
+                            !std::strncmp(name_start, name, len) &&
+                            (name_start[len] == '>' || std::isspace(static_cast<unsigned char>(name_start[len])))) {
+                            if (is_end_tag) {
+                                section.clear();
+                            } else {
+                                const char* tag_end = static_cast<const char*>(std::memchr(name_start, '>', end - name_start));
+                                if (!tag_end || tag_end[-1] != '/') {
+                                    section = name;
+                                }
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Decodes a chunk of an OSM XML file. The chunk must start at
+             * the beginning of an OSM object. The prefix and suffix contain
+             * the start and end tags needed to make the chunk into a
+             * well-formed XML document.
+             */
+            class XMLChunkDecoder {
+
+                std::string m_prefix;
+                std::string m_data;
+                std::string m_suffix;
+                osmium::osm_entity_bits::type m_read_types;
+
+            public:
+
+                XMLChunkDecoder(std::string&& prefix, std::string&& data, std::string&& suffix, osmium::osm_entity_bits::type read_types) :
+                    m_prefix(std::move(prefix)),
+                    m_data(std::move(data)),
+                    m_suffix(std::move(suffix)),
+                    m_read_types(read_types) {
+                }
+
+                XMLChunkDecoder(const XMLChunkDecoder&) = default;
+                XMLChunkDecoder& operator=(const XMLChunkDecoder&) = default;
+
+                XMLChunkDecoder(XMLChunkDecoder&&) = default;
+                XMLChunkDecoder& operator=(XMLChunkDecoder&&) = default;
+
+                ~XMLChunkDecoder() noexcept = default;
+
+                osmium::memory::Buffer operator()() {
+                    XMLDecoder decoder{m_read_types};
+                    decoder.parse(m_prefix, false);
+                    decoder.parse(m_data, false);
+                    decoder.parse(m_suffix, true);
+                    return decoder.get_buffer();
+                }
+
+            }; // class XMLChunkDecoder
 
-                    ExpatXMLParser<XMLParser> parser(this);
+            class XMLParser : public Parser {
+
+                /**
+                 * Size of the chunks of XML data handed to the pool threads
+                 * when parsing in parallel.
+                 */
+                static constexpr size_t chunk_size = 4 * 1000 * 1000;
+
+                XMLDecoder::header_callback_type header_callback() {
+                    return [this](const osmium::io::Header& header) {
+                        set_header_value(header);
+                    };
+                }
+
+                XMLDecoder::buffer_callback_type buffer_callback() {
+                    return [this](osmium::memory::Buffer&& buffer) {
+                        send_to_output_queue(std::move(buffer));
+                    };
+                }
+
+                void send_remaining_buffer(XMLDecoder& decoder) {
+                    osmium::memory::Buffer buffer = decoder.get_buffer();
+                    if (buffer.committed() > 0) {
+                        send_to_output_queue(std::move(buffer));
+                    }
+                }
+
+                void run_sequential() {
+                    XMLDecoder decoder{read_types(), header_callback(), buffer_callback()};
 
                     while (!input_done()) {
                         std::string data = get_input();
-                        parser(data, input_done());
+                        decoder.parse(data, input_done());
                         if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
                             break;
                         }
                     }
 
-                    mark_header_as_done();
+                    decoder.mark_header_as_done();
+                    send_remaining_buffer(decoder);
+                }
+
+                void submit_chunk(std::string&& data, bool is_change_file, std::string& section, bool last) {
+                    std::string prefix{is_change_file ? "<osmChange version=\"0.6\">" : "<osm version=\"0.6\">"};
+                    if (!section.empty()) {
+                        prefix += '<';
+                        prefix += section;
+                        prefix += '>';
+                    }
+
+                    if (is_change_file) {
+                        update_change_section(data.data(), data.data() + data.size(), section);
+                    }
+
+                    // The last chunk contains the end tags from the input.
+                    std::string suffix;
+                    if (!last) {
+                        if (!section.empty()) {
+                            suffix += "</";
+                            suffix += section;
+                            suffix += '>';
+                        }
+                        suffix += is_change_file ? "</osmChange>" : "</osm>";
+                    }
+
+                    const auto estimated_size = data.size();
+                    XMLChunkDecoder chunk_decoder{std::move(prefix), std::move(data), std::move(suffix), read_types()};
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(std::move(chunk_decoder), osmium::thread::task_priority::high), estimated_size);
+                }
 
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
+                /**
+                 * Parse the input in parallel. Everything up to the first
+                 * OSM object is parsed here to get the header. The rest of
+                 * the input is split into chunks at the start tags of OSM
+                 * objects and the chunks are parsed on the thread pool. The
+                 * results are queued in order.
+                 */
+                void run_parallel() {
+                    std::string data;
+                    std::string section;
+                    bool is_change_file = false;
+
+                    {
+                        XMLDecoder decoder{read_types(), header_callback(), buffer_callback()};
+
+                        size_t pos;
+                        while ((pos = find_first_object_start(data)) == std::string::npos) {
+                            if (input_done()) {
+                                // No objects in input, parse everything here.
+                                decoder.parse(data, true);
+                                decoder.mark_header_as_done();
+                                send_remaining_buffer(decoder);
+                                return;
+                            }
+                            data += get_input();
+                        }
+
+                        decoder.parse(data.data(), pos, false);
+                        decoder.mark_header_as_done();
+
+                        if (read_types() == osmium::osm_entity_bits::nothing) {
+                            return;
+                        }
+
+                        is_change_file = decoder.header().has_multiple_object_versions();
+                        if (is_change_file) {
+                            update_change_section(data.data(), data.data() + pos, section);
+                        }
+                        data.erase(0, pos);
+                    }
+
+                    while (!input_done()) {
+                        data += get_input();
+                        if (data.size() >= chunk_size && !input_done()) {
+                            const auto pos = find_last_object_start(data);
+                            if (pos != std::string::npos && pos > 0) {
+                                std::string rest{data.substr(pos)};
+                                data.resize(pos);
+
+                                using std::swap;
+                                swap(data, rest);
+
+                                submit_chunk(std::move(rest), is_change_file, section, false);
+                            }
+                        }
+                    }
+
+                    submit_chunk(std::move(data), is_change_file, section, true);
+                }
+
+            public:
+
+                XMLParser(future_string_queue_type& input_queue,
+                          future_buffer_queue_type& output_queue,
+                          std::promise<osmium::io::Header>& header_promise,
+                          osmium::osm_entity_bits::type read_types) :
+                    Parser(input_queue, output_queue, header_promise, read_types) {
+                }
+
+                ~XMLParser() noexcept final = default;
+
+                void run() final {
+                    osmium::thread::set_thread_name("_osmium_xml_in");
+
+                    if (osmium::config::use_pool_threads_for_xml_parsing()) {
+                        run_parallel();
+                    } else {
+                        run_sequential();
                     }
                 }
 
@@ -453,7 +453,8 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(osmium::thread::Pool::instance().submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    const auto size = buffer.committed();
+                    send_to_output_queue(osmium::thread::Pool::instance().submit(XMLOutputBlock{std::move(buffer), m_options}), size);
                 }
 
                 void write_end() final {
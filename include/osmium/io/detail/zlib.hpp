@@ -33,12 +33,19 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 #include <zlib.h>
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+# include <libdeflate.h>
+#endif
+
 #include <osmium/io/error.hpp>
 #include <osmium/util/cast.hpp>
 
@@ -49,37 +56,177 @@ namespace osmium {
         namespace detail {
 
             /**
-             * Compress data using zlib.
+             * Codec for the zlib compressed data in PBF blobs using the
+             * stock zlib library.
              *
-             * Note that this function can not compress data larger than
-             * what fits in an unsigned long, on Windows this is usually 32bit.
+             * A blob codec is a class with two static functions:
              *
-             * @param input Data to compress.
-             * @returns Compressed data.
+             * std::string compress(const std::string& input, int level):
+             *   Compress input into a zlib stream (RFC 1950). The level is
+             *   from 0 to 9 or -1 for the default level.
+             *
+             * void uncompress(const char* input, size_t input_size,
+             *                 char* output, size_t raw_size): Uncompress
+             *   the zlib stream in input into output which has exactly
+             *   the size of the uncompressed data. Throws io_error on error.
+             *
+             * The codec used is chosen at compile time: Define
+             * OSMIUM_PBF_BLOB_CODEC to the name of your own codec class
+             * before including any libosmium headers, or define
+             * OSMIUM_WITH_LIBDEFLATE to use the libdeflate library.
+             */
+            struct zlib_blob_codec {
+
+                static const char* name() noexcept {
+                    return "zlib";
+                }
+
+                static std::string compress(const std::string& input, int level) {
+                    unsigned long output_size = ::compressBound(osmium::static_cast_with_assert<unsigned long>(input.size()));
+
+                    std::string output(output_size, '\0');
+
+                    auto result = ::compress2(
+                        reinterpret_cast<unsigned char*>(const_cast<char *>(output.data())),
+                        &output_size,
+                        reinterpret_cast<const unsigned char*>(input.data()),
+                        osmium::static_cast_with_assert<unsigned long>(input.size()),
+                        level
+                    );
+
+                    if (result != Z_OK) {
+                        throw io_error(std::string("failed to compress data: ") + zError(result));
+                    }
+
+                    output.resize(output_size);
+
+                    return output;
+                }
+
+                static void uncompress(const char* input, size_t input_size, char* output, size_t raw_size) {
+                    unsigned long output_size = osmium::static_cast_with_assert<unsigned long>(raw_size);
+
+                    auto result = ::uncompress(
+                        reinterpret_cast<unsigned char*>(output),
+                        &output_size,
+                        reinterpret_cast<const unsigned char*>(input),
+                        osmium::static_cast_with_assert<unsigned long>(input_size)
+                    );
+
+                    if (result != Z_OK) {
+                        throw io_error(std::string("failed to uncompress data: ") + zError(result));
+                    }
+                }
+
+            }; // struct zlib_blob_codec
+
+#ifdef OSMIUM_WITH_LIBDEFLATE
+            /**
+             * Codec for the zlib compressed data in PBF blobs using the
+             * libdeflate library. It works on whole buffers only, which is
+             * all we need for PBF blobs, and is much faster than zlib. The
+             * (de)compressor objects are allocated once per thread.
              */
-            inline std::string zlib_compress(const std::string& input) {
-                unsigned long output_size = ::compressBound(osmium::static_cast_with_assert<unsigned long>(input.size()));
+            struct libdeflate_blob_codec {
+
+                static const char* name() noexcept {
+                    return "libdeflate";
+                }
+
+                // Same compression level as the default of zlib.
+                enum {
+                    default_compression_level = 6
+                };
 
-                std::string output(output_size, '\0');
+                static libdeflate_compressor* compressor(int level) {
+                    struct deleter {
+                        void operator()(libdeflate_compressor* c) const noexcept {
+                            libdeflate_free_compressor(c);
+                        }
+                    };
+                    if (level < 0) {
+                        level = default_compression_level;
+                    }
+                    // one compressor per thread, created again if the level changes
+                    static thread_local std::unique_ptr<libdeflate_compressor, deleter> c;
+                    static thread_local int c_level = -1;
+                    if (!c || c_level != level) {
+                        c.reset(libdeflate_alloc_compressor(level));
+                        if (!c) {
+                            throw io_error{"failed to create libdeflate compressor"};
+                        }
+                        c_level = level;
+                    }
+                    return c.get();
+                }
+
+                static libdeflate_decompressor* decompressor() {
+                    struct deleter {
+                        void operator()(libdeflate_decompressor* d) const noexcept {
+                            libdeflate_free_decompressor(d);
+                        }
+                    };
+                    static thread_local std::unique_ptr<libdeflate_decompressor, deleter> d{libdeflate_alloc_decompressor()};
+                    if (!d) {
+                        throw io_error{"failed to create libdeflate decompressor"};
+                    }
+                    return d.get();
+                }
+
+                static std::string compress(const std::string& input, int level) {
+                    libdeflate_compressor* c = compressor(level);
+
+                    std::string output(libdeflate_zlib_compress_bound(c, input.size()), '\0');
+
+                    const size_t size = libdeflate_zlib_compress(c, input.data(), input.size(), &output[0], output.size());
+                    if (size == 0) {
+                        throw io_error{"failed to compress data"};
+                    }
+
+                    output.resize(size);
+
+                    return output;
+                }
 
-                auto result = ::compress(
-                    reinterpret_cast<unsigned char*>(const_cast<char *>(output.data())),
-                    &output_size,
-                    reinterpret_cast<const unsigned char*>(input.data()),
-                    osmium::static_cast_with_assert<unsigned long>(input.size())
-                );
+                static void uncompress(const char* input, size_t input_size, char* output, size_t raw_size) {
+                    const auto result = libdeflate_zlib_decompress(decompressor(), input, input_size, output, raw_size, nullptr);
 
-                if (result != Z_OK) {
-                    throw io_error(std::string("failed to compress data: ") + zError(result));
+                    if (result != LIBDEFLATE_SUCCESS) {
+                        throw io_error{"failed to uncompress data"};
+                    }
                 }
 
-                output.resize(output_size);
+            }; // struct libdeflate_blob_codec
+#endif
 
-                return output;
+#ifndef OSMIUM_PBF_BLOB_CODEC
+# ifdef OSMIUM_WITH_LIBDEFLATE
+#  define OSMIUM_PBF_BLOB_CODEC osmium::io::detail::libdeflate_blob_codec
+# else
+#  define OSMIUM_PBF_BLOB_CODEC osmium::io::detail::zlib_blob_codec
+# endif
+#endif
+
+            /// The codec used for PBF blobs, see zlib_blob_codec.
+            using blob_codec = OSMIUM_PBF_BLOB_CODEC;
+
+            /**
+             * Compress data into a zlib stream using the configured
+             * blob_codec.
+             *
+             * Note that this function can not compress data larger than
+             * what fits in an unsigned long, on Windows this is usually 32bit.
+             *
+             * @param input Data to compress.
+             * @param level Compression level (0 to 9, -1 for default).
+             * @returns Compressed data.
+             */
+            inline std::string zlib_compress(const std::string& input, int level = Z_DEFAULT_COMPRESSION) {
+                return blob_codec::compress(input, level);
             }
 
             /**
-             * Uncompress data using zlib.
+             * Uncompress a zlib stream using the configured blob_codec.
              *
              * Note that this function can not uncompress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
@@ -92,20 +239,104 @@ namespace osmium {
             inline std::pair<const char*, size_t> zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) {
                 output.resize(raw_size);
 
-                auto result = ::uncompress(
-                    reinterpret_cast<unsigned char*>(&*output.begin()),
-                    &raw_size,
-                    reinterpret_cast<const unsigned char*>(input),
-                    input_size
-                );
-
-                if (result != Z_OK) {
-                    throw io_error(std::string("failed to uncompress data: ") + zError(result));
-                }
+                blob_codec::uncompress(input, input_size, &*output.begin(), raw_size);
 
                 return std::make_pair(output.data(), output.size());
             }
 
+            /**
+             * Incrementally uncompress zlib compressed data, for instance
+             * to look at the beginning of the data without uncompressing
+             * all of it. Data is uncompressed into a small internal buffer
+             * as needed.
+             */
+            class ZlibInflateStream {
+
+                static constexpr const size_t buffer_size = 16 * 1024;
+
+                z_stream m_stream{};
+                char m_buffer[buffer_size];
+                const char* m_ptr = m_buffer;
+                const char* m_end = m_buffer;
+                bool m_done = false;
+
+                bool fill() {
+                    if (m_done) {
+                        return false;
+                    }
+
+                    m_stream.next_out = reinterpret_cast<unsigned char*>(m_buffer);
+                    m_stream.avail_out = static_cast<uInt>(buffer_size);
+
+                    const auto result = ::inflate(&m_stream, Z_NO_FLUSH);
+                    if (result == Z_STREAM_END || result == Z_BUF_ERROR) {
+                        // Z_BUF_ERROR: no progress possible, input is truncated
+                        m_done = true;
+                    } else if (result != Z_OK) {
+                        throw io_error(std::string("failed to uncompress data: ") + zError(result));
+                    }
+
+                    m_ptr = m_buffer;
+                    m_end = m_buffer + (buffer_size - m_stream.avail_out);
+                    return m_ptr != m_end;
+                }
+
+            public:
+
+                ZlibInflateStream(const char* input, size_t input_size) {
+                    m_stream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(input));
+                    m_stream.avail_in = osmium::static_cast_with_assert<uInt>(input_size);
+
+                    const auto result = ::inflateInit(&m_stream);
+                    if (result != Z_OK) {
+                        throw io_error(std::string("failed to uncompress data: ") + zError(result));
+                    }
+                }
+
+                ZlibInflateStream(const ZlibInflateStream&) = delete;
+                ZlibInflateStream& operator=(const ZlibInflateStream&) = delete;
+
+                ZlibInflateStream(ZlibInflateStream&&) = delete;
+                ZlibInflateStream& operator=(ZlibInflateStream&&) = delete;
+
+                ~ZlibInflateStream() noexcept {
+                    ::inflateEnd(&m_stream);
+                }
+
+                /**
+                 * Get the next uncompressed byte.
+                 *
+                 * @returns false if there is no more data.
+                 */
+                bool get(unsigned char& byte) {
+                    if (m_ptr == m_end && !fill()) {
+                        return false;
+                    }
+                    byte = static_cast<unsigned char>(*m_ptr++);
+                    return true;
+                }
+
+                /**
+                 * Skip the next size bytes of uncompressed data. They
+                 * still have to be uncompressed, but they are not stored.
+                 *
+                 * @returns false if there is not enough data.
+                 */
+                bool skip(uint64_t size) {
+                    while (size > 0) {
+                        if (m_ptr == m_end && !fill()) {
+                            return false;
+                        }
+                        const auto available = static_cast<uint64_t>(m_end - m_ptr);
+                        const auto n = size < available ? size : available;
+                        m_ptr += n;
+                        size -= n;
+                    }
+                    return true;
+                }
+
+            }; // class ZlibInflateStream
+
         } // namespace detail
 
     } // namespace io
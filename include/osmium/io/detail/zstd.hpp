@@ -0,0 +1,154 @@
+#ifndef OSMIUM_IO_DETAIL_ZSTD_HPP
+#define OSMIUM_IO_DETAIL_ZSTD_HPP
+
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef OSMIUM_WITH_ZSTD
+# include <zstd.h>
+#endif
+
+#include <osmium/io/error.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Is zstd compression available? This is the case if libosmium
+             * was compiled with OSMIUM_WITH_ZSTD defined.
+             */
+            constexpr bool zstd_available() noexcept {
+#ifdef OSMIUM_WITH_ZSTD
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            /**
+             * The smallest compression level zstd accepts. Negative levels
+             * are faster but compress less.
+             */
+            inline int zstd_min_compression_level() noexcept {
+#if defined(OSMIUM_WITH_ZSTD) && ZSTD_VERSION_NUMBER >= 10400
+                return ZSTD_minCLevel();
+#else
+                return -(1 << 17);
+#endif
+            }
+
+            /**
+             * The largest compression level zstd accepts.
+             */
+            inline int zstd_max_compression_level() noexcept {
+#ifdef OSMIUM_WITH_ZSTD
+                return ZSTD_maxCLevel();
+#else
+                return 22;
+#endif
+            }
+
+            /**
+             * Compress data using zstd.
+             *
+             * @param input Data to compress.
+             * @param level Compression level. 0 is the zstd default.
+             * @returns Compressed data.
+             * @throws io_error If zstd is not available or compression fails.
+             */
+            inline std::string zstd_compress(const std::string& input, int level = 0) {
+#ifdef OSMIUM_WITH_ZSTD
+                std::string output(ZSTD_compressBound(input.size()), '\0');
+
+                const std::size_t size = ZSTD_compress(&output[0], output.size(), input.data(), input.size(), level);
+                if (ZSTD_isError(size)) {
+                    throw io_error{std::string{"failed to compress data with zstd: "} + ZSTD_getErrorName(size)};
+                }
+
+                output.resize(size);
+
+                return output;
+#else
+                (void)input;
+                (void)level;
+                throw io_error{"zstd compression not available (compile with OSMIUM_WITH_ZSTD)"};
+#endif
+            }
+
+            /**
+             * Uncompress data using zstd.
+             *
+             * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to uncompressed data.
+             * @throws io_error If zstd is not available or the data is
+             *         corrupted.
+             */
+            inline std::pair<const char*, std::size_t> zstd_uncompress_string(const char* input, std::size_t input_size, std::size_t raw_size, std::string& output) {
+#ifdef OSMIUM_WITH_ZSTD
+                output.resize(raw_size);
+
+                const std::size_t size = ZSTD_decompress(&output[0], raw_size, input, input_size);
+                if (ZSTD_isError(size)) {
+                    throw io_error{std::string{"failed to uncompress zstd data: "} + ZSTD_getErrorName(size)};
+                }
+                if (size != raw_size) {
+                    throw io_error{"failed to uncompress zstd data: wrong size"};
+                }
+
+                return std::make_pair(output.data(), output.size());
+#else
+                (void)input;
+                (void)input_size;
+                (void)raw_size;
+                (void)output;
+                throw io_error{"zstd compression not available (compile with OSMIUM_WITH_ZSTD)"};
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_ZSTD_HPP
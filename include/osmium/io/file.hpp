@@ -219,9 +219,13 @@ namespace osmium {
                 } else if (suffixes.back() == "opl") {
                     m_file_format = file_format::opl;
                     suffixes.pop_back();
-                } else if (suffixes.back() == "json") {
+                } else if (suffixes.back() == "json" || suffixes.back() == "geojson") {
                     m_file_format = file_format::json;
                     suffixes.pop_back();
+                } else if (suffixes.back() == "geojsonseq") {
+                    m_file_format = file_format::json;
+                    set("json_seq", true);
+                    suffixes.pop_back();
                 } else if (suffixes.back() == "o5m") {
                     m_file_format = file_format::o5m;
                     suffixes.pop_back();
@@ -42,8 +42,15 @@ DEALINGS IN THE SOFTWARE.
  * @attention If you include this file, you'll need to link with `libz`.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 
 #include <errno.h>
 #include <zlib.h>
@@ -52,8 +59,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/cast.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/config.hpp>
 
 namespace osmium {
 
@@ -253,13 +262,510 @@ namespace osmium {
 
         }; // class GzipBufferDecompressor
 
+        namespace detail {
+
+            /// Maximum number of uncompressed bytes in one BGZF block.
+            constexpr const size_t bgzf_max_input_size = 0xff00;
+
+            /// Maximum size of one (compressed) BGZF block.
+            constexpr const size_t bgzf_max_block_size = 0x10000;
+
+            /// Maximum number of uncompressed bytes in a BGZF block we read.
+            constexpr const size_t bgzf_max_uncompressed_size = 0x10000;
+
+            /// Size of the header of a BGZF block.
+            constexpr const size_t bgzf_header_size = 18;
+
+            /// Number of bytes compressed or uncompressed in one Pool task.
+            constexpr const size_t gzip_chunk_size = 1024 * 1024;
+
+            inline uint32_t get_le32(const char* data) noexcept {
+                const auto d = reinterpret_cast<const unsigned char*>(data);
+                return uint32_t(d[0]) | (uint32_t(d[1]) << 8) | (uint32_t(d[2]) << 16) | (uint32_t(d[3]) << 24);
+            }
+
+            inline void append_le32(std::string& out, uint32_t value) {
+                out += static_cast<char>(value & 0xff);
+                out += static_cast<char>((value >> 8) & 0xff);
+                out += static_cast<char>((value >> 16) & 0xff);
+                out += static_cast<char>((value >> 24) & 0xff);
+            }
+
+            /**
+             * Check whether the data starts with a BGZF block, ie. a gzip
+             * member with a "BC" extra field containing the size of the
+             * member. These are written by bgzip and the
+             * GzipParallelCompressor.
+             *
+             * @returns The size of the block or 0 if this is not a BGZF
+             *          block (or the header is incomplete).
+             * @throws osmium::gzip_error If the block size is too small for
+             *         the header and trailer of the block.
+             */
+            inline size_t bgzf_block_size(const char* data, size_t size) {
+                const auto d = reinterpret_cast<const unsigned char*>(data);
+                if (size < 12 || d[0] != 0x1f || d[1] != 0x8b || d[2] != 8 || !(d[3] & 0x04)) {
+                    return 0;
+                }
+
+                const size_t end = 12 + (size_t(d[10]) | (size_t(d[11]) << 8));
+                if (size < end) {
+                    return 0;
+                }
+
+                size_t pos = 12;
+                while (pos + 4 <= end) {
+                    const size_t slen = size_t(d[pos + 2]) | (size_t(d[pos + 3]) << 8);
+                    if (d[pos] == 'B' && d[pos + 1] == 'C' && slen == 2 && pos + 6 <= end) {
+                        const size_t block_size = (size_t(d[pos + 4]) | (size_t(d[pos + 5]) << 8)) + 1;
+                        // 8 bytes trailer (CRC32 and uncompressed size)
+                        if (block_size < end + 8) {
+                            throw osmium::gzip_error("gzip error: BGZF block size too small", 0);
+                        }
+                        return block_size;
+                    }
+                    pos += 4 + slen;
+                }
+
+                return 0;
+            }
+
+            /**
+             * Compress data into one BGZF block which is appended to the
+             * output. The data must not be larger than bgzf_max_input_size.
+             */
+            inline void bgzf_compress_block(const char* data, size_t size, std::string& output) {
+                assert(size <= bgzf_max_input_size);
+
+                z_stream stream{};
+                int result = ::deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                if (result != Z_OK) {
+                    throw osmium::gzip_error("gzip error: compression init failed", result);
+                }
+
+                const size_t start = output.size();
+                static const char header[bgzf_header_size] = {
+                    '\x1f', '\x8b', 8, 4,    // magic, method, flags (FEXTRA)
+                    0, 0, 0, 0,              // mtime
+                    0, '\xff',                // extra flags, OS (unknown)
+                    6, 0,                    // length of extra field
+                    'B', 'C', 2, 0,          // BGZF subfield
+                    0, 0                     // block size - 1, filled in below
+                };
+                output.append(header, bgzf_header_size);
+
+                const size_t bound = ::deflateBound(&stream, static_cast_with_assert<uLong>(size));
+                output.resize(start + bgzf_header_size + bound);
+
+                stream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                stream.avail_in = static_cast_with_assert<uInt>(size);
+                stream.next_out = reinterpret_cast<unsigned char*>(&output[start + bgzf_header_size]);
+                stream.avail_out = static_cast_with_assert<uInt>(bound);
+
+                result = ::deflate(&stream, Z_FINISH);
+                const size_t compressed_size = bound - stream.avail_out;
+                ::deflateEnd(&stream);
+
+                if (result != Z_STREAM_END) {
+                    throw osmium::gzip_error("gzip error: compression failed", result);
+                }
+
+                output.resize(start + bgzf_header_size + compressed_size);
+                append_le32(output, static_cast<uint32_t>(::crc32(0, reinterpret_cast<const unsigned char*>(data), static_cast_with_assert<uInt>(size))));
+                append_le32(output, static_cast<uint32_t>(size));
+
+                const size_t block_size = output.size() - start - 1;
+                assert(block_size < bgzf_max_block_size);
+                output[start + 16] = static_cast<char>(block_size & 0xff);
+                output[start + 17] = static_cast<char>((block_size >> 8) & 0xff);
+            }
+
+            /**
+             * Uncompress one complete BGZF block and append the result to
+             * the output.
+             *
+             * @throws osmium::gzip_error If the block is invalid or its
+             *         uncompressed size is larger than allowed for BGZF.
+             */
+            inline void bgzf_decompress_block(const char* data, size_t size, std::string& output) {
+                if (size < bgzf_header_size + 8) {
+                    throw osmium::gzip_error("gzip error: BGZF block size too small", 0);
+                }
+                const uint32_t raw_size = get_le32(data + size - 4);
+                if (raw_size > bgzf_max_uncompressed_size) {
+                    throw osmium::gzip_error("gzip error: BGZF block uncompressed size too large", 0);
+                }
+                const size_t start = output.size();
+
+                // one extra byte, so that avail_out is never 0
+                output.resize(start + raw_size + 1);
+
+                z_stream stream{};
+                stream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                stream.avail_in = static_cast_with_assert<uInt>(size);
+                stream.next_out = reinterpret_cast<unsigned char*>(&output[start]);
+                stream.avail_out = static_cast_with_assert<uInt>(raw_size + 1);
+
+                int result = ::inflateInit2(&stream, MAX_WBITS + 16);
+                if (result != Z_OK) {
+                    throw osmium::gzip_error("gzip error: decompression init failed", result);
+                }
+
+                result = ::inflate(&stream, Z_FINISH);
+                const bool size_ok = stream.avail_out == 1 && stream.avail_in == 0;
+                ::inflateEnd(&stream);
+
+                if (result != Z_STREAM_END || !size_ok) {
+                    throw osmium::gzip_error("gzip error: BGZF block decompression failed", result);
+                }
+
+                output.resize(start + raw_size);
+            }
+
+            /**
+             * Functor compressing data into BGZF blocks. Runs in the Pool.
+             */
+            class BgzfCompressTask {
+
+                std::string m_data;
+
+            public:
+
+                explicit BgzfCompressTask(std::string&& data) :
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    std::string output;
+                    output.reserve(m_data.size() / 2);
+                    for (size_t pos = 0; pos < m_data.size(); pos += bgzf_max_input_size) {
+                        bgzf_compress_block(m_data.data() + pos, std::min(bgzf_max_input_size, m_data.size() - pos), output);
+                    }
+                    return output;
+                }
+
+            }; // class BgzfCompressTask
+
+            /**
+             * Functor uncompressing complete BGZF blocks. Runs in the Pool.
+             */
+            class BgzfDecompressTask {
+
+                std::string m_data;
+
+            public:
+
+                explicit BgzfDecompressTask(std::string&& data) :
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    std::string output;
+                    size_t pos = 0;
+                    while (pos < m_data.size()) {
+                        const size_t size = bgzf_block_size(m_data.data() + pos, m_data.size() - pos);
+                        assert(size > 0 && size <= m_data.size() - pos);
+                        bgzf_decompress_block(m_data.data() + pos, size, output);
+                        pos += size;
+                    }
+                    return output;
+                }
+
+            }; // class BgzfDecompressTask
+
+            inline size_t max_pending_gzip_tasks() {
+                return 2 * size_t(osmium::thread::Pool::instance().num_threads());
+            }
+
+        } // namespace detail
+
+        /**
+         * Gzip compressor using the thread pool. It writes the data as a
+         * series of BGZF blocks (small gzip members with an extra field
+         * containing their size, see the SAM/BAM specification). The
+         * result is a normal gzip file that can be read by any gzip
+         * implementation, but it can also be uncompressed in parallel by
+         * the GzipParallelDecompressor. It is slightly larger than the
+         * output of the GzipCompressor.
+         */
+        class GzipParallelCompressor : public Compressor {
+
+            int m_fd;
+            std::string m_buffer;
+            std::deque<std::future<std::string>> m_pending;
+            size_t m_max_pending;
+
+            void write_front() {
+                const std::string data = m_pending.front().get();
+                m_pending.pop_front();
+                osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+            }
+
+            void submit_buffer() {
+                m_pending.push_back(osmium::thread::Pool::instance().submit(detail::BgzfCompressTask{std::move(m_buffer)}));
+                m_buffer.clear();
+                while (m_pending.size() > m_max_pending) {
+                    write_front();
+                }
+            }
+
+        public:
+
+            GzipParallelCompressor(int fd, fsync sync) :
+                Compressor(sync),
+                m_fd(fd),
+                m_buffer(),
+                m_pending(),
+                m_max_pending(detail::max_pending_gzip_tasks()) {
+            }
+
+            ~GzipParallelCompressor() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            void write(const std::string& data) final {
+                m_buffer += data;
+                if (m_buffer.size() >= detail::gzip_chunk_size) {
+                    submit_buffer();
+                }
+            }
+
+            void close() final {
+                if (m_fd >= 0) {
+                    try {
+                        if (!m_buffer.empty()) {
+                            submit_buffer();
+                        }
+                        while (!m_pending.empty()) {
+                            write_front();
+                        }
+
+                        // empty block marks the end of a BGZF file
+                        std::string eof_block;
+                        detail::bgzf_compress_block(nullptr, 0, eof_block);
+                        osmium::io::detail::reliable_write(m_fd, eof_block.data(), eof_block.size());
+
+                        if (do_fsync()) {
+                            osmium::io::detail::reliable_fsync(m_fd);
+                        }
+                    } catch (...) {
+                        const int fd = m_fd;
+                        m_fd = -1;
+                        ::close(fd);
+                        throw;
+                    }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class GzipParallelCompressor
+
+        /**
+         * Gzip decompressor using the thread pool. Files consisting of BGZF
+         * blocks (written by bgzip or the GzipParallelCompressor) are
+         * uncompressed in parallel. Other gzip files (or the rest of the
+         * file after the first member that is not a BGZF block) are
+         * uncompressed sequentially. This includes multi-member gzip files
+         * that are not BGZF, because their members don't record their
+         * compressed size, so the member boundaries are only known after
+         * uncompressing them.
+         */
+        class GzipParallelDecompressor : public Decompressor {
+
+            int m_fd;
+
+            // Compressed data read from the file but not handled yet.
+            std::string m_input;
+            bool m_input_done;
+
+            std::deque<std::future<std::string>> m_pending;
+            size_t m_max_pending;
+
+            // Set to false once we have seen a gzip member that is not
+            // a BGZF block. From then on we read sequentially.
+            bool m_bgzf;
+
+            // Used for sequential reading only.
+            z_stream m_zstream;
+            bool m_zstream_active;
+            bool m_first_member;
+
+            void fill_input(size_t min_size) {
+                while (!m_input_done && m_input.size() < min_size) {
+                    const size_t old_size = m_input.size();
+                    m_input.resize(old_size + osmium::io::Decompressor::input_buffer_size);
+                    const auto nread = ::read(m_fd, &m_input[old_size], osmium::io::Decompressor::input_buffer_size);
+                    if (nread < 0) {
+                        m_input.resize(old_size);
+                        throw std::system_error(errno, std::system_category(), "Read failed");
+                    }
+                    m_input.resize(old_size + std::string::size_type(nread));
+                    if (nread == 0) {
+                        m_input_done = true;
+                    }
+                }
+            }
+
+            // Submit a task for the complete BGZF blocks at the beginning
+            // of the input. Returns false if there are none.
+            bool submit_blocks() {
+                fill_input(detail::gzip_chunk_size + detail::bgzf_max_block_size);
+
+                size_t pos = 0;
+                while (pos < detail::gzip_chunk_size) {
+                    const size_t size = detail::bgzf_block_size(m_input.data() + pos, m_input.size() - pos);
+                    if (size == 0 || size > m_input.size() - pos) {
+                        break;
+                    }
+                    pos += size;
+                }
+
+                if (pos == 0) {
+                    m_bgzf = false;
+                    return false;
+                }
+
+                m_pending.push_back(osmium::thread::Pool::instance().submit(detail::BgzfDecompressTask{m_input.substr(0, pos)}, osmium::thread::task_priority::high));
+                m_input.erase(0, pos);
+                return true;
+            }
+
+            std::string read_sequential() {
+                std::string output;
+
+                while (output.empty()) {
+                    fill_input(1);
+
+                    if (!m_zstream_active) {
+                        fill_input(2);
+                        if (m_input.size() < 2 || m_input[0] != '\x1f' || m_input[1] != '\x8b') {
+                            if (m_first_member && !m_input.empty()) {
+                                throw osmium::gzip_error("gzip error: not in gzip format", Z_DATA_ERROR);
+                            }
+                            // end of data, ignore trailing garbage
+                            m_input.clear();
+                            return output;
+                        }
+                        const int result = ::inflateInit2(&m_zstream, MAX_WBITS + 16);
+                        if (result != Z_OK) {
+                            throw osmium::gzip_error("gzip error: decompression init failed", result);
+                        }
+                        m_zstream_active = true;
+                        m_first_member = false;
+                    }
+
+                    if (m_input.empty()) {
+                        throw osmium::gzip_error("gzip error: unexpected end of file", Z_BUF_ERROR);
+                    }
+
+                    output.resize(osmium::io::Decompressor::input_buffer_size);
+                    m_zstream.next_in = reinterpret_cast<unsigned char*>(&m_input[0]);
+                    m_zstream.avail_in = static_cast_with_assert<uInt>(m_input.size());
+                    m_zstream.next_out = reinterpret_cast<unsigned char*>(&output[0]);
+                    m_zstream.avail_out = static_cast_with_assert<uInt>(output.size());
+
+                    const int result = ::inflate(&m_zstream, Z_NO_FLUSH);
+
+                    m_input.erase(0, m_input.size() - m_zstream.avail_in);
+                    output.resize(output.size() - m_zstream.avail_out);
+
+                    if (result == Z_STREAM_END) {
+                        ::inflateEnd(&m_zstream);
+                        m_zstream_active = false;
+                    } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                        std::string message("gzip error: inflate failed: ");
+                        if (m_zstream.msg) {
+                            message.append(m_zstream.msg);
+                        }
+                        throw osmium::gzip_error(message, result);
+                    }
+                }
+
+                return output;
+            }
+
+        public:
+
+            explicit GzipParallelDecompressor(int fd) :
+                Decompressor(),
+                m_fd(fd),
+                m_input(),
+                m_input_done(false),
+                m_pending(),
+                m_max_pending(detail::max_pending_gzip_tasks()),
+                m_bgzf(true),
+                m_zstream(),
+                m_zstream_active(false),
+                m_first_member(true) {
+            }
+
+            ~GzipParallelDecompressor() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() final {
+                while (true) {
+                    while (m_bgzf && m_pending.size() < m_max_pending) {
+                        if (!submit_blocks()) {
+                            break;
+                        }
+                        m_first_member = false;
+                    }
+
+                    if (m_pending.empty()) {
+                        return read_sequential();
+                    }
+
+                    std::string output = m_pending.front().get();
+                    m_pending.pop_front();
+                    if (!output.empty()) {
+                        return output;
+                    }
+                }
+            }
+
+            void close() final {
+                if (m_zstream_active) {
+                    ::inflateEnd(&m_zstream);
+                    m_zstream_active = false;
+                }
+                m_pending.clear();
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class GzipParallelDecompressor
+
         namespace detail {
 
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_gzip_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::gzip,
-                [](int fd, fsync sync) { return new osmium::io::GzipCompressor(fd, sync); },
-                [](int fd) { return new osmium::io::GzipDecompressor(fd); },
+                [](int fd, fsync sync) -> osmium::io::Compressor* {
+                    if (osmium::config::use_pool_threads_for_gzip()) {
+                        return new osmium::io::GzipParallelCompressor(fd, sync);
+                    }
+                    return new osmium::io::GzipCompressor(fd, sync);
+                },
+                [](int fd) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_pool_threads_for_gzip()) {
+                        return new osmium::io::GzipParallelDecompressor(fd);
+                    }
+                    return new osmium::io::GzipDecompressor(fd);
+                },
                 [](const char* buffer, size_t size) { return new osmium::io::GzipBufferDecompressor(buffer, size); }
             );
 
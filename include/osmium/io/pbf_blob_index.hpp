@@ -0,0 +1,483 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <protozero/pbf_message.hpp>
+
+#include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Information about one OSMData blob in a PBF file.
+         */
+        struct pbf_blob_info {
+
+            /// Offset of the blob (its BlobHeader size field) in the file.
+            uint64_t offset = 0;
+
+            /// The types of the OSM entities in this blob.
+            osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+            /// Smallest ID of the nodes, ways, and relations in this blob.
+            std::array<osmium::object_id_type, 3> min_ids{{
+                std::numeric_limits<osmium::object_id_type>::max(),
+                std::numeric_limits<osmium::object_id_type>::max(),
+                std::numeric_limits<osmium::object_id_type>::max()
+            }};
+
+            /// Largest ID of the nodes, ways, and relations in this blob.
+            std::array<osmium::object_id_type, 3> max_ids{{
+                std::numeric_limits<osmium::object_id_type>::min(),
+                std::numeric_limits<osmium::object_id_type>::min(),
+                std::numeric_limits<osmium::object_id_type>::min()
+            }};
+
+            /**
+             * Add an object to this blob.
+             *
+             * @param type Type of the object. Must be node, way, or relation.
+             * @param id ID of the object.
+             */
+            void add(osmium::item_type type, osmium::object_id_type id) noexcept {
+                types |= osmium::osm_entity_bits::from_item_type(type);
+                const auto n = osmium::item_type_to_nwr_index(type);
+                if (id < min_ids[n]) {
+                    min_ids[n] = id;
+                }
+                if (id > max_ids[n]) {
+                    max_ids[n] = id;
+                }
+            }
+
+            /**
+             * Smallest ID of the objects of the given type in this blob.
+             *
+             * @param type Must be node, way, or relation.
+             */
+            osmium::object_id_type min_id(osmium::item_type type) const noexcept {
+                return min_ids[osmium::item_type_to_nwr_index(type)];
+            }
+
+            /**
+             * Largest ID of the objects of the given type in this blob.
+             *
+             * @param type Must be node, way, or relation.
+             */
+            osmium::object_id_type max_id(osmium::item_type type) const noexcept {
+                return max_ids[osmium::item_type_to_nwr_index(type)];
+            }
+
+        }; // struct pbf_blob_info
+
+        namespace detail {
+
+            /**
+             * Find out which types of objects and which range of IDs are
+             * in a PrimitiveBlock. Only the IDs are decoded, everything
+             * else is skipped.
+             */
+            inline void scan_primitive_block(const ptr_len_type& data, pbf_blob_info& info) {
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block(data);
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag()) {
+                            case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                                {
+                                    protozero::pbf_message<OSMFormat::Node> pbf_node = pbf_primitive_group.get_message();
+                                    if (pbf_node.next(OSMFormat::Node::required_sint64_id)) {
+                                        info.add(osmium::item_type::node, pbf_node.get_sint64());
+                                    }
+                                }
+                                break;
+                            case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                                {
+                                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes = pbf_primitive_group.get_message();
+                                    if (pbf_dense_nodes.next(OSMFormat::DenseNodes::packed_sint64_id)) {
+                                        const auto ids = pbf_dense_nodes.get_packed_sint64();
+                                        osmium::object_id_type id = 0;
+                                        for (auto it = ids.first; it != ids.second; ++it) {
+                                            id += *it;
+                                            info.add(osmium::item_type::node, id);
+                                        }
+                                    }
+                                }
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                                {
+                                    protozero::pbf_message<OSMFormat::Way> pbf_way = pbf_primitive_group.get_message();
+                                    if (pbf_way.next(OSMFormat::Way::required_int64_id)) {
+                                        info.add(osmium::item_type::way, pbf_way.get_int64());
+                                    }
+                                }
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                                {
+                                    protozero::pbf_message<OSMFormat::Relation> pbf_relation = pbf_primitive_group.get_message();
+                                    if (pbf_relation.next(OSMFormat::Relation::required_int64_id)) {
+                                        info.add(osmium::item_type::relation, pbf_relation.get_int64());
+                                    }
+                                }
+                                break;
+                            default:
+                                pbf_primitive_group.skip();
+                        }
+                    }
+                }
+            }
+
+            class PBFBlobInfoDecoder {
+
+                std::shared_ptr<const void> m_owner;
+                ptr_len_type m_data;
+                uint64_t m_offset;
+
+            public:
+
+                PBFBlobInfoDecoder(std::shared_ptr<const void> owner, const ptr_len_type& data, uint64_t offset) :
+                    m_owner(std::move(owner)),
+                    m_data(data),
+                    m_offset(offset) {
+                }
+
+                pbf_blob_info operator()() const {
+                    pbf_blob_info info;
+                    info.offset = m_offset;
+
+                    std::string output;
+                    scan_primitive_block(decode_blob(m_data, output), info);
+
+                    return info;
+                }
+
+            }; // class PBFBlobInfoDecoder
+
+        } // namespace detail
+
+        /**
+         * An index of the OSMData blobs in a PBF file. For each blob it
+         * contains the offset in the file, the types of objects in it and
+         * the range of object IDs for each type. It can be used to find the place in a
+         * file where, say, the ways start. This offset can then be given
+         * to the Reader (see osmium::io::start_offset) to skip everything
+         * before it.
+         *
+         * Only uncompressed PBF files (the usual case) can be indexed.
+         *
+         * The index can be saved to and read from a "sidecar" file. By
+         * convention this has the name of the PBF file with ".idx"
+         * appended. See the open() function.
+         */
+        class PBFBlobIndex {
+
+            uint64_t m_file_size = 0;
+            int64_t m_file_mtime = 0;
+            std::vector<pbf_blob_info> m_blobs;
+
+            // Get size and modification time of a file. Returns false if
+            // the file can not be stat'ed.
+            static bool stat_file(const std::string& filename, uint64_t& size, int64_t& mtime) noexcept {
+                struct stat s;
+                if (::stat(filename.c_str(), &s) != 0) {
+                    return false;
+                }
+                size = static_cast<uint64_t>(s.st_size);
+                mtime = static_cast<int64_t>(s.st_mtime);
+                return true;
+            }
+
+            static uint32_t get_size(const char* data) noexcept {
+                uint32_t size_in_network_byte_order;
+                std::memcpy(&size_in_network_byte_order, data, sizeof(size_in_network_byte_order));
+                return ntohl(size_in_network_byte_order);
+            }
+
+            static std::shared_ptr<osmium::util::MemoryMapping> map_file(const std::string& filename) {
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                std::shared_ptr<osmium::util::MemoryMapping> mapping;
+                try {
+                    const size_t size = osmium::util::file_size(fd);
+                    if (size == 0) {
+                        throw osmium::pbf_error("can not index empty or special file");
+                    }
+                    mapping = std::make_shared<osmium::util::MemoryMapping>(size, osmium::util::MemoryMapping::mapping_mode::readonly, fd);
+                } catch (...) {
+                    ::close(fd);
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+                return mapping;
+            }
+
+        public:
+
+            PBFBlobIndex() = default;
+
+            /**
+             * Build index by reading through the given PBF file. The
+             * blobs are decoded in parallel using the thread pool.
+             *
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file can not be opened or
+             *         mapped.
+             */
+            static PBFBlobIndex build(const std::string& filename) {
+                const auto mapping = map_file(filename);
+                const char* data = mapping->get_addr<const char>();
+                const size_t size = mapping->size();
+
+                PBFBlobIndex index;
+                index.m_file_size = size;
+                uint64_t stat_size;
+                stat_file(filename, stat_size, index.m_file_mtime);
+
+                std::vector<std::future<pbf_blob_info>> futures;
+                size_t offset = 0;
+                bool first = true;
+                while (offset < size) {
+                    if (size - offset < sizeof(uint32_t)) {
+                        throw osmium::pbf_error("truncated data (EOF encountered)");
+                    }
+                    const size_t blob_offset = offset;
+                    const uint32_t header_size = get_size(data + offset);
+                    offset += sizeof(uint32_t);
+                    if (header_size > static_cast<uint32_t>(osmium::io::detail::max_blob_header_size) || size - offset < header_size) {
+                        throw osmium::pbf_error("invalid BlobHeader size");
+                    }
+
+                    const size_t blob_size = osmium::io::detail::decode_blob_header(
+                        protozero::pbf_message<osmium::io::detail::FileFormat::BlobHeader>(data + offset, header_size),
+                        first ? "OSMHeader" : "OSMData");
+                    offset += header_size;
+                    if (size - offset < blob_size) {
+                        throw osmium::pbf_error("truncated data (EOF encountered)");
+                    }
+
+                    if (!first) {
+                        osmium::io::detail::PBFBlobInfoDecoder decoder{mapping, osmium::io::detail::ptr_len_type{data + offset, blob_size}, blob_offset};
+                        futures.push_back(osmium::thread::Pool::instance().submit(std::move(decoder), osmium::thread::task_priority::high));
+                    }
+                    offset += blob_size;
+                    first = false;
+                }
+
+                index.m_blobs.reserve(futures.size());
+                for (auto& future : futures) {
+                    index.m_blobs.push_back(future.get());
+                }
+
+                return index;
+            }
+
+            /**
+             * Read index from file.
+             *
+             * @throws osmium::io_error If the file can not be read or is
+             *         not an index file.
+             */
+            static PBFBlobIndex read(const std::string& index_filename) {
+                std::ifstream in{index_filename};
+                if (!in) {
+                    throw osmium::io_error{std::string{"can not open index file '"} + index_filename + "'"};
+                }
+
+                std::string magic;
+                int version = 0;
+                PBFBlobIndex index;
+                in >> magic >> version >> index.m_file_size >> index.m_file_mtime;
+                if (!in || magic != "osmium-pbf-blob-index" || version != 3) {
+                    throw osmium::io_error{std::string{"not a PBF blob index file: '"} + index_filename + "'"};
+                }
+
+                pbf_blob_info info;
+                unsigned int types;
+                while (in >> info.offset >> types
+                          >> info.min_ids[0] >> info.max_ids[0]
+                          >> info.min_ids[1] >> info.max_ids[1]
+                          >> info.min_ids[2] >> info.max_ids[2]) {
+                    info.types = static_cast<osmium::osm_entity_bits::type>(types);
+                    index.m_blobs.push_back(info);
+                }
+                if (!in.eof()) {
+                    throw osmium::io_error{std::string{"error reading PBF blob index file '"} + index_filename + "'"};
+                }
+
+                return index;
+            }
+
+            /**
+             * Write index to file.
+             *
+             * @throws osmium::io_error If the file can not be written.
+             */
+            void write(const std::string& index_filename) const {
+                std::ofstream out{index_filename};
+                out << "osmium-pbf-blob-index 3 " << m_file_size << ' ' << m_file_mtime << '\n';
+                for (const auto& info : m_blobs) {
+                    out << info.offset << ' '
+                        << static_cast<unsigned int>(info.types);
+                    for (std::size_t n = 0; n < 3; ++n) {
+                        out << ' ' << info.min_ids[n] << ' ' << info.max_ids[n];
+                    }
+                    out << '\n';
+                }
+                out.close();
+                if (!out) {
+                    throw osmium::io_error{std::string{"error writing PBF blob index file '"} + index_filename + "'"};
+                }
+            }
+
+            /**
+             * Get the index for a PBF file. If there is a sidecar index
+             * file (filename + ".idx") which was created for a file of the
+             * same size and modification time, it is used. Otherwise the
+             * index is built by reading the PBF file.
+             *
+             * @param filename Name of the PBF file.
+             * @param write_sidecar Write the sidecar index file if it had
+             *                      to be built.
+             */
+            static PBFBlobIndex open(const std::string& filename, bool write_sidecar = false) {
+                const std::string index_filename{filename + ".idx"};
+
+                uint64_t size;
+                int64_t mtime;
+                if (std::ifstream{index_filename} && stat_file(filename, size, mtime)) {
+                    try {
+                        PBFBlobIndex index = read(index_filename);
+                        if (index.file_size() == size && index.file_mtime() == mtime) {
+                            return index;
+                        }
+                    } catch (const osmium::io_error&) {
+                        // ignore broken sidecar file and rebuild
+                    }
+                }
+
+                PBFBlobIndex index = build(filename);
+                if (write_sidecar) {
+                    index.write(index_filename);
+                }
+                return index;
+            }
+
+            /**
+             * Size of the PBF file this index was created from.
+             */
+            uint64_t file_size() const noexcept {
+                return m_file_size;
+            }
+
+            /**
+             * Modification time (in seconds since the epoch) of the PBF
+             * file this index was created from.
+             */
+            int64_t file_mtime() const noexcept {
+                return m_file_mtime;
+            }
+
+            const std::vector<pbf_blob_info>& blobs() const noexcept {
+                return m_blobs;
+            }
+
+            /**
+             * The number of OSMData blobs in the file.
+             */
+            size_t size() const noexcept {
+                return m_blobs.size();
+            }
+
+            /**
+             * Find the offset of the first blob which contains objects of
+             * the given type with IDs larger than or equal to the given ID
+             * or objects of a type that is sorted after the given type.
+             * Only the ID range of the given type is checked, so blobs
+             * with several types of objects are handled correctly.
+             * This assumes the file is sorted in the usual way (first
+             * nodes, then ways, then relations, each sorted by ID).
+             *
+             * @returns Offset which can be used with the start_offset
+             *          option of the Reader. If there is no such blob,
+             *          the size of the file is returned.
+             */
+            uint64_t find(osmium::item_type type, osmium::object_id_type id = std::numeric_limits<osmium::object_id_type>::min()) const noexcept {
+                const auto bits = osmium::osm_entity_bits::from_item_type(type);
+                // bits for the given type and all types sorted before it
+                const auto up_to_bits = static_cast<osmium::osm_entity_bits::type>((bits << 1) - 1);
+                for (const auto& info : m_blobs) {
+                    if ((info.types & bits) && info.max_id(type) >= id) {
+                        return info.offset;
+                    }
+                    if (info.types && !(info.types & up_to_bits)) {
+                        return info.offset;
+                    }
+                }
+                return m_file_size;
+            }
+
+        }; // class PBFBlobIndex
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
@@ -0,0 +1,81 @@
+#ifndef OSMIUM_IO_QUEUE_OPTIONS_HPP
+#define OSMIUM_IO_QUEUE_OPTIONS_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Maximum number of entries (buffers) in each of the queues
+         * between the threads of a Reader or Writer. 0 means: use the
+         * default which depends on the number of threads in the Pool.
+         */
+        struct queue_length {
+
+            size_t value;
+
+            explicit queue_length(size_t length = 0) noexcept :
+                value(length) {
+            }
+
+        }; // struct queue_length
+
+        /**
+         * Maximum number of bytes of data in each of the queues between the
+         * threads of a Reader or Writer. 0 means: use the default which
+         * depends on the number of threads in the Pool.
+         *
+         * This is a soft limit: One entry is always allowed into a queue
+         * even if it is larger than the limit, and for data that is still
+         * being worked on in the Pool the size is estimated from the size
+         * of the input data.
+         */
+        struct queue_bytes {
+
+            size_t value;
+
+            explicit queue_bytes(size_t bytes = 0) noexcept :
+                value(bytes) {
+            }
+
+        }; // struct queue_bytes
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_QUEUE_OPTIONS_HPP
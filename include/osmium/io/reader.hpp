@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdlib>
 #include <fcntl.h>
 #include <future>
+#include <initializer_list>
 #include <memory>
 #include <string>
 #include <system_error>
@@ -56,12 +57,21 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/read_thread.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/read_filter.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/queue_options.hpp>
+#include <osmium/io/reader_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 namespace osmium {
 
@@ -75,10 +85,69 @@ namespace osmium {
          */
         class Reader {
 
-            static constexpr size_t max_input_queue_size = 20; // XXX
-            static constexpr size_t max_osmdata_queue_size = 20; // XXX
+            struct options_type {
+                osmium::osm_entity_bits::type read_which_entities = osmium::osm_entity_bits::all;
+                mmap_input use_mmap = mmap_input::no;
+                uint64_t start_offset = 0;
+                size_t max_queue_length = 0;
+                size_t max_queue_bytes = 0;
+                detail::read_filter filter;
+            };
+
+            static void set_option(options_type& options, osmium::osm_entity_bits::type value) {
+                options.read_which_entities = value;
+            }
+
+            static void set_option(options_type& options, mmap_input value) {
+                options.use_mmap = value;
+            }
+
+            static void set_option(options_type& options, start_offset value) {
+                options.start_offset = value.offset;
+            }
+
+            static void set_option(options_type& options, queue_length value) {
+                options.max_queue_length = value.value;
+            }
+
+            static void set_option(options_type& options, queue_bytes value) {
+                options.max_queue_bytes = value.value;
+            }
+
+            static void set_option(options_type& options, const tag_filter& value) {
+                if (value.predicate) {
+                    options.filter.tags = std::make_shared<const tag_filter::predicate_type>(value.predicate);
+                } else {
+                    options.filter.tags.reset();
+                }
+            }
+
+            static void set_option(options_type& options, const osmium::Box& value) {
+                options.filter.box = value;
+            }
+
+            static void set_option(options_type& options, id_range value) {
+                options.filter.min_id = value.first;
+                options.filter.max_id = value.last;
+            }
+
+            template <typename... TArgs>
+            static options_type make_options(TArgs&&... args) {
+                options_type options;
+                (void)std::initializer_list<int>{
+                    (set_option(options, args), 0)...
+                };
+                if (options.max_queue_length == 0) {
+                    options.max_queue_length = detail::default_queue_length();
+                }
+                if (options.max_queue_bytes == 0) {
+                    options.max_queue_bytes = detail::default_queue_bytes();
+                }
+                return options;
+            }
 
             osmium::io::File m_file;
+            options_type m_options;
             osmium::osm_entity_bits::type m_read_which_entities;
 
             enum class status {
@@ -92,9 +161,14 @@ namespace osmium {
 
             detail::future_string_queue_type m_input_queue;
 
+            std::shared_ptr<osmium::util::MemoryMapping> m_mapped_input;
+
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
-            osmium::io::detail::ReadThreadManager m_read_thread_manager;
+            std::unique_ptr<osmium::io::detail::ReadThreadManager> m_read_thread_manager;
+
+            // Buffers given back by the user through recycle().
+            std::shared_ptr<osmium::memory::BufferPool> m_buffer_pool;
 
             detail::future_buffer_queue_type m_osmdata_queue;
             detail::queue_wrapper<osmium::memory::Buffer> m_osmdata_queue_wrapper;
@@ -109,13 +183,31 @@ namespace osmium {
                                       detail::future_string_queue_type& input_queue,
                                       detail::future_buffer_queue_type& osmdata_queue,
                                       std::promise<osmium::io::Header>&& header_promise,
-                                      osmium::osm_entity_bits::type read_which_entities) {
+                                      osmium::osm_entity_bits::type read_which_entities,
+                                      const std::shared_ptr<osmium::util::MemoryMapping>& mapped_input,
+                                      size_t mapped_input_start,
+                                      const std::shared_ptr<osmium::memory::BufferPool>& buffer_pool,
+                                      const detail::read_filter& filter) {
                 std::promise<osmium::io::Header> promise = std::move(header_promise);
                 auto creator = detail::ParserFactory::instance().get_creator_function(file);
                 auto parser = creator(input_queue, osmdata_queue, promise, read_which_entities);
+                parser->set_mapped_input(mapped_input, mapped_input_start);
+                parser->set_buffer_pool(buffer_pool);
+                parser->set_filter(filter);
                 parser->parse();
             }
 
+            /**
+             * Does the parser for this file format apply all restrictions
+             * from the filter itself? If not, the Reader has to filter the
+             * buffers it gets from the parser.
+             */
+            static bool parser_applies_filter(osmium::io::file_format format, const detail::read_filter& filter) noexcept {
+                return filter.empty() ||
+                       format == file_format::pbf ||
+                       (format == file_format::o5m && !filter.has_tags());
+            }
+
 #ifndef _WIN32
             /**
              * Fork and execute the given command in the child.
@@ -186,43 +278,142 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Map the input file into memory if that was requested and is
+             * possible for this file. See the mmap_input and start_offset
+             * options.
+             *
+             * @returns Shared pointer to the mapping or an empty pointer if
+             *          the file can not be mapped.
+             * @throws osmium::io_error if a start offset was set but the
+             *         file can not be mapped.
+             * @throws std::system_error if a system call fails.
+             */
+            static std::shared_ptr<osmium::util::MemoryMapping> map_input_file(const osmium::io::File& file, const options_type& options) {
+                if (options.use_mmap == mmap_input::no && options.start_offset == 0) {
+                    return nullptr;
+                }
+
+                auto mapping = map_input_file(file);
+                if (!mapping && options.start_offset != 0) {
+                    throw io_error("Reading from an offset is only supported for uncompressed local PBF files");
+                }
+
+                return mapping;
+            }
+
+            static std::shared_ptr<osmium::util::MemoryMapping> map_input_file(const osmium::io::File& file) {
+                std::shared_ptr<osmium::util::MemoryMapping> mapping;
+
+                if (file.format() != file_format::pbf ||
+                    file.compression() != file_compression::none ||
+                    file.buffer() ||
+                    file.filename().empty() ||
+                    file.filename() == "-" ||
+                    file.filename().find("://") != std::string::npos) {
+                    return mapping;
+                }
+
+                const int fd = osmium::io::detail::open_for_reading(file.filename());
+                try {
+                    // Pipes and other special files will report a size of 0.
+                    const size_t size = osmium::util::file_size(fd);
+                    if (size > 0) {
+                        mapping = std::make_shared<osmium::util::MemoryMapping>(size, osmium::util::MemoryMapping::mapping_mode::readonly, fd);
+                    }
+                } catch (...) {
+                    ::close(fd);
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+
+                return mapping;
+            }
+
         public:
 
             /**
              * Create new Reader object.
              *
              * @param file The file we want to open.
-             * @param read_which_entities Which OSM entities (nodes, ways, relations, and/or changesets)
-             *                            should be read from the input file. It can speed the read up
-             *                            significantly if objects that are not needed anyway are not
-             *                            parsed.
+             * @param args All further arguments are optional and can appear
+             *             in any order:
+             *
+             * * osmium::osm_entity_bits::type: Which OSM entities (nodes, ways,
+             *       relations, and/or changesets) should be read from the
+             *       input file. It can speed the read up significantly if
+             *       objects that are not needed anyway are not parsed.
+             *
+             * * osmium::io::mmap_input: Map the input file into memory
+             *       instead of reading it? This avoids copying the data
+             *       and saves the read thread. Only used for uncompressed
+             *       local PBF files. Can be osmium::io::mmap_input::yes or
+             *       osmium::io::mmap_input::no (default).
+             *
+             * * osmium::io::start_offset: Start reading the data at this
+             *       offset into the file (after reading the header). Only
+             *       possible for uncompressed local PBF files. Use an
+             *       osmium::io::PBFBlobIndex to find the offset.
+             *
+             * * osmium::io::queue_length: Maximum number of buffers in each
+             *       of the queues between the threads. The default
+             *       depends on the number of threads in the Pool.
+             *
+             * * osmium::io::queue_bytes: Maximum number of bytes of data in
+             *       each of the queues between the threads. The default
+             *       depends on the number of threads in the Pool.
+             *
+             * * osmium::io::tag_filter: Only read nodes, ways, and relations
+             *       with at least one tag matching this predicate.
+             *
+             * * osmium::Box: Only read nodes inside this bounding box. Ways
+             *       and relations are not affected.
+             *
+             * * osmium::io::id_range: Only read nodes, ways, and relations
+             *       with IDs in this range.
+             *
+             * @throws osmium::io_error If there was an error.
+             * @throws std::system_error If the file could not be opened.
              */
-            explicit Reader(const osmium::io::File& file, osmium::osm_entity_bits::type read_which_entities = osmium::osm_entity_bits::all) :
+            template <typename... TArgs>
+            explicit Reader(const osmium::io::File& file, TArgs&&... args) :
                 m_file(file.check()),
-                m_read_which_entities(read_which_entities),
+                m_options(make_options(std::forward<TArgs>(args)...)),
+                m_read_which_entities(m_options.read_which_entities),
                 m_status(status::okay),
                 m_childpid(0),
-                m_input_queue(max_input_queue_size, "raw_input"),
-                m_decompressor(m_file.buffer() ?
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
-                m_osmdata_queue(max_osmdata_queue_size, "parser_results"),
+                m_input_queue(m_options.max_queue_length, "raw_input", m_options.max_queue_bytes),
+                m_mapped_input(map_input_file(m_file, m_options)),
+                m_decompressor(m_mapped_input ? nullptr :
+                    m_file.buffer() ?
+                        osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
+                        osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
+                m_read_thread_manager(m_decompressor ? new osmium::io::detail::ReadThreadManager{*m_decompressor, m_input_queue} : nullptr),
+                m_buffer_pool(std::make_shared<osmium::memory::BufferPool>(m_options.max_queue_length)),
+                m_osmdata_queue(m_options.max_queue_length, "parser_results", m_options.max_queue_bytes),
                 m_osmdata_queue_wrapper(m_osmdata_queue),
                 m_header_future(),
                 m_header(),
                 m_thread() {
+                if (m_mapped_input) {
+                    // The parser reads directly from the mapping, so there
+                    // is nothing to put into the input queue.
+                    detail::add_end_of_data_to_queue(m_input_queue);
+                }
+
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
-                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(m_file), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), read_which_entities};
+                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(m_file), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_mapped_input, static_cast<size_t>(m_options.start_offset), m_buffer_pool, m_options.filter};
             }
 
-            explicit Reader(const std::string& filename, osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all) :
-                Reader(osmium::io::File(filename), read_types) {
+            template <typename... TArgs>
+            explicit Reader(const std::string& filename, TArgs&&... args) :
+                Reader(osmium::io::File(filename), std::forward<TArgs>(args)...) {
             }
 
-            explicit Reader(const char* filename, osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all) :
-                Reader(osmium::io::File(filename), read_types) {
+            template <typename... TArgs>
+            explicit Reader(const char* filename, TArgs&&... args) :
+                Reader(osmium::io::File(filename), std::forward<TArgs>(args)...) {
             }
 
             Reader(const Reader&) = delete;
@@ -250,12 +441,16 @@ namespace osmium {
             void close() {
                 m_status = status::closed;
 
-                m_read_thread_manager.stop();
+                if (m_read_thread_manager) {
+                    m_read_thread_manager->stop();
+                }
 
                 m_osmdata_queue_wrapper.drain();
 
                 try {
-                    m_read_thread_manager.close();
+                    if (m_read_thread_manager) {
+                        m_read_thread_manager->close();
+                    }
                 } catch (...) {
                     // Ignore any exceptions.
                 }
@@ -328,12 +523,20 @@ namespace osmium {
                         buffer = m_osmdata_queue_wrapper.pop();
                         if (detail::at_end_of_data(buffer)) {
                             m_status = status::eof;
-                            m_read_thread_manager.close();
+                            if (m_read_thread_manager) {
+                                m_read_thread_manager->close();
+                            }
                             return buffer;
                         }
+                        if (!parser_applies_filter(m_file.format(), m_options.filter) && buffer.committed() > 0) {
+                            osmium::memory::Buffer filtered = detail::filter_buffer(buffer, m_options.filter);
+                            m_buffer_pool->put(std::move(buffer));
+                            buffer = std::move(filtered);
+                        }
                         if (buffer.committed() > 0) {
                             return buffer;
                         }
+                        m_buffer_pool->put(std::move(buffer));
                     }
                 } catch (...) {
                     close();
@@ -342,6 +545,19 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Give a buffer returned by read() back to the Reader when you
+             * are done with it. The memory of the buffer will be reused for
+             * decoding more data instead of being freed and allocated again.
+             * Calling this is optional, buffers can also simply be
+             * destroyed. Currently only the PBF parser reuses buffers.
+             *
+             * The buffer must not be used after this call.
+             */
+            void recycle(osmium::memory::Buffer&& buffer) {
+                m_buffer_pool->put(std::move(buffer));
+            }
+
             /**
              * Has the end of file been reached? This is set after the last
              * data has been read. It is also set by calling close().
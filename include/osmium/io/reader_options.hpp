@@ -0,0 +1,119 @@
+#ifndef OSMIUM_IO_READER_OPTIONS_HPP
+#define OSMIUM_IO_READER_OPTIONS_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Should the reader map the input file into memory instead of
+         * reading it through a separate thread? This is only possible
+         * for uncompressed PBF files that are normal local files. In all
+         * other cases the reader silently falls back to normal reading.
+         */
+        enum class mmap_input : bool {
+            no  = false,
+            yes = true
+        };
+
+        /**
+         * Start reading the OSM data at the given offset into the input
+         * file. This only works for uncompressed local PBF files and the
+         * offset must point to the beginning of a data blob. Usually it is
+         * looked up in an osmium::io::PBFBlobIndex. The header is always
+         * read from the beginning of the file. This option implies
+         * mmap_input::yes.
+         */
+        struct start_offset {
+
+            uint64_t offset;
+
+            explicit start_offset(uint64_t value = 0) noexcept :
+                offset(value) {
+            }
+
+        }; // struct start_offset
+
+        /**
+         * Only read nodes, ways, and relations that have at least one tag
+         * for which the predicate returns true. The predicate is called
+         * with the key and value of a tag, any osmium::tags::Filter can be
+         * used. Objects without tags are never read, other entities (like
+         * changesets) are not affected.
+         *
+         * The PBF parser applies the filter while decoding and doesn't
+         * build non-matching objects at all. For other formats the objects
+         * are filtered after parsing.
+         */
+        struct tag_filter {
+
+            using predicate_type = std::function<bool(const char* key, const char* value)>;
+
+            predicate_type predicate;
+
+            explicit tag_filter(predicate_type value = nullptr) :
+                predicate(std::move(value)) {
+            }
+
+        }; // struct tag_filter
+
+        /**
+         * Only read nodes, ways, and relations with an ID in this range
+         * (inclusive). The PBF and O5M parsers check the IDs before
+         * building the objects.
+         */
+        struct id_range {
+
+            osmium::object_id_type first;
+            osmium::object_id_type last;
+
+            id_range(osmium::object_id_type first_id, osmium::object_id_type last_id) noexcept :
+                first(first_id),
+                last(last_id) {
+            }
+
+        }; // struct id_range
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READER_OPTIONS_HPP
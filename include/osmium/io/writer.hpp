@@ -49,6 +49,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/queue_options.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/util.hpp>
@@ -84,8 +85,53 @@ namespace osmium {
 
             static constexpr size_t default_buffer_size = 10 * 1024 * 1024;
 
+            struct options_type {
+                osmium::io::Header header;
+                overwrite allow_overwrite = overwrite::no;
+                fsync sync = fsync::no;
+                size_t max_queue_length = 0;
+                size_t max_queue_bytes = 0;
+            };
+
+            static void set_option(options_type& options, const osmium::io::Header& header) {
+                options.header = header;
+            }
+
+            static void set_option(options_type& options, overwrite value) {
+                options.allow_overwrite = value;
+            }
+
+            static void set_option(options_type& options, fsync value) {
+                options.sync = value;
+            }
+
+            static void set_option(options_type& options, queue_length value) {
+                options.max_queue_length = value.value;
+            }
+
+            static void set_option(options_type& options, queue_bytes value) {
+                options.max_queue_bytes = value.value;
+            }
+
+            template <typename... TArgs>
+            static options_type make_options(TArgs&&... args) {
+                options_type options;
+                (void)std::initializer_list<int>{
+                    (set_option(options, args), 0)...
+                };
+                if (options.max_queue_length == 0) {
+                    options.max_queue_length = detail::default_queue_length();
+                }
+                if (options.max_queue_bytes == 0) {
+                    options.max_queue_bytes = detail::default_queue_bytes();
+                }
+                return options;
+            }
+
             osmium::io::File m_file;
 
+            options_type m_options;
+
             detail::future_string_queue_type m_output_queue;
 
             std::unique_ptr<osmium::io::detail::OutputFormat> m_output;
@@ -148,24 +194,6 @@ namespace osmium {
                 }
             }
 
-            struct options_type {
-                osmium::io::Header header;
-                overwrite allow_overwrite = overwrite::no;
-                fsync sync = fsync::no;
-            };
-
-            static void set_option(options_type& options, const osmium::io::Header& header) {
-                options.header = header;
-            }
-
-            static void set_option(options_type& options, overwrite value) {
-                options.allow_overwrite = value;
-            }
-
-            static void set_option(options_type& options, fsync value) {
-                options.sync = value;
-            }
-
         public:
 
             /**
@@ -188,13 +216,22 @@ namespace osmium {
              *       before closing it? Can be osmium::io::fsync::yes or
              *       osmium::io::fsync::no (default).
              *
+             * * osmium::io::queue_length: Maximum number of buffers in the
+             *       queue between the encoder and the write thread. The
+             *       default depends on the number of threads in the Pool.
+             *
+             * * osmium::io::queue_bytes: Maximum number of bytes of data in
+             *       the queue between the encoder and the write thread. The
+             *       default depends on the number of threads in the Pool.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
             template <typename... TArgs>
             explicit Writer(const osmium::io::File& file, TArgs&&... args) :
                 m_file(file.check()),
-                m_output_queue(20, "raw_output"), // XXX
+                m_options(make_options(std::forward<TArgs>(args)...)),
+                m_output_queue(m_options.max_queue_length, "raw_output", m_options.max_queue_bytes),
                 m_output(osmium::io::detail::OutputFormatFactory::instance().create_output(m_file, m_output_queue)),
                 m_buffer(),
                 m_buffer_size(default_buffer_size),
@@ -203,22 +240,17 @@ namespace osmium {
                 m_status(status::okay) {
                 assert(!m_file.buffer()); // XXX can't handle pseudo-files
 
-                options_type options;
-                (void)std::initializer_list<int>{
-                    (set_option(options, args), 0)...
-                };
-
                 std::unique_ptr<osmium::io::Compressor> compressor =
                     CompressionFactory::instance().create_compressor(file.compression(),
-                                                                     osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
-                                                                     options.sync);
+                                                                     osmium::io::detail::open_for_writing(m_file.filename(), m_options.allow_overwrite),
+                                                                     m_options.sync);
 
                 std::promise<bool> write_promise;
                 m_write_future = write_promise.get_future();
                 m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise)};
 
                 ensure_cleanup([&](){
-                    m_output->write_header(options.header);
+                    m_output->write_header(m_options.header);
                 });
             }
 
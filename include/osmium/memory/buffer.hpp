@@ -251,6 +251,15 @@ namespace osmium {
                 return m_written;
             }
 
+            /**
+             * Does this buffer grow automatically when it becomes full?
+             * This is only possible for buffers with internal memory
+             * management. Always returns false on invalid buffers.
+             */
+            bool auto_grows() const noexcept {
+                return m_memory && m_auto_grow == auto_grow::yes;
+            }
+
             /**
              * This tests if the current state of the buffer is aligned
              * properly. Can be used for asserts.
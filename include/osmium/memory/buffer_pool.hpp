@@ -0,0 +1,130 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A thread-safe store of empty buffers that can be reused instead of
+         * allocating new ones. Buffers are put into the pool once they are
+         * not needed any more and taken out by code that needs a new buffer.
+         *
+         * Only auto-growing buffers with internal memory management are
+         * kept. The number of buffers in the pool is limited.
+         */
+        class BufferPool {
+
+            mutable std::mutex m_mutex;
+            std::vector<Buffer> m_buffers;
+            size_t m_max_buffers;
+
+        public:
+
+            /**
+             * Create a pool.
+             *
+             * @param max_buffers Maximum number of buffers kept in the pool.
+             *                    Additional buffers put into the pool are
+             *                    freed.
+             */
+            explicit BufferPool(size_t max_buffers) :
+                m_mutex(),
+                m_buffers(),
+                m_max_buffers(max_buffers) {
+            }
+
+            /**
+             * Get an empty auto-growing buffer with at least the given
+             * capacity. If there is a suitable buffer in the pool it is
+             * returned, otherwise a new buffer is created.
+             */
+            Buffer get(size_t min_capacity) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    for (auto it = m_buffers.rbegin(); it != m_buffers.rend(); ++it) {
+                        if (it->capacity() >= min_capacity) {
+                            Buffer buffer{std::move(*it)};
+                            m_buffers.erase(std::next(it).base());
+                            return buffer;
+                        }
+                    }
+                }
+                return Buffer{min_capacity, Buffer::auto_grow::yes};
+            }
+
+            /**
+             * Put a buffer into the pool. The buffer is cleared. Invalid
+             * buffers, buffers without auto-grow and buffers that don't fit
+             * into the pool any more are freed.
+             */
+            void put(Buffer&& buffer) {
+                if (!buffer.auto_grows()) {
+                    return;
+                }
+                buffer.clear();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_buffers.size() < m_max_buffers) {
+                    m_buffers.push_back(std::move(buffer));
+                }
+            }
+
+            /**
+             * The number of buffers currently in the pool.
+             */
+            size_t size() const {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_buffers.size();
+            }
+
+            size_t max_buffers() const noexcept {
+                return m_max_buffers;
+            }
+
+        }; // class BufferPool
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
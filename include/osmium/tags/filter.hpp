@@ -127,8 +127,15 @@ namespace osmium {
             }
 
             bool operator()(const osmium::Tag& tag) const {
+                return operator()(tag.key(), tag.value());
+            }
+
+            /**
+             * Apply the filter to a tag given as key and value.
+             */
+            bool operator()(const char* key, const char* value) const {
                 for (const Rule& rule : m_rules) {
-                    if (TKeyComp()(rule.key, tag.key()) && (rule.ignore_value || TValueComp()(rule.value, tag.value()))) {
+                    if (TKeyComp()(rule.key, key) && (rule.ignore_value || TValueComp()(rule.value, value))) {
                         return rule.result;
                     }
                 }
@@ -35,15 +35,18 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdlib>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
@@ -81,10 +84,33 @@ namespace osmium {
         } // namespace detail
 
         /**
-         *  Thread pool.
+         * Priority of a task submitted to the Pool. Tasks with high
+         * priority are always run before tasks with normal priority.
+         * Tasks decoding input data are usually run with high priority so
+         * that the reading side of a pipeline is not starved by the
+         * writing side.
+         */
+        enum class task_priority : int {
+            high   = 0,
+            normal = 1
+        }; // enum class task_priority
+
+        /**
+         * Thread pool.
+         *
+         * Every worker thread has its own double-ended queue of tasks for
+         * each priority. Tasks submitted from outside the pool are
+         * distributed round-robin over the workers, tasks submitted from
+         * inside a worker are put into its own queue. Workers take the
+         * oldest task from their own queues and, if those are empty, steal
+         * the oldest tasks from the queues of other workers. Running tasks
+         * in submission order keeps the latency low for the I/O pipelines,
+         * which consume the results in that order.
          */
         class Pool {
 
+            static constexpr const int num_priorities = 2;
+
             /**
              * This class makes sure all pool threads will be joined when
              * the pool is destructed.
@@ -109,26 +135,118 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            /**
+             * The task queues of one worker thread.
+             */
+            class worker_queues {
+
+                std::mutex m_mutex;
+                std::deque<function_wrapper> m_tasks[num_priorities];
+
+            public:
+
+                void push(function_wrapper&& task, task_priority priority) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks[static_cast<int>(priority)].push_back(std::move(task));
+                }
+
+                // Get oldest task.
+                bool pop_front(function_wrapper& task, int priority) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto& tasks = m_tasks[priority];
+                    if (tasks.empty()) {
+                        return false;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                    return true;
+                }
+
+            }; // class worker_queues
+
+            const size_t m_max_queue_size;
+
+            std::vector<std::unique_ptr<worker_queues>> m_queues;
+
+            // Number of tasks in all queues.
+            std::atomic<size_t> m_queued;
+
+            // Used for distributing tasks submitted from outside the pool.
+            std::atomic<size_t> m_next_queue;
+
+            std::atomic<bool> m_done;
+
+            // Used to wake up idle workers and blocked submitters.
+            std::mutex m_mutex;
+            std::condition_variable m_work_available;
+            std::condition_variable m_space_available;
+
             std::vector<std::thread> m_threads;
             thread_joiner m_joiner;
             int m_num_threads;
 
-            void worker_thread() {
+            // The pool the current thread is a worker of (or nullptr) and
+            // the index of that worker.
+            static const Pool*& current_pool() noexcept {
+                static thread_local const Pool* pool = nullptr;
+                return pool;
+            }
+
+            static size_t& current_worker() noexcept {
+                static thread_local size_t worker = 0;
+                return worker;
+            }
+
+            bool find_task(size_t worker, function_wrapper& task) {
+                for (int priority = 0; priority < num_priorities; ++priority) {
+                    if (m_queues[worker]->pop_front(task, priority)) {
+                        return true;
+                    }
+                    for (size_t i = 1; i < m_queues.size(); ++i) {
+                        if (m_queues[(worker + i) % m_queues.size()]->pop_front(task, priority)) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            void task_taken() {
+                --m_queued;
+                if (m_max_queue_size) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_space_available.notify_one();
+                }
+            }
+
+            void worker_thread(size_t worker) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                current_pool() = this;
+                current_worker() = worker;
+
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop_with_timeout(task);
-                    if (task) {
-                        if (task()) {
-                            // The called tasks returns true only when the
-                            // worker thread should shut down.
-                            return;
-                        }
+                    if (find_task(worker, task)) {
+                        task_taken();
+                        task();
+                        continue;
                     }
+
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    if (m_done && m_queued == 0) {
+                        return;
+                    }
+                    m_work_available.wait(lock, [this] {
+                        return m_queued > 0 || m_done;
+                    });
                 }
             }
 
+        public:
+
+            static constexpr int default_num_threads = 0;
+            static constexpr size_t max_work_queue_size = 10;
+
             /**
              * Create thread pool with the given number of threads. If
              * num_threads is 0, the number of threads is read from
@@ -140,16 +258,31 @@ namespace osmium {
              * given number, ie it will leave a number of cores unused.
              *
              * In all cases the minimum number of threads in the pool is 1.
+             *
+             * If max_queue_size is not 0, threads outside the pool
+             * submitting tasks will block if there are already that many
+             * tasks queued.
              */
             explicit Pool(int num_threads, size_t max_queue_size) :
-                m_work_queue(max_queue_size, "work"),
+                m_max_queue_size(max_queue_size),
+                m_queues(),
+                m_queued(0),
+                m_next_queue(0),
+                m_done(false),
+                m_mutex(),
+                m_work_available(),
+                m_space_available(),
                 m_threads(),
                 m_joiner(m_threads),
                 m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
 
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_queues.emplace_back(new worker_queues{});
+                }
+
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.push_back(std::thread(&Pool::worker_thread, this));
+                        m_threads.push_back(std::thread(&Pool::worker_thread, this, size_t(i)));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -157,44 +290,90 @@ namespace osmium {
                 }
             }
 
-        public:
-
-            static constexpr int default_num_threads = 0;
-            static constexpr size_t max_work_queue_size = 10;
-
             static Pool& instance() {
                 static Pool pool(default_num_threads, max_work_queue_size);
                 return pool;
             }
 
+            /**
+             * Tell all workers to shut down once all queued tasks are done.
+             */
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done = true;
                 }
+                m_work_available.notify_all();
+                m_space_available.notify_all();
             }
 
             ~Pool() {
                 shutdown_all_workers();
-                m_work_queue.shutdown();
+            }
+
+            int num_threads() const noexcept {
+                return m_num_threads;
             }
 
             size_t queue_size() const {
-                return m_work_queue.size();
+                return m_queued;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_queued == 0;
+            }
+
+            /**
+             * Is the current thread one of the workers of this pool? Code
+             * running in a worker must not wait for other tasks to finish,
+             * because all workers could end up waiting.
+             */
+            bool is_worker_thread() const noexcept {
+                return current_pool() == this;
             }
 
+            /**
+             * Submit a task to the pool.
+             *
+             * @param func The function to be called in a worker thread.
+             * @param priority The priority of the task.
+             * @returns A future for the result of the function.
+             */
             template <typename TFunction>
-            std::future<typename std::result_of<TFunction()>::type> submit(TFunction&& func) {
+            std::future<typename std::result_of<TFunction()>::type> submit(TFunction&& func, task_priority priority = task_priority::normal) {
 
                 using result_type = typename std::result_of<TFunction()>::type;
 
                 std::packaged_task<result_type()> task(std::forward<TFunction>(func));
                 std::future<result_type> future_result(task.get_future());
-                m_work_queue.push(std::move(task));
+
+                size_t worker;
+                if (is_worker_thread()) {
+                    // Tasks submitted from inside the pool never block,
+                    // otherwise the pool could deadlock.
+                    worker = current_worker();
+                } else {
+                    if (m_max_queue_size && m_queued >= m_max_queue_size) {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_space_available.wait(lock, [this] {
+                            return m_queued < m_max_queue_size || m_done;
+                        });
+                    }
+                    worker = m_next_queue++ % m_queues.size();
+                }
+
+                // Count the task before it becomes visible to the workers,
+                // otherwise a worker could take it and decrement the
+                // counter first.
+                ++m_queued;
+                m_queues[worker]->push(std::move(task), priority);
+
+                {
+                    // Taking the lock makes sure a worker that is just
+                    // about to go to sleep doesn't miss the notification.
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                }
+                m_work_available.notify_one();
 
                 return future_result;
             }
@@ -40,17 +40,54 @@ DEALINGS IN THE SOFTWARE.
 #include <mutex>
 #include <queue>
 #include <string>
-#include <thread>
 #include <utility> // IWYU pragma: keep (for std::move)
 
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
 namespace osmium {
 
     namespace thread {
 
-        static const std::chrono::milliseconds full_queue_sleep_duration { 10 }; // XXX
+        /**
+         * Statistics about the use of a Queue.
+         */
+        struct queue_stats {
+
+            /// The number of times push() was called on the queue.
+            size_t push_count = 0;
+
+            /// The number of times the queue was full and a thread pushing
+            /// to the queue was blocked.
+            size_t full_count = 0;
+
+            /// The number of times the queue was empty and a thread popping
+            /// from the queue was blocked.
+            size_t empty_count = 0;
+
+            /// The largest size the queue has been so far.
+            size_t largest_size = 0;
+
+            /// The largest number of bytes in the queue so far.
+            size_t largest_bytes = 0;
+
+            /// Overall time threads pushing to the queue were blocked.
+            std::chrono::steady_clock::duration push_wait_time{0};
+
+            /// Overall time threads popping from the queue were blocked.
+            std::chrono::steady_clock::duration pop_wait_time{0};
+
+        }; // struct queue_stats
 
         /**
-         *  A thread-safe queue.
+         * A thread-safe queue. If it has a maximum size, threads pushing to
+         * a full queue are blocked until there is space again.
+         *
+         * The queue can also be limited by the number of bytes in it. The
+         * size of each element has to be given when it is pushed onto the
+         * queue. This limit is soft, the queue always accepts an element if
+         * it is empty.
          */
         template <typename T>
         class Queue {
@@ -59,29 +96,54 @@ namespace osmium {
             /// the queue will block.
             const size_t m_max_size;
 
+            /// Maximum number of bytes in this queue (0 for unlimited).
+            const size_t m_max_bytes;
+
             /// Name of this queue (for debugging only).
             const std::string m_name;
 
             mutable std::mutex m_mutex;
 
-            std::queue<T> m_queue;
+            std::queue<std::pair<T, size_t>> m_queue;
+
+            /// Sum of the sizes of all elements in the queue.
+            size_t m_bytes;
 
             /// Used to signal readers when data is available in the queue.
             std::condition_variable m_data_available;
 
+            /// Used to signal writers when space is available in the queue.
+            std::condition_variable m_space_available;
+
             std::atomic<bool> m_done;
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-            /// The largest size the queue has been so far.
-            size_t m_largest_size;
+            /// Statistics, protected by m_mutex.
+            queue_stats m_stats;
 
-            /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
+            bool is_full() const noexcept {
+                return (m_max_size && m_queue.size() >= m_max_size) ||
+                       (m_max_bytes && m_bytes >= m_max_bytes && !m_queue.empty());
+            }
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
-#endif
+            void pop_front(T& value) {
+                value = std::move(m_queue.front().first);
+                m_bytes -= m_queue.front().second;
+                m_queue.pop();
+                if (m_max_size || m_max_bytes) {
+                    m_space_available.notify_one();
+                }
+            }
+
+            // Wait until the predicate is true, record the waiting time.
+            template <typename TPredicate>
+            void wait_for_data(std::unique_lock<std::mutex>& lock, TPredicate&& predicate) {
+                if (!predicate()) {
+                    ++m_stats.empty_count;
+                    const auto start = std::chrono::steady_clock::now();
+                    m_data_available.wait(lock, std::forward<TPredicate>(predicate));
+                    m_stats.pop_wait_time += std::chrono::steady_clock::now() - start;
+                }
+            }
 
         public:
 
@@ -91,69 +153,85 @@ namespace osmium {
              * @param max_size Maximum number of elements in the queue. Set to
              *                 0 for an unlimited size.
              * @param name Optional name for this queue. (Used for debugging.)
+             * @param max_bytes Maximum number of bytes in the queue. Set to
+             *                  0 for an unlimited size.
              */
-            explicit Queue(size_t max_size = 0, const std::string& name = "") :
+            explicit Queue(size_t max_size = 0, const std::string& name = "", size_t max_bytes = 0) :
                 m_max_size(max_size),
+                m_max_bytes(max_bytes),
                 m_name(name),
                 m_mutex(),
                 m_queue(),
+                m_bytes(0),
                 m_data_available(),
-                m_done(false)
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0)
-#endif
-            {
+                m_space_available(),
+                m_done(false),
+                m_stats() {
             }
 
             ~Queue() {
                 shutdown();
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                std::cerr << "queue '" << m_name << "' with max_size=" << m_max_size << " had largest size " << m_largest_size << " and was full " << m_full_counter << " times in " << m_push_counter << " push() calls\n";
+                const auto s = stats();
+                std::cerr << "queue '" << m_name << "' with max_size=" << m_max_size
+                          << " and max_bytes=" << m_max_bytes
+                          << " had largest size " << s.largest_size
+                          << " (" << s.largest_bytes << " bytes)"
+                          << " and was full " << s.full_count << " times (waited "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(s.push_wait_time).count()
+                          << "ms) and empty " << s.empty_count << " times (waited "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(s.pop_wait_time).count()
+                          << "ms) in " << s.push_count << " push() calls\n";
 #endif
             }
 
             /**
              * Push an element onto the queue. If the queue has a max size, this
              * call will block if the queue is full.
+             *
+             * @param value The element.
+             * @param bytes The (estimated) size of the element in bytes.
+             *              Only used if the queue has a byte limit.
              */
-            void push(T value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_push_counter;
-#endif
-                if (m_max_size) {
-                    while (size() >= m_max_size) {
-                        std::this_thread::sleep_for(full_queue_sleep_duration);
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
-                    }
+            void push(T value, size_t bytes = 0) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                ++m_stats.push_count;
+                if (is_full() && !m_done) {
+                    ++m_stats.full_count;
+                    const auto start = std::chrono::steady_clock::now();
+                    m_space_available.wait(lock, [this] {
+                        return !is_full() || m_done;
+                    });
+                    m_stats.push_wait_time += std::chrono::steady_clock::now() - start;
                 }
-                std::lock_guard<std::mutex> lock(m_mutex);
-                m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                if (m_largest_size < m_queue.size()) {
-                    m_largest_size = m_queue.size();
+                m_queue.emplace(std::move(value), bytes);
+                m_bytes += bytes;
+                if (m_stats.largest_size < m_queue.size()) {
+                    m_stats.largest_size = m_queue.size();
                 }
-#endif
+                if (m_stats.largest_bytes < m_bytes) {
+                    m_stats.largest_bytes = m_bytes;
+                }
+                lock.unlock();
                 m_data_available.notify_one();
             }
 
             void shutdown() {
-                m_done = true;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done = true;
+                }
                 m_data_available.notify_all();
+                m_space_available.notify_all();
             }
 
             void wait_and_pop(T& value) {
                 std::unique_lock<std::mutex> lock(m_mutex);
-                m_data_available.wait(lock, [this] {
+                wait_for_data(lock, [this] {
                     return !m_queue.empty() || m_done;
                 });
                 if (!m_queue.empty()) {
-                    value = std::move(m_queue.front());
-                    m_queue.pop();
+                    pop_front(value);
                 }
             }
 
@@ -165,8 +243,7 @@ namespace osmium {
                     return;
                 }
                 if (!m_queue.empty()) {
-                    value = std::move(m_queue.front());
-                    m_queue.pop();
+                    pop_front(value);
                 }
             }
 
@@ -175,8 +252,7 @@ namespace osmium {
                 if (m_queue.empty()) {
                     return false;
                 }
-                value = std::move(m_queue.front());
-                m_queue.pop();
+                pop_front(value);
                 return true;
             }
 
@@ -190,6 +266,34 @@ namespace osmium {
                 return m_queue.size();
             }
 
+            size_t max_size() const noexcept {
+                return m_max_size;
+            }
+
+            size_t max_bytes() const noexcept {
+                return m_max_bytes;
+            }
+
+            /**
+             * The sum of the sizes of all elements in the queue.
+             */
+            size_t bytes() const {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_bytes;
+            }
+
+            const std::string& name() const noexcept {
+                return m_name;
+            }
+
+            /**
+             * Get a copy of the current statistics of this queue.
+             */
+            queue_stats stats() const {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_stats;
+            }
+
         }; // class Queue
 
     } // namespace thread
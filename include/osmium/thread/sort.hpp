@@ -0,0 +1,221 @@
+#ifndef OSMIUM_THREAD_SORT_HPP
+#define OSMIUM_THREAD_SORT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2016 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        class Pool;
+
+        namespace detail {
+
+            // Ranges smaller than this are always sorted in the current
+            // thread.
+            constexpr const std::size_t min_parallel_sort_size = 1024 * 64;
+
+            // Maximum size of the temporary buffer used by one merge task.
+            constexpr const std::size_t max_merge_buffer_bytes = 16 * 1024 * 1024;
+
+            /**
+             * Merge the sorted ranges [first, middle) and [middle, last)
+             * using the buffer which must have room for buffer_size
+             * elements. Ranges that don't fit into the buffer are split
+             * and rotated until they do, like std::inplace_merge does
+             * when it can't get enough memory.
+             */
+            template <typename TIterator, typename TCompare>
+            void merge_with_buffer(TIterator first, TIterator middle, TIterator last,
+                                   std::vector<typename std::iterator_traits<TIterator>::value_type>& buffer,
+                                   std::size_t buffer_size, TCompare comp) {
+                const auto len1 = static_cast<std::size_t>(std::distance(first, middle));
+                const auto len2 = static_cast<std::size_t>(std::distance(middle, last));
+
+                if (len1 == 0 || len2 == 0) {
+                    return;
+                }
+
+                if (len1 <= len2 && len1 <= buffer_size) {
+                    buffer.assign(std::make_move_iterator(first), std::make_move_iterator(middle));
+                    auto it = buffer.begin();
+                    while (it != buffer.end() && middle != last) {
+                        if (comp(*middle, *it)) {
+                            *first++ = std::move(*middle++);
+                        } else {
+                            *first++ = std::move(*it++);
+                        }
+                    }
+                    std::move(it, buffer.end(), first);
+                    return;
+                }
+
+                if (len2 <= buffer_size) {
+                    buffer.assign(std::make_move_iterator(middle), std::make_move_iterator(last));
+                    auto it = buffer.end();
+                    while (it != buffer.begin() && middle != first) {
+                        if (comp(*std::prev(it), *std::prev(middle))) {
+                            *--last = std::move(*--middle);
+                        } else {
+                            *--last = std::move(*--it);
+                        }
+                    }
+                    std::move_backward(buffer.begin(), it, last);
+                    return;
+                }
+
+                TIterator cut1;
+                TIterator cut2;
+                if (len1 > len2) {
+                    cut1 = std::next(first, len1 / 2);
+                    cut2 = std::lower_bound(middle, last, *cut1, comp);
+                } else {
+                    cut2 = std::next(middle, len2 / 2);
+                    cut1 = std::upper_bound(first, middle, *cut2, comp);
+                }
+                std::rotate(cut1, middle, cut2);
+                const TIterator new_middle = std::next(cut1, std::distance(middle, cut2));
+
+                merge_with_buffer(first, cut1, new_middle, buffer, buffer_size, comp);
+                merge_with_buffer(new_middle, cut2, last, buffer, buffer_size, comp);
+            }
+
+            template <typename T>
+            inline void wait_for_all(std::vector<std::future<T>>& futures) {
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                for (auto& future : futures) {
+                    future.get();
+                }
+            }
+
+        } // namespace detail
+
+        /**
+         * Sort the range [first, last) using the threads of the pool. The
+         * range is split into one part per thread, the parts are sorted
+         * in parallel and then merged pairwise, again in parallel.
+         *
+         * Like std::sort this sort is not stable. Small ranges are sorted
+         * in the current thread, so are ranges sorted from inside a worker
+         * of the pool.
+         *
+         * Each merge task uses a temporary buffer of at most
+         * detail::max_merge_buffer_bytes, so the extra memory needed is
+         * bounded by that times the number of threads and doesn't grow
+         * with the size of the range. The last merge round is a single
+         * task over the whole range, so the speedup is limited by it.
+         *
+         * This header doesn't include osmium/thread/pool.hpp, include it
+         * to get a pool to call this with.
+         *
+         * @param first Beginning of the range.
+         * @param last End of the range.
+         * @param comp Comparison function.
+         * @param pool The thread pool to use (usually osmium::thread::Pool).
+         */
+        template <typename TIterator, typename TCompare, typename TPool>
+        inline void parallel_sort(TIterator first, TIterator last, TCompare comp, TPool& pool) {
+            using value_type = typename std::iterator_traits<TIterator>::value_type;
+
+            const auto size = std::distance(first, last);
+            const int num_parts = pool.num_threads();
+
+            if (num_parts < 2 || static_cast<std::size_t>(size) < detail::min_parallel_sort_size || pool.is_worker_thread()) {
+                std::sort(first, last, comp);
+                return;
+            }
+
+            std::vector<TIterator> bounds;
+            for (int i = 0; i < num_parts; ++i) {
+                bounds.push_back(std::next(first, size / num_parts * i));
+            }
+            bounds.push_back(last);
+
+            std::vector<std::future<void>> futures;
+            for (int i = 0; i < num_parts; ++i) {
+                const TIterator begin = bounds[i];
+                const TIterator end = bounds[i + 1];
+                futures.push_back(pool.submit([begin, end, comp] {
+                    std::sort(begin, end, comp);
+                }));
+            }
+            detail::wait_for_all(futures);
+
+            while (bounds.size() > 2) {
+                futures.clear();
+                std::vector<TIterator> merged_bounds;
+                std::size_t i = 0;
+                for (; i + 2 < bounds.size(); i += 2) {
+                    const TIterator begin = bounds[i];
+                    const TIterator middle = bounds[i + 1];
+                    const TIterator end = bounds[i + 2];
+                    merged_bounds.push_back(begin);
+                    futures.push_back(pool.submit([begin, middle, end, comp] {
+                        const std::size_t buffer_size = std::max<std::size_t>(1, detail::max_merge_buffer_bytes / sizeof(value_type));
+                        std::vector<value_type> buffer;
+                        detail::merge_with_buffer(begin, middle, end, buffer, buffer_size, comp);
+                    }));
+                }
+                // with an odd number of parts the last one is carried over
+                for (; i < bounds.size(); ++i) {
+                    merged_bounds.push_back(bounds[i]);
+                }
+                detail::wait_for_all(futures);
+                bounds = std::move(merged_bounds);
+            }
+        }
+
+        /**
+         * Sort the range [first, last) with operator< using the threads of
+         * the pool. See above for details.
+         */
+        template <typename TIterator, typename TPool>
+        inline void parallel_sort(TIterator first, TIterator last, TPool& pool) {
+            parallel_sort(first, last, std::less<typename std::iterator_traits<TIterator>::value_type>{}, pool);
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SORT_HPP
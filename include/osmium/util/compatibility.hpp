@@ -50,4 +50,14 @@ DEALINGS IN THE SOFTWARE.
 # define OSMIUM_DEPRECATED
 #endif
 
+// Hint to the CPU that the memory at the given address will be read soon
+#ifdef __GNUC__
+# define OSMIUM_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+# include <xmmintrin.h>
+# define OSMIUM_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+# define OSMIUM_PREFETCH(address)
+#endif
+
 #endif // OSMIUM_UTIL_COMPATIBILITY_HPP
@@ -65,6 +65,45 @@ namespace osmium {
             return true;
         }
 
+        inline bool use_pool_threads_for_xml_parsing() {
+            const char* env = getenv("OSMIUM_USE_POOL_THREADS_FOR_XML_PARSING");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline bool use_pool_threads_for_gzip() {
+            const char* env = getenv("OSMIUM_USE_POOL_THREADS_FOR_GZIP");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline bool use_pool_threads_for_bzip2() {
+            const char* env = getenv("OSMIUM_USE_POOL_THREADS_FOR_BZIP2");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
     } // namespace config
 
 } // namespace osmium
@@ -51,6 +51,21 @@ documentation.
 # define PROTOZERO_USE_BUILTIN_BSWAP
 #endif
 
+// Use SIMD instructions for decoding packed varints if the compiler is
+// allowed to generate them. Define PROTOZERO_DO_NOT_USE_SIMD to always use
+// the scalar code.
+#if !defined(PROTOZERO_DO_NOT_USE_SIMD) && (defined(__GNUC__) || defined(__clang__))
+# if defined(__AVX2__)
+#  define PROTOZERO_USE_AVX2
+# endif
+# if defined(__SSE2__)
+#  define PROTOZERO_USE_SSE2
+# endif
+# if defined(__BMI2__) && defined(__x86_64__)
+#  define PROTOZERO_USE_BMI2
+# endif
+#endif
+
 // Wrapper for assert() used for testing
 #ifndef protozero_assert
 # define protozero_assert(x) assert(x)
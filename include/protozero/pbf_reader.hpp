@@ -22,6 +22,7 @@ documentation.
 #include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <protozero/config.hpp>
 #include <protozero/exception.hpp>
@@ -182,6 +183,12 @@ class pbf_reader {
 
     inline pbf_length_type get_len_and_skip();
 
+    template <typename T>
+    inline void get_packed_varints(std::vector<T>& values);
+
+    template <typename T>
+    inline void get_packed_svarints(std::vector<T>& values);
+
 public:
 
     /**
@@ -756,6 +763,64 @@ public:
      */
     inline std::pair<pbf_reader::const_uint64_iterator, pbf_reader::const_uint64_iterator> get_packed_uint64();
 
+    /**
+     * Consume current "repeated packed bool" field and decode all values
+     * into a vector.
+     *
+     * Decoding all values at once is faster than using the iterators. The
+     * vector is overwritten, reuse it to avoid memory allocations.
+     *
+     * @param values Vector the decoded values are written to.
+     * @pre There must be a current field (ie. next() must have returned `true`).
+     * @pre The current field must be of type "repeated packed bool".
+     * @post The current field was consumed and there is no current field now.
+     * @throws varint_too_long_exception or end_of_buffer_exception if the
+     *         data is corrupted.
+     */
+    inline void get_packed_bool(std::vector<int32_t>& values);
+
+    /**
+     * Consume current "repeated packed enum" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_enum(std::vector<int32_t>& values);
+
+    /**
+     * Consume current "repeated packed int32" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_int32(std::vector<int32_t>& values);
+
+    /**
+     * Consume current "repeated packed sint32" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_sint32(std::vector<int32_t>& values);
+
+    /**
+     * Consume current "repeated packed uint32" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_uint32(std::vector<uint32_t>& values);
+
+    /**
+     * Consume current "repeated packed int64" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_int64(std::vector<int64_t>& values);
+
+    /**
+     * Consume current "repeated packed sint64" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_sint64(std::vector<int64_t>& values);
+
+    /**
+     * Consume current "repeated packed uint64" field and decode all values
+     * into a vector. See get_packed_bool(std::vector<int32_t>&) for details.
+     */
+    inline void get_packed_uint64(std::vector<uint64_t>& values);
+
     /**
      * Consume current "repeated packed fixed32" field.
      *
@@ -1072,6 +1137,59 @@ std::pair<pbf_reader::const_sint64_iterator, pbf_reader::const_sint64_iterator>
                           pbf_reader::const_sint64_iterator(m_data, m_data));
 }
 
+template <typename T>
+void pbf_reader::get_packed_varints(std::vector<T>& values) {
+    protozero_assert(tag() != 0 && "call next() before accessing field value");
+    auto len = get_len_and_skip();
+    const char* first = m_data - len;
+    values.resize(count_varints(first, m_data));
+    if (!values.empty()) {
+        T* end = decode_varints(first, m_data, values.data());
+        protozero_assert(end == values.data() + values.size());
+        (void)end;
+    } else if (len > 0) {
+        throw end_of_buffer_exception();
+    }
+}
+
+template <typename T>
+void pbf_reader::get_packed_svarints(std::vector<T>& values) {
+    get_packed_varints(values);
+    decode_zigzag(values.data(), values.data() + values.size());
+}
+
+void pbf_reader::get_packed_bool(std::vector<int32_t>& values) {
+    get_packed_varints(values);
+}
+
+void pbf_reader::get_packed_enum(std::vector<int32_t>& values) {
+    get_packed_varints(values);
+}
+
+void pbf_reader::get_packed_int32(std::vector<int32_t>& values) {
+    get_packed_varints(values);
+}
+
+void pbf_reader::get_packed_sint32(std::vector<int32_t>& values) {
+    get_packed_svarints(values);
+}
+
+void pbf_reader::get_packed_uint32(std::vector<uint32_t>& values) {
+    get_packed_varints(values);
+}
+
+void pbf_reader::get_packed_int64(std::vector<int64_t>& values) {
+    get_packed_varints(values);
+}
+
+void pbf_reader::get_packed_sint64(std::vector<int64_t>& values) {
+    get_packed_svarints(values);
+}
+
+void pbf_reader::get_packed_uint64(std::vector<uint64_t>& values) {
+    get_packed_varints(values);
+}
+
 } // end namespace protozero
 
 #endif // PROTOZERO_PBF_READER_HPP
@@ -16,10 +16,19 @@ documentation.
  * @brief Contains low-level varint and zigzag encoding and decoding functions.
  */
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
+#include <protozero/config.hpp>
 #include <protozero/exception.hpp>
 
+#if defined(PROTOZERO_USE_AVX2) || defined(PROTOZERO_USE_BMI2)
+# include <immintrin.h>
+#elif defined(PROTOZERO_USE_SSE2)
+# include <emmintrin.h>
+#endif
+
 namespace protozero {
 
 /**
@@ -127,6 +136,139 @@ inline int64_t decode_zigzag64(uint64_t value) noexcept {
     return int64_t(value >> 1) ^ -int64_t(value & 1);
 }
 
+/**
+ * Decodes 32 bit ZigZag-encoded integers in place.
+ */
+inline void decode_zigzag(int32_t* first, int32_t* last) noexcept {
+    for (; first != last; ++first) {
+        *first = decode_zigzag32(static_cast<uint32_t>(*first));
+    }
+}
+
+/**
+ * Decodes 64 bit ZigZag-encoded integers in place.
+ */
+inline void decode_zigzag(int64_t* first, int64_t* last) noexcept {
+    for (; first != last; ++first) {
+        *first = decode_zigzag64(static_cast<uint64_t>(*first));
+    }
+}
+
+namespace detail {
+
+#if defined(PROTOZERO_USE_AVX2)
+    constexpr const int varint_block_size = 32;
+
+    // Returns a bit mask with the continuation bits of the next 32 bytes.
+    inline uint32_t continuation_bits(const char* data) noexcept {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data))));
+    }
+#elif defined(PROTOZERO_USE_SSE2)
+    constexpr const int varint_block_size = 16;
+
+    // Returns a bit mask with the continuation bits of the next 16 bytes.
+    inline uint32_t continuation_bits(const char* data) noexcept {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data))));
+    }
+#endif
+
+#if defined(PROTOZERO_USE_AVX2) || defined(PROTOZERO_USE_SSE2)
+    constexpr const uint32_t varint_block_mask = varint_block_size == 32 ? 0xffffffffu : 0xffffu;
+#endif
+
+    template <typename T>
+    inline T* copy_single_byte_varints(const char* data, int count, T* out) noexcept {
+        for (int i = 0; i < count; ++i) {
+            out[i] = static_cast<T>(static_cast<uint8_t>(data[i]));
+        }
+        return out + count;
+    }
+
+    // Decode one varint that is (usually) longer than one byte.
+    inline uint64_t decode_long_varint(const char** data, const char* end) {
+#if defined(PROTOZERO_USE_BMI2)
+        // Varints of up to eight bytes are extracted from one unaligned
+        // load with a single pext instruction.
+        if (end - *data >= 8) {
+            uint64_t word;
+            std::memcpy(&word, *data, sizeof(word));
+            const uint64_t stop_bits = ~word & 0x8080808080808080ULL;
+            if (stop_bits != 0) {
+                const int bits = __builtin_ctzll(stop_bits) + 1;
+                const uint64_t mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+                *data += bits / 8;
+                return _pext_u64(word & mask, 0x7f7f7f7f7f7f7f7fULL);
+            }
+        }
+#endif
+        return decode_varint(data, end);
+    }
+
+} // end namespace detail
+
+/**
+ * Count the number of varints in the range [first, last). This is the
+ * number of bytes without the continuation bit set, so an incomplete varint
+ * at the end of the range is not counted.
+ */
+inline std::size_t count_varints(const char* first, const char* last) noexcept {
+    std::size_t count = 0;
+
+#if defined(PROTOZERO_USE_AVX2) || defined(PROTOZERO_USE_SSE2)
+    while (last - first >= detail::varint_block_size) {
+        count += static_cast<std::size_t>(__builtin_popcount(~detail::continuation_bits(first) & detail::varint_block_mask));
+        first += detail::varint_block_size;
+    }
+#endif
+
+    for (; first != last; ++first) {
+        if ((static_cast<uint8_t>(*first) & 0x80) == 0) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Decode all varints in the range [first, last) into an array. This is
+ * much faster than decoding them one by one, especially if many of the
+ * values are small. Depending on the instruction sets available at compile
+ * time SSE2 or AVX2 are used to find runs of one-byte varints and BMI2 to
+ * decode longer ones.
+ *
+ * @param first Pointer to the beginning of the input data.
+ * @param last Pointer one past the end of the input data.
+ * @param out Pointer to the output array. It must have space for at least
+ *        count_varints(first, last) values.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is too long.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+inline T* decode_varints(const char* first, const char* last, T* out) {
+#if defined(PROTOZERO_USE_AVX2) || defined(PROTOZERO_USE_SSE2)
+    while (last - first >= detail::varint_block_size) {
+        const uint32_t mask = detail::continuation_bits(first);
+        if (mask == 0) {
+            out = detail::copy_single_byte_varints(first, detail::varint_block_size, out);
+            first += detail::varint_block_size;
+        } else {
+            const int count = __builtin_ctz(mask);
+            out = detail::copy_single_byte_varints(first, count, out);
+            first += count;
+            *out++ = static_cast<T>(detail::decode_long_varint(&first, last));
+        }
+    }
+#endif
+
+    while (first != last) {
+        *out++ = static_cast<T>(decode_varint(&first, last));
+    }
+
+    return out;
+}
+
 } // end namespace protozero
 
 #endif // PROTOZERO_VARINT_HPP
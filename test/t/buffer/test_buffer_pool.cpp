@@ -0,0 +1,53 @@
+#include "catch.hpp"
+
+#include <osmium/memory/buffer_pool.hpp>
+
+TEST_CASE("Buffer pool") {
+
+    osmium::memory::BufferPool pool{2};
+    REQUIRE(pool.size() == 0);
+    REQUIRE(pool.max_buffers() == 2);
+
+    SECTION("get buffer from empty pool") {
+        osmium::memory::Buffer buffer = pool.get(1024);
+        REQUIRE(buffer);
+        REQUIRE(buffer.capacity() == 1024);
+        REQUIRE(buffer.auto_grows());
+    }
+
+    SECTION("recycled buffer is cleared and reused") {
+        osmium::memory::Buffer buffer{1024};
+        buffer.reserve_space(64);
+        buffer.commit();
+        const auto data = buffer.data();
+
+        pool.put(std::move(buffer));
+        REQUIRE(pool.size() == 1);
+
+        osmium::memory::Buffer buffer2 = pool.get(512);
+        REQUIRE(pool.size() == 0);
+        REQUIRE(buffer2.data() == data);
+        REQUIRE(buffer2.committed() == 0);
+    }
+
+    SECTION("buffer that is too small is not used") {
+        pool.put(osmium::memory::Buffer{1024});
+        osmium::memory::Buffer buffer = pool.get(2048);
+        REQUIRE(buffer.capacity() == 2048);
+        REQUIRE(pool.size() == 1);
+    }
+
+    SECTION("only some buffers are kept") {
+        unsigned char data[64];
+        pool.put(osmium::memory::Buffer{});
+        pool.put(osmium::memory::Buffer{data, sizeof(data)});
+        pool.put(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::no});
+        REQUIRE(pool.size() == 0);
+
+        pool.put(osmium::memory::Buffer{1024});
+        pool.put(osmium::memory::Buffer{1024});
+        pool.put(osmium::memory::Buffer{1024});
+        REQUIRE(pool.size() == 2);
+    }
+
+}
@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <osmium/index/map/compressed_mem.hpp>
+#include <osmium/index/node_locations_map.hpp>
+
+using index_type = osmium::index::map::CompressedMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    if (id % 101 == 0) {
+        return osmium::Location{};
+    }
+    return osmium::Location{static_cast<int32_t>(id * 7919 % 3600000000ull) - 1800000000,
+                            static_cast<int32_t>(id * 104729 % 1800000000ull) - 900000000};
+}
+
+static std::vector<osmium::unsigned_object_id_type> make_ids() {
+    std::vector<osmium::unsigned_object_id_type> ids;
+    osmium::unsigned_object_id_type id = 1;
+    for (int i = 0; i < 100000; ++i) {
+        ids.push_back(id);
+        id += (i % 1000 == 0) ? 1000000000 : (i % 3) + 1;
+    }
+    return ids;
+}
+
+static void check_index(const index_type& index, const std::vector<osmium::unsigned_object_id_type>& ids) {
+    for (const auto id : ids) {
+        REQUIRE(index.get(id) == location_for(id));
+    }
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(ids[1] + 1), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(ids.back() + 1), osmium::not_found);
+}
+
+TEST_CASE("CompressedMem with IDs in order") {
+    const auto ids = make_ids();
+    index_type index;
+
+    for (const auto id : ids) {
+        index.set(id, location_for(id));
+    }
+
+    // entries that are not encoded yet can be found before sort()
+    REQUIRE(index.get(ids.back()) == location_for(ids.back()));
+
+    index.sort();
+    REQUIRE(index.size() == ids.size());
+    check_index(index, ids);
+
+    // more entries after sort()
+    index.set(ids.back() + 10, osmium::Location{1.0, 2.0});
+    index.sort();
+    REQUIRE(index.get(ids.back() + 10) == (osmium::Location{1.0, 2.0}));
+    check_index(index, ids);
+
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE_THROWS_AS(index.get(ids.front()), osmium::not_found);
+}
+
+TEST_CASE("CompressedMem with IDs out of order") {
+    auto ids = make_ids();
+    index_type index;
+
+    for (auto it = ids.crbegin(); it != ids.crend(); ++it) {
+        index.set(*it, osmium::Location{3.0, 4.0});
+    }
+    // set again, the last value must win
+    for (const auto id : ids) {
+        index.set(id, location_for(id));
+    }
+    REQUIRE(index.size() == 2 * ids.size());
+
+    index.sort();
+    REQUIRE(index.size() == ids.size());
+    check_index(index, ids);
+}
+
+TEST_CASE("CompressedMem needs less memory than sparse array") {
+    index_type index;
+
+    // nearby nodes with consecutive IDs as in real data
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000000; ++id) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id * 100), static_cast<int32_t>(id * 50)});
+    }
+    index.sort();
+
+    REQUIRE(index.get(123456) == (osmium::Location{12345600, 6172800}));
+    REQUIRE(index.used_memory() < 1000000 * 8);
+}
+
+TEST_CASE("CompressedMem can be created through MapFactory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("compressed_mem"));
+
+    const auto index = map_factory.create_map("compressed_mem");
+    index->set(17, osmium::Location{1.0, 2.0});
+    index->sort();
+    REQUIRE(index->get(17) == (osmium::Location{1.0, 2.0}));
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <memory>
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/node_locations_map.hpp>
+
+using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id % 1000), static_cast<int32_t>(id / 1000)};
+}
+
+TEST_CASE("FlexMem stays sparse if IDs are sparse") {
+    index_type index{false, 100};
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        index.set(id * 1000, location_for(id * 1000));
+    }
+    REQUIRE_FALSE(index.is_dense());
+    REQUIRE(index.size() == 1000);
+
+    index.sort();
+    REQUIRE(index.get(5000) == location_for(5000));
+    REQUIRE_THROWS_AS(index.get(5001), osmium::not_found);
+}
+
+TEST_CASE("FlexMem switches to dense if IDs are dense") {
+    index_type index{false, 100};
+
+    // out of order to check that entries are moved over correctly
+    for (osmium::unsigned_object_id_type id = 200000; id > 0; --id) {
+        if (id % 3 != 0) {
+            index.set(id, location_for(id));
+        }
+    }
+    REQUIRE(index.is_dense());
+
+    index.sort();
+    for (osmium::unsigned_object_id_type id = 1; id <= 200000; ++id) {
+        if (id % 3 != 0) {
+            REQUIRE(index.get(id) == location_for(id));
+        } else {
+            REQUIRE_THROWS_AS(index.get(id), osmium::not_found);
+        }
+    }
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(1000000000), osmium::not_found);
+
+    // four blocks of 2^16 locations
+    REQUIRE(index.size() == 4 * 65536);
+    REQUIRE(index.used_memory() >= 4 * 65536 * sizeof(osmium::Location));
+}
+
+TEST_CASE("FlexMem does not switch to dense before minimum number of entries") {
+    index_type index;
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        index.set(id, location_for(id));
+    }
+    REQUIRE_FALSE(index.is_dense());
+}
+
+TEST_CASE("FlexMem goes back to sparse layout on clear") {
+    index_type index{false, 100};
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        index.set(id, location_for(id));
+    }
+    REQUIRE(index.is_dense());
+
+    index.clear();
+    REQUIRE_FALSE(index.is_dense());
+    REQUIRE(index.size() == 0);
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+
+    // reuse with sparse IDs
+    for (osmium::unsigned_object_id_type id = 1; id <= 1000; ++id) {
+        index.set(id * 1000, location_for(id * 1000));
+    }
+    REQUIRE_FALSE(index.is_dense());
+    REQUIRE(index.size() == 1000);
+
+    index.sort();
+    REQUIRE(index.get(5000) == location_for(5000));
+    REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
+}
+
+TEST_CASE("FlexMem started dense stays dense on clear") {
+    index_type index{true};
+
+    index.set(17, location_for(17));
+    index.clear();
+    REQUIRE(index.is_dense());
+    REQUIRE(index.size() == 0);
+    REQUIRE_THROWS_AS(index.get(17), osmium::not_found);
+
+    index.set(42, location_for(42));
+    REQUIRE(index.get(42) == location_for(42));
+}
+
+TEST_CASE("FlexMem can be created through MapFactory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("flex_mem"));
+
+    const auto index = map_factory.create_map("flex_mem");
+    index->set(17, osmium::Location{1.0, 2.0});
+    index->sort();
+    REQUIRE(index->get(17) == (osmium::Location{1.0, 2.0}));
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/compressed_mem.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id * 2)};
+}
+
+static void test_get_many(map_type& index) {
+    // every third ID is missing
+    for (osmium::unsigned_object_id_type id = 1; id < 10000; ++id) {
+        if (id % 3 != 0) {
+            index.set(id, location_for(id));
+        }
+    }
+    index.sort();
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id < 10010; id += 7) {
+        ids.push_back(id);
+    }
+    ids.push_back(5);
+    ids.push_back(1000000);
+    ids.push_back(1);
+
+    std::vector<osmium::Location> locations(ids.size());
+    const auto not_found = index.get_many(ids.data(), locations.data(), ids.size());
+
+    std::size_t expected_not_found = 0;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] == 0 || ids[i] % 3 == 0 || ids[i] >= 10000) {
+            REQUIRE_FALSE(locations[i].valid());
+            ++expected_not_found;
+        } else {
+            REQUIRE(locations[i] == location_for(ids[i]));
+            REQUIRE(locations[i] == index.get(ids[i]));
+        }
+    }
+    REQUIRE(not_found == expected_not_found);
+
+    REQUIRE(index.get_many(ids.data(), locations.data(), 0) == 0);
+}
+
+TEST_CASE("get_many") {
+
+    SECTION("DenseMemArray") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        test_get_many(index);
+    }
+
+#ifdef __linux__
+    SECTION("DenseMmapArray") {
+        osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        test_get_many(index);
+    }
+#endif
+
+    SECTION("SparseMemArray") {
+        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        test_get_many(index);
+    }
+
+#ifdef __linux__
+    SECTION("SparseMmapArray") {
+        osmium::index::map::SparseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        test_get_many(index);
+    }
+#endif
+
+    SECTION("FlexMem sparse") {
+        osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> index;
+        test_get_many(index);
+        REQUIRE_FALSE(index.is_dense());
+    }
+
+    SECTION("FlexMem dense") {
+        osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> index{true};
+        test_get_many(index);
+    }
+
+    SECTION("CompressedMem (default implementation)") {
+        osmium::index::map::CompressedMem<osmium::unsigned_object_id_type, osmium::Location> index;
+        test_get_many(index);
+    }
+
+}
+
+TEST_CASE("NodeLocationsForWays with positive and negative IDs") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    using namespace osmium::builder::attr;
+
+    index_type index_pos;
+    index_type index_neg;
+    osmium::handler::NodeLocationsForWays<index_type, index_type> handler{index_pos, index_neg};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(-2), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(1), _location(2.0, 2.0));
+    osmium::builder::add_node(buffer, _id(3), _location(3.0, 3.0));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, -2, 3, 1}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({1, 4}));
+
+    auto it = buffer.begin<osmium::OSMObject>();
+    handler.node(static_cast<const osmium::Node&>(*it++));
+    handler.node(static_cast<const osmium::Node&>(*it++));
+    handler.node(static_cast<const osmium::Node&>(*it++));
+
+    auto& way1 = static_cast<osmium::Way&>(*it++);
+    handler.way(way1);
+    REQUIRE(way1.nodes()[0].location() == (osmium::Location{2.0, 2.0}));
+    REQUIRE(way1.nodes()[1].location() == (osmium::Location{1.0, 1.0}));
+    REQUIRE(way1.nodes()[2].location() == (osmium::Location{3.0, 3.0}));
+    REQUIRE(way1.nodes()[3].location() == (osmium::Location{2.0, 2.0}));
+
+    auto& way2 = static_cast<osmium::Way&>(*it++);
+    REQUIRE_THROWS_AS(handler.way(way2), osmium::not_found);
+
+    handler.ignore_errors();
+    handler.way(way2);
+    REQUIRE(way2.nodes()[0].location() == (osmium::Location{2.0, 2.0}));
+    REQUIRE_FALSE(way2.nodes()[1].location().valid());
+}
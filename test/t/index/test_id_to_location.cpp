@@ -3,10 +3,12 @@
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/location.hpp>
 
+#include <osmium/index/map/compressed_mem.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
 #include <osmium/index/map/dummy.hpp>
+#include <osmium/index/map/flex_mem.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
 #include <osmium/index/map/sparse_mem_map.hpp>
@@ -158,6 +160,32 @@ TEST_CASE("IdToLocation") {
         test_func_real<index_type>(index2);
     }
 
+    SECTION("CompressedMem") {
+        typedef osmium::index::map::CompressedMem<osmium::unsigned_object_id_type, osmium::Location> index_type;
+
+        index_type index1;
+        test_func_all<index_type>(index1);
+
+        index_type index2;
+        test_func_real<index_type>(index2);
+    }
+
+    SECTION("FlexMem") {
+        typedef osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> index_type;
+
+        index_type index1;
+        test_func_all<index_type>(index1);
+
+        index_type index2;
+        test_func_real<index_type>(index2);
+
+        index_type index3{true};
+        test_func_all<index_type>(index3);
+
+        index_type index4{true};
+        test_func_real<index_type>(index4);
+    }
+
     SECTION("Dynamic map choice") {
         typedef osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> map_type;
         const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+#include <cstdint>
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+using namespace osmium::builder::attr;
+
+using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id * 10), static_cast<int32_t>(id * 20)};
+}
+
+static osmium::memory::Buffer create_nodes() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    // out of order, so the index has to be sorted
+    for (osmium::object_id_type id = 10000; id > 0; --id) {
+        osmium::builder::add_node(buffer, _id(id), _location(location_for(id)));
+        osmium::builder::add_node(buffer, _id(-id), _location(location_for(id + 100000)));
+    }
+    return buffer;
+}
+
+static osmium::memory::Buffer create_ways(bool with_missing_node) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 5000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({id, -id, id * 2, -(id * 2) + 1}));
+    }
+    if (with_missing_node) {
+        osmium::builder::add_way(buffer, _id(6000), _nodes({1, 20000}));
+    }
+    return buffer;
+}
+
+static void check_ways(const osmium::memory::Buffer& buffer) {
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        if (way.id() == 6000) {
+            REQUIRE(way.nodes()[0].location() == location_for(1));
+            REQUIRE_FALSE(way.nodes()[1].location().valid());
+            continue;
+        }
+        for (const auto& node_ref : way.nodes()) {
+            const auto id = node_ref.ref();
+            REQUIRE(node_ref.location() == (id > 0 ? location_for(id) : location_for(-id + 100000)));
+        }
+    }
+}
+
+TEST_CASE("Add locations to ways in buffer in parallel") {
+    int num_threads = 1;
+
+    SECTION("1 thread") {
+        num_threads = 1;
+    }
+
+    SECTION("4 threads") {
+        num_threads = 4;
+    }
+
+    osmium::thread::Pool pool{num_threads, 0};
+
+    index_type index_pos;
+    index_type index_neg;
+    osmium::handler::NodeLocationsForWays<index_type, index_type> handler{index_pos, index_neg};
+
+    auto nodes = create_nodes();
+    handler.apply_parallel(nodes, pool);
+    REQUIRE(index_pos.size() == 10000);
+    REQUIRE(index_neg.size() == 10000);
+
+    auto ways = create_ways(false);
+    handler.apply_parallel(ways, pool);
+    check_ways(ways);
+
+    auto ways_with_error = create_ways(true);
+    REQUIRE_THROWS_AS(handler.apply_parallel(ways_with_error, pool), osmium::not_found);
+
+    handler.ignore_errors();
+    auto ways_ignore_error = create_ways(true);
+    handler.apply_parallel(ways_ignore_error, pool);
+    check_ways(ways_ignore_error);
+}
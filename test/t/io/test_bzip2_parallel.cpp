@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <osmium/io/bzip2_compression.hpp>
+
+static std::string make_data() {
+    std::string data;
+    for (int i = 0; data.size() < 2 * 1024 * 1024; ++i) {
+        data += "line " + std::to_string(i) + " of test data " + std::to_string(i * 7919 % 1000) + "\n";
+    }
+    return data;
+}
+
+static std::string read_all(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    REQUIRE(fd > 0);
+
+    std::string all;
+    osmium::io::Bzip2ParallelDecompressor decomp{fd};
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+
+    return all;
+}
+
+static std::string compress(const std::string& data) {
+    const std::string filename{"test-bzip2-stream.bz2"};
+    {
+        const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        REQUIRE(fd > 0);
+        osmium::io::Bzip2Compressor comp{fd, osmium::io::fsync::no};
+        comp.write(data);
+        comp.close();
+        ::close(fd);
+    }
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static void write_file(const std::string& filename, const std::string& data) {
+    std::ofstream file{filename, std::ios::binary};
+    file << data;
+}
+
+TEST_CASE("Bit string") {
+    osmium::io::detail::bit_string bits;
+    bits.append_bits(0x5, 3);
+    REQUIRE(bits.num_bits() == 3);
+    REQUIRE(bits.data().empty());
+
+    const std::string data{"\x0f\xf0"};
+    bits.append(data.data(), 4, 8);
+    REQUIRE(bits.num_bits() == 11);
+    REQUIRE(bits.finish() == std::string{"\xbf\xe0"});
+}
+
+TEST_CASE("Parallel bzip2 decompression") {
+    SECTION("small file") {
+        REQUIRE(read_all(with_data_dir("t/io/data_bzip2.txt.bz2")) == "TESTDATA\n");
+    }
+
+    SECTION("file with several blocks") {
+        const std::string data = make_data();
+        const std::string filename{"test-bzip2-parallel.bz2"};
+        write_file(filename, compress(data));
+        REQUIRE(read_all(filename) == data);
+    }
+
+    SECTION("file with several streams") {
+        const std::string filename{"test-bzip2-multi-stream.bz2"};
+        write_file(filename, compress("foo") + compress("bar"));
+        REQUIRE(read_all(filename) == "foobar");
+    }
+}
+
+TEST_CASE("Parallel bzip2 decompression of broken files") {
+    SECTION("truncated file") {
+        const std::string filename{"test-bzip2-truncated.bz2"};
+        const std::string compressed = compress(make_data());
+        write_file(filename, compressed.substr(0, compressed.size() / 2));
+        REQUIRE_THROWS_AS(read_all(filename), osmium::bzip2_error);
+    }
+
+    SECTION("not a bzip2 file") {
+        REQUIRE_THROWS_AS(read_all(with_data_dir("t/io/data.osm")), osmium::bzip2_error);
+    }
+}
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/geojson_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+
+using namespace osmium::builder::attr;
+
+static osmium::memory::Buffer create_buffer() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(2), _uid(3), _user("fo\"o"), _timestamp("2016-01-01T00:00:00Z"),
+                              _location(1.5, 2.5), _tag("amenity", "bench"));
+    osmium::builder::add_node(buffer, _id(2), _version(2147483647u), _cid(4000000000u), _uid(2500000000u));
+    osmium::builder::add_way(buffer, _id(10), _nodes({{1, {1.0, 2.0}}, {2, {3.0, 4.0}}}), _tag("highway", "primary"));
+    osmium::builder::add_way(buffer, _id(11), _nodes({1, 2}));
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10), _tag("type", "route"));
+
+    {
+        osmium::builder::AreaBuilder builder{buffer};
+        builder.object().set_id(osmium::object_id_to_area_id(10, osmium::item_type::way));
+        builder.add_user("");
+        {
+            osmium::builder::OuterRingBuilder ring_builder{buffer, &builder};
+            ring_builder.add_node_ref(1, osmium::Location{0.0, 0.0});
+            ring_builder.add_node_ref(2, osmium::Location{1.0, 0.0});
+            ring_builder.add_node_ref(3, osmium::Location{1.0, 1.0});
+            ring_builder.add_node_ref(1, osmium::Location{0.0, 0.0});
+        }
+    }
+    buffer.commit();
+
+    return buffer;
+}
+
+static std::vector<std::string> write_and_read_lines(const std::string& filename, const char* format = "") {
+    osmium::io::File file{filename, format};
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(create_buffer());
+    writer.close();
+
+    std::vector<std::string> lines;
+    std::ifstream in{filename};
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+TEST_CASE("Write GeoJSON text sequence") {
+    const auto lines = write_and_read_lines("test-geojson-output.geojsonseq");
+    REQUIRE(lines.size() == 5);
+
+    REQUIRE(lines[0] == "\x1e{\"type\":\"Feature\",\"id\":\"n1\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[1.5,2.5]},"
+                        "\"properties\":{\"@type\":\"node\",\"@id\":1,\"@version\":2,\"@changeset\":0,\"@timestamp\":\"2016-01-01T00:00:00Z\","
+                        "\"@uid\":3,\"@user\":\"fo\\\"o\",\"amenity\":\"bench\"}}");
+    REQUIRE(lines[1].find("\"id\":\"n2\",\"geometry\":null,") != std::string::npos);
+    REQUIRE(lines[1].find("\"@version\":2147483647,\"@changeset\":4000000000,") != std::string::npos);
+    REQUIRE(lines[1].find("\"@uid\":2500000000,") != std::string::npos);
+    REQUIRE(lines[2].find("\"geometry\":{\"type\":\"LineString\",\"coordinates\":[[1,2],[3,4]]}") != std::string::npos);
+    REQUIRE(lines[2].find("\"highway\":\"primary\"") != std::string::npos);
+    REQUIRE(lines[3].find("\"id\":\"w11\",\"geometry\":null,") != std::string::npos);
+    REQUIRE(lines[4].find("\"id\":\"r20\",\"geometry\":null,") != std::string::npos);
+}
+
+TEST_CASE("Write GeoJSON FeatureCollection") {
+    const auto lines = write_and_read_lines("test-geojson-output.geojson");
+    REQUIRE(lines.size() == 7);
+
+    REQUIRE(lines[0] == "{\"type\":\"FeatureCollection\",\"features\":[");
+    REQUIRE(lines[1].find("{\"type\":\"Feature\",\"id\":\"n1\",") == 0);
+    REQUIRE(lines[1].back() == ',');
+    REQUIRE(lines[4].back() == ',');
+    REQUIRE(lines[5].find("{\"type\":\"Feature\",\"id\":\"r20\",") == 0);
+    REQUIRE(lines[5].back() == '}');
+    REQUIRE(lines[6] == "]}");
+}
+
+TEST_CASE("Write GeoJSON FeatureCollection with areas and without metadata") {
+    const auto lines = write_and_read_lines("test-geojson-output.geojsonseq", "geojsonseq,json_seq=false,json_areas=true,add_metadata=false");
+    REQUIRE(lines.size() == 8);
+
+    REQUIRE(lines[0] == "{\"type\":\"FeatureCollection\",\"features\":[");
+    REQUIRE(lines[1] == "{\"type\":\"Feature\",\"id\":\"n1\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[1.5,2.5]},"
+                        "\"properties\":{\"@type\":\"node\",\"@id\":1,\"amenity\":\"bench\"}},");
+    REQUIRE(lines[6] == "{\"type\":\"Feature\",\"id\":\"w10\",\"geometry\":{\"type\":\"MultiPolygon\",\"coordinates\":[[[[0,0],[1,0],[1,1],[0,0]]]]},"
+                        "\"properties\":{\"@type\":\"way\",\"@id\":10}}");
+    REQUIRE(lines[7] == "]}");
+}
+
+TEST_CASE("Write empty GeoJSON FeatureCollection") {
+    const std::string filename{"test-geojson-output-empty.geojson"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes});
+        writer.close();
+    }
+
+    std::ifstream in{filename};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content == "{\"type\":\"FeatureCollection\",\"features\":[\n\n]}\n");
+}
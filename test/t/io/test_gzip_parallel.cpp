@@ -0,0 +1,152 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <osmium/io/gzip_compression.hpp>
+
+static std::string make_data() {
+    std::string data;
+    for (int i = 0; data.size() < 3 * 1024 * 1024; ++i) {
+        data += "line " + std::to_string(i) + " of test data\n";
+    }
+    return data;
+}
+
+template <typename TDecompressor>
+static std::string read_all(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    REQUIRE(fd > 0);
+
+    std::string all;
+    TDecompressor decomp{fd};
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+
+    return all;
+}
+
+static void write_file(const std::string& filename, const std::string& data) {
+    const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    REQUIRE(fd > 0);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+}
+
+static std::string gzip_member(const std::string& data) {
+    const std::string filename{"test-gzip-member.gz"};
+    {
+        const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        REQUIRE(fd > 0);
+        osmium::io::GzipCompressor comp{fd, osmium::io::fsync::no};
+        comp.write(data);
+        comp.close();
+    }
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("BGZF block") {
+    std::string block;
+    osmium::io::detail::bgzf_compress_block("foobar", 6, block);
+    REQUIRE(osmium::io::detail::bgzf_block_size(block.data(), block.size()) == block.size());
+    REQUIRE(osmium::io::detail::bgzf_block_size(block.data(), 10) == 0);
+
+    std::string output;
+    osmium::io::detail::bgzf_decompress_block(block.data(), block.size(), output);
+    REQUIRE(output == "foobar");
+
+    const std::string member = gzip_member("foobar");
+    REQUIRE(osmium::io::detail::bgzf_block_size(member.data(), member.size()) == 0);
+}
+
+TEST_CASE("BGZF block with forged uncompressed size in trailer") {
+    std::string block;
+    osmium::io::detail::bgzf_compress_block("foobar", 6, block);
+
+    // set ISIZE (last four bytes, little endian) to 4 GB - 1
+    block[block.size() - 4] = '\xff';
+    block[block.size() - 3] = '\xff';
+    block[block.size() - 2] = '\xff';
+    block[block.size() - 1] = '\xff';
+
+    std::string output;
+    REQUIRE_THROWS_AS(osmium::io::detail::bgzf_decompress_block(block.data(), block.size(), output), osmium::gzip_error);
+    REQUIRE(output.empty());
+
+    // just above the limit
+    block[block.size() - 4] = '\x01';
+    block[block.size() - 3] = '\x00';
+    block[block.size() - 2] = '\x01';
+    block[block.size() - 1] = '\x00';
+    REQUIRE_THROWS_AS(osmium::io::detail::bgzf_decompress_block(block.data(), block.size(), output), osmium::gzip_error);
+    REQUIRE(output.empty());
+}
+
+TEST_CASE("BGZF block with size smaller than header and trailer") {
+    std::string block;
+    osmium::io::detail::bgzf_compress_block("foobar", 6, block);
+
+    // set BSIZE (block size - 1) to 0
+    block[16] = '\x00';
+    block[17] = '\x00';
+    REQUIRE_THROWS_AS(osmium::io::detail::bgzf_block_size(block.data(), block.size()), osmium::gzip_error);
+
+    // just below header (18 bytes) plus trailer (8 bytes)
+    block[16] = '\x18';
+    REQUIRE_THROWS_AS(osmium::io::detail::bgzf_block_size(block.data(), block.size()), osmium::gzip_error);
+
+    std::string output;
+    REQUIRE_THROWS_AS(osmium::io::detail::bgzf_decompress_block(block.data(), 25, output), osmium::gzip_error);
+    REQUIRE(output.empty());
+
+    const std::string filename{"test-gzip-parallel-bsize.gz"};
+    block[16] = '\x00';
+    write_file(filename, block);
+    REQUIRE_THROWS_AS(read_all<osmium::io::GzipParallelDecompressor>(filename), osmium::gzip_error);
+}
+
+TEST_CASE("Parallel gzip compression and decompression") {
+    const std::string data = make_data();
+    const std::string filename{"test-gzip-parallel.gz"};
+
+    {
+        const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        REQUIRE(fd > 0);
+        osmium::io::GzipParallelCompressor comp{fd, osmium::io::fsync::no};
+        for (size_t pos = 0; pos < data.size(); pos += 100000) {
+            comp.write(data.substr(pos, 100000));
+        }
+        comp.close();
+    }
+
+    REQUIRE(read_all<osmium::io::GzipDecompressor>(filename) == data);
+    REQUIRE(read_all<osmium::io::GzipParallelDecompressor>(filename) == data);
+}
+
+TEST_CASE("Parallel gzip decompression of normal gzip file") {
+    const std::string filename = with_data_dir("t/io/data.osm.gz");
+    REQUIRE(read_all<osmium::io::GzipParallelDecompressor>(filename) ==
+            read_all<osmium::io::GzipDecompressor>(filename));
+}
+
+TEST_CASE("Parallel gzip decompression of multi-member file") {
+    const std::string filename{"test-gzip-multi-member.gz"};
+    write_file(filename, gzip_member("foo") + gzip_member("bar"));
+    REQUIRE(read_all<osmium::io::GzipParallelDecompressor>(filename) == "foobar");
+}
+
+TEST_CASE("Parallel gzip decompression of truncated file") {
+    const std::string filename{"test-gzip-truncated.gz"};
+    const std::string member = gzip_member(make_data());
+    write_file(filename, member.substr(0, member.size() / 2));
+    REQUIRE_THROWS_AS(read_all<osmium::io::GzipParallelDecompressor>(filename), osmium::gzip_error);
+}
@@ -0,0 +1,163 @@
+#include "catch.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/way.hpp>
+
+using namespace osmium::builder::attr;
+
+static osmium::memory::Buffer create_buffer(osmium::object_id_type first_id) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // more different strings than fit into the string table
+    for (osmium::object_id_type id = first_id; id < first_id + 20000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _cid(id * 2), _uid(id % 7), _user("user" + std::to_string(id % 7)),
+                                  _timestamp(osmium::Timestamp{1400000000 + id}), _location(id * 0.0001, -id * 0.0001),
+                                  _tag("highway", "crossing"), _tag("ref", std::to_string(id)));
+    }
+
+    osmium::builder::add_way(buffer, _id(first_id), _version(3), _cid(5), _uid(1), _user("user1"), _timestamp(osmium::Timestamp{1500000000}),
+                             _nodes({first_id + 1, first_id + 2, first_id}), _tag("name", std::string(300, 'x')), _tag("highway", "crossing"));
+    osmium::builder::add_way(buffer, _id(first_id + 1), _version(2), _deleted(), _timestamp(osmium::Timestamp{1500000001}));
+    osmium::builder::add_way(buffer, _id(first_id + 2), _version(1));
+
+    osmium::builder::add_relation(buffer, _id(first_id), _version(1), _timestamp(osmium::Timestamp{1500000002}),
+                                  _member(osmium::item_type::node, first_id, "stop"),
+                                  _member(osmium::item_type::way, first_id, "stop"),
+                                  _member(osmium::item_type::relation, 1, ""),
+                                  _tag("type", "route"));
+
+    return buffer;
+}
+
+static void check_equal(const osmium::OSMObject& a, const osmium::OSMObject& b, bool metadata) {
+    REQUIRE(a.type() == b.type());
+    REQUIRE(a.id() == b.id());
+    REQUIRE(a.visible() == b.visible());
+    if (metadata) {
+        REQUIRE(a.version() == b.version());
+        REQUIRE(a.timestamp() == b.timestamp());
+        if (a.timestamp().valid()) {
+            REQUIRE(a.changeset() == b.changeset());
+            REQUIRE(a.uid() == b.uid());
+            if (a.uid() != 0) {
+                REQUIRE(std::string{a.user()} == b.user());
+            }
+        }
+    } else {
+        REQUIRE(b.version() == 0);
+    }
+
+    if (!a.visible()) {
+        return;
+    }
+
+    REQUIRE(a.tags().size() == b.tags().size());
+    auto it = b.tags().begin();
+    for (const auto& tag : a.tags()) {
+        REQUIRE(std::string{tag.key()} == it->key());
+        REQUIRE(std::string{tag.value()} == it->value());
+        ++it;
+    }
+
+    if (a.type() == osmium::item_type::node) {
+        REQUIRE(static_cast<const osmium::Node&>(a).location() == static_cast<const osmium::Node&>(b).location());
+    } else if (a.type() == osmium::item_type::way) {
+        const auto& an = static_cast<const osmium::Way&>(a).nodes();
+        const auto& bn = static_cast<const osmium::Way&>(b).nodes();
+        REQUIRE(an.size() == bn.size());
+        for (std::size_t i = 0; i < an.size(); ++i) {
+            REQUIRE(an[i].ref() == bn[i].ref());
+        }
+    } else if (a.type() == osmium::item_type::relation) {
+        const auto& am = static_cast<const osmium::Relation&>(a).members();
+        const auto& bm = static_cast<const osmium::Relation&>(b).members();
+        REQUIRE(am.size() == bm.size());
+        auto mit = bm.begin();
+        for (const auto& member : am) {
+            REQUIRE(member.type() == mit->type());
+            REQUIRE(member.ref() == mit->ref());
+            REQUIRE(std::string{member.role()} == mit->role());
+            ++mit;
+        }
+    }
+}
+
+static void write_and_compare(const char* format, bool metadata) {
+    std::vector<osmium::memory::Buffer> buffers;
+    buffers.push_back(create_buffer(1));
+    buffers.push_back(create_buffer(100000));
+
+    const std::string filename{"test-o5m-output.o5m"};
+    {
+        osmium::io::Header header;
+        header.add_box(osmium::Box{-1.5, -2.5, 3.5, 4.5});
+        header.set("o5m_timestamp", "2016-02-03T04:05:06Z");
+
+        osmium::io::Writer writer{osmium::io::File{filename, format}, header, osmium::io::overwrite::allow};
+        for (const auto& buffer : buffers) {
+            osmium::memory::Buffer copy{buffer.committed()};
+            copy.add_buffer(buffer);
+            copy.commit();
+            writer(std::move(copy));
+        }
+        writer.close();
+    }
+
+    std::vector<const osmium::OSMObject*> objects;
+    for (const auto& buffer : buffers) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            objects.push_back(&object);
+        }
+    }
+
+    osmium::io::Reader reader{osmium::io::File{filename, "o5m"}};
+    const osmium::io::Header header = reader.header();
+    REQUIRE(header.box() == (osmium::Box{-1.5, -2.5, 3.5, 4.5}));
+    REQUIRE(header.get("o5m_timestamp") == "2016-02-03T04:05:06Z");
+
+    std::size_t n = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(n < objects.size());
+            check_equal(*objects[n], object, metadata);
+            ++n;
+        }
+    }
+    reader.close();
+    REQUIRE(n == objects.size());
+}
+
+TEST_CASE("Write o5m file and read it back") {
+    write_and_compare("o5m", true);
+}
+
+TEST_CASE("Write o5m file without metadata and read it back") {
+    write_and_compare("o5m,add_metadata=false", false);
+}
+
+TEST_CASE("Write o5c file and read it back") {
+    const std::string filename{"test-o5m-output.o5c"};
+    osmium::io::Writer writer{osmium::io::File{filename, "o5c"}, osmium::io::overwrite::allow};
+    writer(create_buffer(1));
+    writer.close();
+
+    osmium::io::Reader reader{osmium::io::File{filename, "o5c"}};
+    REQUIRE(reader.header().has_multiple_object_versions());
+    const osmium::memory::Buffer buffer = reader.read();
+    REQUIRE(buffer);
+    const auto& way = *std::next(buffer.select<osmium::Way>().begin());
+    REQUIRE(way.id() == 2);
+    REQUIRE(way.deleted());
+    reader.close();
+}
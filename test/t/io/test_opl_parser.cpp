@@ -0,0 +1,185 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+using namespace osmium::builder::attr;
+
+static osmium::memory::Buffer parse(const std::string& data) {
+    return osmium::io::detail::OPLChunkDecoder{std::string{data}, osmium::osm_entity_bits::all}();
+}
+
+TEST_CASE("Parse OPL node") {
+    const auto buffer = parse("n17 v3 dV c42 t2015-06-01T12:00:00Z i-1 uf%20%o%e4%o%1f600% Tamenity=bench,name=a%2c%b x1.5 y-2.0000001\n");
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    REQUIRE(node.id() == 17);
+    REQUIRE(node.version() == 3);
+    REQUIRE(node.visible());
+    REQUIRE(node.changeset() == 42);
+    REQUIRE(node.timestamp() == osmium::Timestamp{"2015-06-01T12:00:00Z"});
+    REQUIRE(node.uid() == 4294967295u);
+    REQUIRE(std::string{node.user()} == "f o\xc3\xa4o\xf0\x9f\x98\x80");
+    REQUIRE(node.tags().size() == 2);
+    REQUIRE(std::string{node.tags().get_value_by_key("amenity")} == "bench");
+    REQUIRE(std::string{node.tags().get_value_by_key("name")} == "a,b");
+    REQUIRE(node.location().x() == 15000000);
+    REQUIRE(node.location().y() == -20000001);
+}
+
+TEST_CASE("Parse minimal OPL objects") {
+    const auto buffer = parse("# comment\n\nn-1\r\nw2 N\nr3 M T\nn4 dD x y\n");
+
+    auto it = buffer.cbegin<osmium::OSMObject>();
+    REQUIRE(it->id() == -1);
+    REQUIRE(it->version() == 0);
+    REQUIRE(it->tags().empty());
+    REQUIRE_FALSE(static_cast<const osmium::Node&>(*it).location());
+    ++it;
+    REQUIRE(it->type() == osmium::item_type::way);
+    REQUIRE(static_cast<const osmium::Way&>(*it).nodes().empty());
+    ++it;
+    REQUIRE(it->type() == osmium::item_type::relation);
+    REQUIRE(static_cast<const osmium::Relation&>(*it).members().empty());
+    ++it;
+    REQUIRE(it->id() == 4);
+    REQUIRE_FALSE(it->visible());
+    ++it;
+    REQUIRE(it == buffer.cend<osmium::OSMObject>());
+}
+
+TEST_CASE("Parse OPL way and relation") {
+    const auto buffer = parse("w5 v1 Thighway=primary Nn1,n2,n-3\n"
+                              "w6 Nn1x1.0000000y2.0000000,n2xy\n"
+                              "r7 Mn1@,w5@outer,r8@a%20%b Ttype=multipolygon\n");
+
+    auto it = buffer.cbegin<osmium::OSMObject>();
+    const auto& way = static_cast<const osmium::Way&>(*it);
+    REQUIRE(way.id() == 5);
+    REQUIRE(std::string{way.tags().get_value_by_key("highway")} == "primary");
+    REQUIRE(way.nodes().size() == 3);
+    REQUIRE(way.nodes()[0].ref() == 1);
+    REQUIRE(way.nodes()[2].ref() == -3);
+    REQUIRE_FALSE(way.nodes()[0].location());
+
+    const auto& way_with_locations = static_cast<const osmium::Way&>(*++it);
+    REQUIRE(way_with_locations.nodes()[0].location() == osmium::Location(1.0, 2.0));
+    REQUIRE_FALSE(way_with_locations.nodes()[1].location());
+
+    const auto& relation = static_cast<const osmium::Relation&>(*++it);
+    REQUIRE(relation.id() == 7);
+    REQUIRE(std::string{relation.tags().get_value_by_key("type")} == "multipolygon");
+    REQUIRE(relation.members().size() == 3);
+    auto member = relation.members().begin();
+    REQUIRE(member->type() == osmium::item_type::node);
+    REQUIRE(std::string{member->role()} == "");
+    ++member;
+    REQUIRE(member->type() == osmium::item_type::way);
+    REQUIRE(member->ref() == 5);
+    REQUIRE(std::string{member->role()} == "outer");
+    ++member;
+    REQUIRE(member->type() == osmium::item_type::relation);
+    REQUIRE(std::string{member->role()} == "a b");
+}
+
+TEST_CASE("Parse OPL changeset") {
+    const auto buffer = parse("c9 k12 s2015-06-01T12:00:00Z e2015-06-01T13:00:00Z d2 i5 ufoo x1.0 y2.0 X3.0 Y4.0 Tcomment=fix\n");
+    const auto& changeset = buffer.get<osmium::Changeset>(0);
+
+    REQUIRE(changeset.id() == 9);
+    REQUIRE(changeset.num_changes() == 12);
+    REQUIRE(changeset.num_comments() == 2);
+    REQUIRE(changeset.uid() == 5);
+    REQUIRE(changeset.closed_at() == osmium::Timestamp{"2015-06-01T13:00:00Z"});
+    REQUIRE(std::string{changeset.user()} == "foo");
+    REQUIRE(changeset.bounds().bottom_left() == osmium::Location(1.0, 2.0));
+    REQUIRE(changeset.bounds().top_right() == osmium::Location(3.0, 4.0));
+    REQUIRE(std::string{changeset.tags().get_value_by_key("comment")} == "fix");
+}
+
+TEST_CASE("Errors in OPL data") {
+    REQUIRE_THROWS_AS(parse("x1\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 q\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 v1x\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 v-1\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 x1234.5\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 t2015\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 Tfoo\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("n1 ua%zz%\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("w1 N1\n"), osmium::opl_error);
+    REQUIRE_THROWS_AS(parse("r1 Mx1@\n"), osmium::opl_error);
+}
+
+TEST_CASE("Write and read OPL file") {
+    const std::string filename{"test-opl-parser.osm.opl"};
+
+    {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        // enough data to be cut into several chunks
+        for (int i = 1; i <= 100000; ++i) {
+            osmium::builder::add_node(buffer, _id(i), _version(2), _timestamp("2016-01-01T00:00:00Z"), _user("some user"),
+                                      _location(i * 0.001, -i * 0.0001), _tag("name", "x=" + std::to_string(i)));
+        }
+        for (int i = 1; i <= 1000; ++i) {
+            osmium::builder::add_way(buffer, _id(i), _node(i), _node(i + 1));
+        }
+        osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::way, 1, "outer"));
+
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    SECTION("all objects") {
+        int nodes = 0;
+        int ways = 0;
+        int relations = 0;
+        osmium::io::Reader reader{filename};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                ++nodes;
+                REQUIRE(node.id() == nodes);
+                REQUIRE(node.version() == 2);
+                REQUIRE(std::string{node.user()} == "some user");
+                REQUIRE(node.location() == osmium::Location(nodes * 0.001, -nodes * 0.0001));
+                REQUIRE(std::string{node.tags().get_value_by_key("name")} == "x=" + std::to_string(nodes));
+            }
+            for (const auto& way : buffer.select<osmium::Way>()) {
+                ++ways;
+                REQUIRE(way.nodes()[1].ref() == ways + 1);
+            }
+            for (const auto& relation : buffer.select<osmium::Relation>()) {
+                ++relations;
+                REQUIRE(std::string{relation.members().begin()->role()} == "outer");
+            }
+        }
+        reader.close();
+
+        REQUIRE(nodes == 100000);
+        REQUIRE(ways == 1000);
+        REQUIRE(relations == 1);
+    }
+
+    SECTION("only ways") {
+        int count = 0;
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                REQUIRE(object.type() == osmium::item_type::way);
+                ++count;
+            }
+        }
+        reader.close();
+        REQUIRE(count == 1000);
+    }
+}
@@ -41,6 +41,14 @@ TEST_CASE("output formatted") {
 
 }
 
+TEST_CASE("JSON encoding") {
+
+    std::string out;
+    osmium::io::detail::append_json_encoded_string(out, "a\"b\\c\nd\te\x01" "f\xc3\xa4");
+    REQUIRE(out == "a\\\"b\\\\c\\nd\\te\\u0001f\xc3\xa4");
+
+}
+
 TEST_CASE("UTF8 encoding") {
 
     std::string out;
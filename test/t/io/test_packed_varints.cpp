@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <protozero/pbf_reader.hpp>
+#include <protozero/pbf_writer.hpp>
+#include <protozero/varint.hpp>
+
+static std::vector<int64_t> make_values() {
+    std::vector<int64_t> values;
+
+    // long runs of one-byte varints and some longer ones in between
+    for (int64_t i = 0; i < 1000; ++i) {
+        values.push_back(i % 50 - 25);
+        if (i % 37 == 0) {
+            values.push_back(i * 100000);
+        }
+        if (i % 101 == 0) {
+            values.push_back(-i * 10000000000);
+        }
+    }
+    values.push_back(std::numeric_limits<int64_t>::max());
+    values.push_back(std::numeric_limits<int64_t>::min());
+    values.push_back(0);
+
+    return values;
+}
+
+TEST_CASE("Decode array of varints") {
+    const std::vector<int64_t> values = make_values();
+
+    std::string data;
+    for (const auto value : values) {
+        protozero::write_varint(std::back_inserter(data), static_cast<uint64_t>(value));
+    }
+
+    REQUIRE(protozero::count_varints(data.data(), data.data() + data.size()) == values.size());
+
+    std::vector<int64_t> decoded(values.size());
+    const int64_t* end = protozero::decode_varints(data.data(), data.data() + data.size(), decoded.data());
+    REQUIRE(end == decoded.data() + decoded.size());
+    REQUIRE(decoded == values);
+
+    SECTION("incomplete varint at end") {
+        data += '\x80';
+        REQUIRE(protozero::count_varints(data.data(), data.data() + data.size()) == values.size());
+        REQUIRE_THROWS_AS(protozero::decode_varints(data.data(), data.data() + data.size(), decoded.data()), protozero::end_of_buffer_exception);
+    }
+
+    SECTION("varint too long") {
+        std::string bad(12, '\xff');
+        bad += '\x01';
+        std::vector<uint64_t> out(1);
+        REQUIRE_THROWS_AS(protozero::decode_varints(bad.data(), bad.data() + bad.size(), out.data()), protozero::varint_too_long_exception);
+    }
+}
+
+TEST_CASE("Decode packed fields into vectors") {
+    const std::vector<int64_t> values = make_values();
+    std::vector<int32_t> small_values;
+    for (const auto value : values) {
+        small_values.push_back(static_cast<int32_t>(value % 100000));
+    }
+
+    std::string data;
+    {
+        protozero::pbf_writer writer{data};
+        writer.add_packed_sint64(1, values.cbegin(), values.cend());
+        writer.add_packed_int32(2, small_values.cbegin(), small_values.cend());
+        writer.add_packed_sint32(3, small_values.cbegin(), small_values.cend());
+        writer.add_bytes(4, std::string{}); // empty packed field
+    }
+
+    std::vector<int64_t> int64_values{1, 2, 3};
+    std::vector<int32_t> int32_values;
+    std::vector<int32_t> sint32_values;
+
+    protozero::pbf_reader reader{data};
+
+    REQUIRE(reader.next(1));
+    reader.get_packed_sint64(int64_values);
+    REQUIRE(int64_values == values);
+
+    REQUIRE(reader.next(2));
+    reader.get_packed_int32(int32_values);
+    REQUIRE(int32_values == small_values);
+
+    REQUIRE(reader.next(3));
+    reader.get_packed_sint32(sint32_values);
+    REQUIRE(sint32_values == small_values);
+
+    REQUIRE(reader.next(4));
+    reader.get_packed_sint64(int64_values);
+    REQUIRE(int64_values.empty());
+
+    REQUIRE_FALSE(reader.next());
+}
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <zlib.h>
+
+// A blob codec that counts how often it is called. It must be defined
+// before any libosmium header is included.
+struct counting_blob_codec {
+
+    static int compress_count;
+    static int uncompress_count;
+
+    static std::string compress(const std::string& input, int level) {
+        ++compress_count;
+        uLongf size = compressBound(static_cast<uLong>(input.size()));
+        std::string output(size, '\0');
+        if (::compress2(reinterpret_cast<Bytef*>(&output[0]), &size, reinterpret_cast<const Bytef*>(input.data()), static_cast<uLong>(input.size()), level) != Z_OK) {
+            throw std::runtime_error{"compress failed"};
+        }
+        output.resize(size);
+        return output;
+    }
+
+    static void uncompress(const char* input, std::size_t input_size, char* output, std::size_t raw_size) {
+        ++uncompress_count;
+        uLongf size = static_cast<uLongf>(raw_size);
+        if (::uncompress(reinterpret_cast<Bytef*>(output), &size, reinterpret_cast<const Bytef*>(input), static_cast<uLong>(input_size)) != Z_OK) {
+            throw std::runtime_error{"uncompress failed"};
+        }
+    }
+
+};
+
+int counting_blob_codec::compress_count = 0;
+int counting_blob_codec::uncompress_count = 0;
+
+#define OSMIUM_PBF_BLOB_CODEC counting_blob_codec
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+using namespace osmium::builder::attr;
+
+TEST_CASE("Default blob codecs round trip") {
+    const std::string input(10000, 'x');
+
+    const std::string compressed = osmium::io::detail::zlib_blob_codec::compress(input, Z_DEFAULT_COMPRESSION);
+    REQUIRE(compressed.size() < input.size());
+
+    std::string output(input.size(), '\0');
+    osmium::io::detail::zlib_blob_codec::uncompress(compressed.data(), compressed.size(), &output[0], output.size());
+    REQUIRE(output == input);
+
+    REQUIRE_THROWS_AS(osmium::io::detail::zlib_blob_codec::uncompress(input.data(), input.size(), &output[0], output.size()), osmium::io_error);
+}
+
+TEST_CASE("PBF reader and writer use configured blob codec") {
+    const std::string filename{"test-pbf-blob-codec.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 1000; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _version(1), _location(1.5, 2.5), _tag("amenity", "bench"));
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(counting_blob_codec::compress_count >= 2); // header and data
+    REQUIRE(counting_blob_codec::uncompress_count == 0);
+
+    osmium::io::Reader reader{filename};
+    int count = 0;
+    while (osmium::memory::Buffer b = reader.read()) {
+        for (const auto& node : b.select<osmium::Node>()) {
+            REQUIRE(node.tags().has_tag("amenity", "bench"));
+            ++count;
+        }
+    }
+    reader.close();
+
+    REQUIRE(count == 1000);
+    REQUIRE(counting_blob_codec::uncompress_count >= 2);
+}
@@ -0,0 +1,179 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+
+using namespace osmium::builder::attr;
+
+static const int num_objects = 20000; // more than fit into one blob
+
+static std::string write_test_file() {
+    const std::string filename{"test-pbf-blob-index.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= num_objects; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _version(1), _location(1.5, 2.5));
+    }
+    for (int i = 1; i <= num_objects; ++i) {
+        osmium::builder::add_way(buffer, _id(i), _version(1), _node(1), _node(2));
+    }
+    for (int i = 1; i <= 10; ++i) {
+        osmium::builder::add_relation(buffer, _id(i), _version(1), _member(osmium::item_type::way, 1));
+    }
+
+    osmium::io::Header header;
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    return filename;
+}
+
+TEST_CASE("Build PBF blob index") {
+
+    const std::string filename = write_test_file();
+
+    const osmium::io::PBFBlobIndex index = osmium::io::PBFBlobIndex::build(filename);
+    REQUIRE(index.size() > 4);
+
+    const auto& first = index.blobs().front();
+    REQUIRE(first.types == osmium::osm_entity_bits::node);
+    REQUIRE(first.min_id(osmium::item_type::node) == 1);
+
+    const auto& last = index.blobs().back();
+    REQUIRE(last.types == osmium::osm_entity_bits::relation);
+    REQUIRE(last.min_id(osmium::item_type::relation) == 1);
+    REQUIRE(last.max_id(osmium::item_type::relation) == 10);
+
+    REQUIRE(index.find(osmium::item_type::node) == first.offset);
+    REQUIRE(index.find(osmium::item_type::relation) == last.offset);
+    REQUIRE(index.find(osmium::item_type::way, num_objects + 1) == last.offset);
+    REQUIRE(index.find(osmium::item_type::relation, 11) == index.file_size());
+    REQUIRE(index.find(osmium::item_type::changeset) == index.file_size());
+
+    SECTION("write and read index") {
+        const std::string index_filename{filename + ".idx"};
+        index.write(index_filename);
+
+        const osmium::io::PBFBlobIndex index2 = osmium::io::PBFBlobIndex::read(index_filename);
+        REQUIRE(index2.file_size() == index.file_size());
+        REQUIRE(index2.size() == index.size());
+        for (size_t i = 0; i < index.size(); ++i) {
+            REQUIRE(index2.blobs()[i].offset == index.blobs()[i].offset);
+            REQUIRE(index2.blobs()[i].types == index.blobs()[i].types);
+            REQUIRE(index2.blobs()[i].min_ids == index.blobs()[i].min_ids);
+            REQUIRE(index2.blobs()[i].max_ids == index.blobs()[i].max_ids);
+        }
+
+        const osmium::io::PBFBlobIndex index3 = osmium::io::PBFBlobIndex::open(filename);
+        REQUIRE(index3.size() == index.size());
+
+        std::remove(index_filename.c_str());
+    }
+
+    SECTION("sidecar for file with different modification time is ignored") {
+        const std::string index_filename{filename + ".idx"};
+        {
+            std::ofstream out{index_filename};
+            out << "osmium-pbf-blob-index 3 " << index.file_size() << ' ' << (index.file_mtime() - 1) << '\n';
+            out << "0 1 1 1 0 0 0 0\n";
+        }
+
+        const osmium::io::PBFBlobIndex index2 = osmium::io::PBFBlobIndex::open(filename);
+        REQUIRE(index2.file_mtime() == index.file_mtime());
+        REQUIRE(index2.size() == index.size());
+
+        std::remove(index_filename.c_str());
+    }
+
+    SECTION("read from offset") {
+        const auto offset = index.find(osmium::item_type::way, 15000);
+
+        osmium::io::Reader reader{filename, osmium::io::start_offset{offset}};
+        int nodes = 0;
+        int ways = 0;
+        int relations = 0;
+        osmium::object_id_type first_way_id = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                switch (object.type()) {
+                    case osmium::item_type::node:
+                        ++nodes;
+                        break;
+                    case osmium::item_type::way:
+                        if (first_way_id == 0) {
+                            first_way_id = object.id();
+                        }
+                        ++ways;
+                        break;
+                    default:
+                        ++relations;
+                }
+            }
+        }
+        reader.close();
+
+        REQUIRE(nodes == 0);
+        REQUIRE(first_way_id > 1);
+        REQUIRE(first_way_id <= 15000);
+        REQUIRE(ways == num_objects - first_way_id + 1);
+        REQUIRE(relations == 10);
+    }
+
+    SECTION("read from end of file") {
+        osmium::io::Reader reader{filename, osmium::io::start_offset{index.file_size()}};
+        REQUIRE_FALSE(reader.read());
+        reader.close();
+    }
+
+    SECTION("invalid offset") {
+        osmium::io::Reader reader{filename, osmium::io::start_offset{index.file_size() + 1}};
+        REQUIRE_THROWS_AS(reader.read(), osmium::pbf_error);
+    }
+
+}
+
+TEST_CASE("Reading from offset does not work on non-PBF files") {
+    REQUIRE_THROWS_AS({
+        osmium::io::Reader reader(std::string{"test.osm"}, osmium::io::start_offset{100});
+    }, osmium::io_error);
+}
+
+TEST_CASE("Building PBF blob index for non-PBF file fails") {
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::build(with_data_dir("t/io/data.osm")), osmium::pbf_error);
+}
+
+TEST_CASE("PBF blob index with several object types in one blob") {
+    const std::string index_filename{"test-pbf-blob-index-mixed.osm.pbf.idx"};
+    {
+        const auto nw = static_cast<unsigned int>(osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
+        const auto w = static_cast<unsigned int>(osmium::osm_entity_bits::way);
+        std::ofstream out{index_filename};
+        out << "osmium-pbf-blob-index 3 3000 0\n";
+        // nodes 1 to 1000, ways 1 to 10
+        out << "1000 " << nw << " 1 1000 1 10 0 0\n";
+        // ways 11 to 500
+        out << "2000 " << w << " 0 0 11 500 0 0\n";
+    }
+
+    const osmium::io::PBFBlobIndex index = osmium::io::PBFBlobIndex::read(index_filename);
+    REQUIRE(index.size() == 2);
+    REQUIRE(index.blobs()[0].max_id(osmium::item_type::node) == 1000);
+    REQUIRE(index.blobs()[0].max_id(osmium::item_type::way) == 10);
+
+    REQUIRE(index.find(osmium::item_type::node, 500) == 1000);
+    REQUIRE(index.find(osmium::item_type::way, 5) == 1000);
+    REQUIRE(index.find(osmium::item_type::way, 100) == 2000);
+    REQUIRE(index.find(osmium::item_type::way, 501) == 3000);
+
+    std::remove(index_filename.c_str());
+}
@@ -0,0 +1,149 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include <protozero/pbf_builder.hpp>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+using namespace osmium::builder::attr;
+
+static void write_file(const std::string& filename, const std::string& format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 10000; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _version(1), _location(i * 0.001, 2.5), _tag("amenity", "bench"));
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static int count_nodes(const std::string& filename) {
+    int count = 0;
+    osmium::io::Reader reader{filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == count + 1);
+            REQUIRE(node.tags().has_tag("amenity", "bench"));
+            ++count;
+        }
+    }
+    reader.close();
+    return count;
+}
+
+TEST_CASE("Write and read PBF files with different compressions") {
+    const std::string filename{"test-pbf-compression.osm.pbf"};
+
+    SECTION("none") {
+        write_file(filename, "pbf,pbf_compression=none");
+        REQUIRE(count_nodes(filename) == 10000);
+    }
+
+    SECTION("zlib with default level") {
+        write_file(filename, "pbf,pbf_compression=zlib");
+        REQUIRE(count_nodes(filename) == 10000);
+    }
+
+    SECTION("zlib with level 1") {
+        write_file(filename, "pbf,pbf_compression=zlib,pbf_compression_level=1");
+        REQUIRE(count_nodes(filename) == 10000);
+    }
+
+    SECTION("lz4") {
+        if (osmium::io::detail::lz4_available()) {
+            write_file(filename, "pbf,pbf_compression=lz4");
+            REQUIRE(count_nodes(filename) == 10000);
+            write_file(filename, "pbf,pbf_compression=lz4,pbf_compression_level=9");
+            REQUIRE(count_nodes(filename) == 10000);
+        } else {
+            REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression=lz4"), osmium::io_error);
+        }
+    }
+
+    SECTION("zstd") {
+        if (osmium::io::detail::zstd_available()) {
+            write_file(filename, "pbf,pbf_compression=zstd");
+            REQUIRE(count_nodes(filename) == 10000);
+            write_file(filename, "pbf,pbf_compression=zstd,pbf_compression_level=19");
+            REQUIRE(count_nodes(filename) == 10000);
+        } else {
+            REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression=zstd"), osmium::io_error);
+        }
+    }
+}
+
+TEST_CASE("Illegal PBF compression options") {
+    const std::string filename{"test-pbf-compression-illegal.osm.pbf"};
+
+    REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression=foo"), osmium::io_error);
+    REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression_level=x"), osmium::io_error);
+    REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression_level=3x"), osmium::io_error);
+    REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression_level=10"), osmium::io_error);
+    REQUIRE_THROWS_AS(write_file(filename, "pbf,pbf_compression_level=-2"), osmium::io_error);
+}
+
+TEST_CASE("PBF compression level range depends on compression") {
+    using osmium::io::detail::pbf_compression;
+    using osmium::io::detail::get_pbf_compression_level;
+
+    REQUIRE(get_pbf_compression_level("-1", pbf_compression::zlib) == -1);
+    REQUIRE_THROWS_AS(get_pbf_compression_level("-2", pbf_compression::zlib), osmium::io_error);
+    REQUIRE_THROWS_AS(get_pbf_compression_level("10", pbf_compression::zlib), osmium::io_error);
+
+    REQUIRE(get_pbf_compression_level("12", pbf_compression::lz4) == 12);
+    REQUIRE_THROWS_AS(get_pbf_compression_level("-1", pbf_compression::lz4), osmium::io_error);
+    REQUIRE_THROWS_AS(get_pbf_compression_level("13", pbf_compression::lz4), osmium::io_error);
+
+    const int zstd_max = osmium::io::detail::zstd_max_compression_level();
+    REQUIRE(get_pbf_compression_level(std::to_string(zstd_max), pbf_compression::zstd) == zstd_max);
+    REQUIRE_THROWS_AS(get_pbf_compression_level(std::to_string(zstd_max + 1), pbf_compression::zstd), osmium::io_error);
+
+    REQUIRE(get_pbf_compression_level("100", pbf_compression::none) == 0);
+    REQUIRE_THROWS_AS(get_pbf_compression_level("x", pbf_compression::none), osmium::io_error);
+}
+
+TEST_CASE("Parse PBF compression options") {
+    using osmium::io::detail::pbf_compression;
+
+    REQUIRE(osmium::io::detail::get_pbf_compression("") == pbf_compression::zlib);
+    REQUIRE(osmium::io::detail::get_pbf_compression("true") == pbf_compression::zlib);
+    REQUIRE(osmium::io::detail::get_pbf_compression("false") == pbf_compression::none);
+    REQUIRE(osmium::io::detail::get_pbf_compression("none") == pbf_compression::none);
+
+    REQUIRE(osmium::io::detail::get_pbf_compression_level("", pbf_compression::zlib) == -1);
+    REQUIRE(osmium::io::detail::get_pbf_compression_level("", pbf_compression::zstd) == 0);
+    REQUIRE(osmium::io::detail::get_pbf_compression_level("-5", pbf_compression::zstd) == -5);
+    REQUIRE(osmium::io::detail::get_pbf_compression_level("9", pbf_compression::zlib) == 9);
+}
+
+TEST_CASE("Decode blob with unsupported compression") {
+    using namespace osmium::io::detail;
+
+    std::string data;
+    protozero::pbf_builder<FileFormat::Blob> pbf_blob{data};
+    pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, 100);
+
+    std::string output;
+
+    SECTION("lz4") {
+        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_lz4_data, "not really lz4");
+        REQUIRE_THROWS_AS(decode_blob(data, output), osmium::io_error);
+    }
+
+    SECTION("zstd") {
+        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, "not really zstd");
+        REQUIRE_THROWS_AS(decode_blob(data, output), osmium::io_error);
+    }
+
+    SECTION("lzma") {
+        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_lzma_data, "not really lzma");
+        REQUIRE_THROWS_AS(decode_blob(data, output), osmium::pbf_error);
+    }
+}
@@ -0,0 +1,198 @@
+#include "catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+using namespace osmium::builder::attr;
+
+// Write objects in many small buffers, so the PrimitiveBlocks have to be
+// filled from several of them.
+static void write_file(const std::string& filename, const char* format) {
+    osmium::io::File file{filename, format};
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+
+    int id = 1;
+    while (id <= 20000) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int n = 0; n < 3001 && id <= 20000; ++n, ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _location(id * 0.001, 1.0), _tag("n", std::to_string(id)));
+        }
+        if (id > 20000) {
+            for (int i = 1; i <= 10; ++i) {
+                osmium::builder::add_way(buffer, _id(i), _version(1), _node(i), _node(i + 1));
+            }
+        }
+        writer(std::move(buffer));
+    }
+
+    writer.close();
+}
+
+TEST_CASE("Write PBF file with blocks built from several buffers") {
+    std::string filename;
+    const char* format = "";
+
+    SECTION("dense nodes") {
+        filename = "test-pbf-output-blocks.osm.pbf";
+        format = "pbf";
+    }
+
+    SECTION("no dense nodes") {
+        filename = "test-pbf-output-blocks-nondense.osm.pbf";
+        format = "pbf,pbf_dense_nodes=false";
+    }
+
+    write_file(filename, format);
+
+    std::vector<int> nodes_in_buffer;
+    osmium::object_id_type last_id = 0;
+    int ways = 0;
+
+    osmium::io::Reader reader{filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        int nodes = 0;
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == last_id + 1);
+            REQUIRE(node.tags().get_value_by_key("n") == std::to_string(node.id()));
+            last_id = node.id();
+            ++nodes;
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.id() == ways + 1);
+            REQUIRE(way.nodes()[0].ref() == way.id());
+            ++ways;
+        }
+        if (nodes > 0) {
+            nodes_in_buffer.push_back(nodes);
+        }
+    }
+    reader.close();
+
+    REQUIRE(last_id == 20000);
+    REQUIRE(ways == 10);
+    REQUIRE(nodes_in_buffer == (std::vector<int>{8000, 8000, 4000}));
+}
+
+static std::streamoff write_tagged_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // rare strings first, so that the frequent ones get large IDs in
+    // first-seen order
+    for (int i = 1; i <= 5000; ++i) {
+        const std::string rare = "rare" + std::to_string(i);
+        osmium::builder::add_node(buffer, _id(i), _version(1), _user(i <= 500 ? rare.c_str() : "common"), _location(1.0, 1.0),
+                                  _tag(i <= 500 ? rare : "amenity", i <= 500 ? "x" : "bench"));
+    }
+    osmium::builder::add_relation(buffer, _id(1), _version(1), _user("common"), _member(osmium::item_type::node, 1, "rare1"), _member(osmium::item_type::node, 2, "role"));
+
+    osmium::io::File file{filename, format};
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    std::ifstream in{filename, std::ios::binary | std::ios::ate};
+    return in.tellg();
+}
+
+TEST_CASE("Write PBF file with string tables sorted by frequency") {
+    const char* format = "pbf,pbf_compression=none";
+    const char* sorted_format = "pbf,pbf_compression=none,pbf_sort_string_table=true";
+
+    SECTION("dense nodes") {
+    }
+
+    SECTION("no dense nodes") {
+        format = "pbf,pbf_compression=none,pbf_dense_nodes=false";
+        sorted_format = "pbf,pbf_compression=none,pbf_dense_nodes=false,pbf_sort_string_table=true";
+    }
+
+    const auto size = write_tagged_file("test-pbf-output-unsorted.osm.pbf", format);
+    const auto sorted_size = write_tagged_file("test-pbf-output-sorted.osm.pbf", sorted_format);
+    REQUIRE(sorted_size < size);
+
+    int count = 0;
+    osmium::io::Reader reader{"test-pbf-output-sorted.osm.pbf"};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ++count;
+            const std::string rare = "rare" + std::to_string(node.id());
+            if (node.id() <= 500) {
+                REQUIRE(rare == node.user());
+                REQUIRE(std::string{"x"} == node.tags().get_value_by_key(rare.c_str()));
+            } else {
+                REQUIRE(std::string{"common"} == node.user());
+                REQUIRE(std::string{"bench"} == node.tags().get_value_by_key("amenity"));
+            }
+        }
+        for (const auto& relation : buffer.select<osmium::Relation>()) {
+            ++count;
+            REQUIRE(std::string{"common"} == relation.user());
+            REQUIRE(std::string{"rare1"} == relation.members().begin()->role());
+            REQUIRE(std::string{"role"} == std::next(relation.members().begin())->role());
+        }
+    }
+    reader.close();
+
+    REQUIRE(count == 5001);
+}
+
+TEST_CASE("Write PBF file with ways whose encoded size is larger than in the buffer") {
+    const std::string filename{"test-pbf-output-large-ways.osm.pbf"};
+    const int num_ways = 1100;
+    const int num_nodes = 2000;
+
+    // Node IDs and locations jump back and forth, so that every node ref
+    // with location needs about 20 bytes encoded, but only 16 bytes in
+    // the buffer.
+    {
+        osmium::memory::Buffer buffer{64 * 1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int i = 1; i <= num_ways; ++i) {
+            {
+                osmium::builder::WayBuilder builder{buffer};
+                builder.object().set_id(i);
+                builder.object().set_version(1);
+                builder.add_user("");
+                osmium::builder::WayNodeListBuilder wnl_builder{buffer, &builder};
+                for (int n = 0; n < num_nodes; ++n) {
+                    if (n % 2) {
+                        wnl_builder.add_node_ref(1LL << 60, osmium::Location{179.9, 89.9});
+                    } else {
+                        wnl_builder.add_node_ref(1, osmium::Location{-179.9, -89.9});
+                    }
+                }
+            }
+            buffer.commit();
+        }
+
+        osmium::io::File file{filename, "pbf,pbf_compression=none,locations_on_ways=true"};
+        osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    int ways = 0;
+    osmium::io::Reader reader{filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            ++ways;
+            REQUIRE(way.id() == ways);
+            REQUIRE(way.nodes().size() == num_nodes);
+            REQUIRE(way.nodes()[1].ref() == (1LL << 60));
+            REQUIRE(way.nodes()[1].location() == osmium::Location(179.9, 89.9));
+        }
+    }
+    reader.close();
+
+    REQUIRE(ways == num_ways);
+}
@@ -0,0 +1,188 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include <protozero/pbf_builder.hpp>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/zlib.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/way.hpp>
+
+using namespace osmium::builder::attr;
+using namespace osmium::io::detail;
+
+TEST_CASE("Uncompress zlib data incrementally") {
+    std::string input;
+    for (int i = 0; i < 100000; ++i) {
+        input += std::to_string(i);
+    }
+    const std::string compressed = zlib_compress(input);
+
+    ZlibInflateStream stream{compressed.data(), compressed.size()};
+    unsigned char byte;
+    REQUIRE(stream.get(byte));
+    REQUIRE(byte == input[0]);
+
+    // skip over more than the internal buffer size
+    REQUIRE(stream.skip(100000));
+    REQUIRE(stream.get(byte));
+    REQUIRE(byte == input[100001]);
+
+    REQUIRE(stream.skip(input.size() - 100002));
+    REQUIRE_FALSE(stream.get(byte));
+    REQUIRE_FALSE(stream.skip(1));
+}
+
+TEST_CASE("Get type of first group in PrimitiveBlock") {
+    std::string data;
+    protozero::pbf_builder<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+    {
+        protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{pbf_primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
+        pbf_string_table.add_string(OSMFormat::StringTable::repeated_bytes_s, "");
+        pbf_string_table.add_string(OSMFormat::StringTable::repeated_bytes_s, "highway");
+    }
+    {
+        protozero::pbf_builder<OSMFormat::PrimitiveGroup> pbf_primitive_group{pbf_primitive_block, OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup};
+        protozero::pbf_builder<OSMFormat::Way> pbf_way{pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Way_ways};
+        pbf_way.add_int64(OSMFormat::Way::required_int64_id, 17);
+    }
+
+    REQUIRE(get_first_group_type(ptr_len_type{data.data(), data.size()}) == osmium::osm_entity_bits::way);
+    REQUIRE(get_first_group_type(ptr_len_type{data.data(), 5}) == osmium::osm_entity_bits::nothing);
+    REQUIRE(get_first_group_type(ptr_len_type{data.data(), 0}) == osmium::osm_entity_bits::nothing);
+}
+
+TEST_CASE("Get type of first group in zlib compressed blob with large string table") {
+    std::string data;
+    protozero::pbf_builder<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+    {
+        protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{pbf_primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
+        for (int i = 0; i < 100000; ++i) {
+            pbf_string_table.add_string(OSMFormat::StringTable::repeated_bytes_s, std::to_string(i));
+        }
+    }
+    {
+        protozero::pbf_builder<OSMFormat::PrimitiveGroup> pbf_primitive_group{pbf_primitive_block, OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup};
+        protozero::pbf_builder<OSMFormat::Relation> pbf_relation{pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Relation_relations};
+        pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, 17);
+    }
+    REQUIRE(data.size() > 256 * 1024);
+
+    std::string blob;
+    protozero::pbf_builder<FileFormat::Blob> pbf_blob{blob};
+    pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(data.size()));
+    pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, zlib_compress(data));
+
+    REQUIRE(peek_blob_first_group_type(ptr_len_type{blob.data(), blob.size()}) == osmium::osm_entity_bits::relation);
+}
+
+static std::string make_blob(bool way, bool compress) {
+    std::string data;
+    protozero::pbf_builder<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+    {
+        protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{pbf_primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
+        pbf_string_table.add_string(OSMFormat::StringTable::repeated_bytes_s, "");
+    }
+    {
+        protozero::pbf_builder<OSMFormat::PrimitiveGroup> pbf_primitive_group{pbf_primitive_block, OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup};
+        if (way) {
+            protozero::pbf_builder<OSMFormat::Way> pbf_way{pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Way_ways};
+            pbf_way.add_int64(OSMFormat::Way::required_int64_id, 17);
+        } else {
+            protozero::pbf_builder<OSMFormat::Node> pbf_node{pbf_primitive_group, OSMFormat::PrimitiveGroup::repeated_Node_nodes};
+            pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, 17);
+            pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, 0);
+            pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, 0);
+        }
+    }
+
+    std::string blob;
+    protozero::pbf_builder<FileFormat::Blob> pbf_blob{blob};
+    if (compress) {
+        pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(data.size()));
+        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, zlib_compress(data));
+    } else {
+        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_raw, data);
+    }
+    return blob;
+}
+
+TEST_CASE("Decoder skips blobs with unwanted types") {
+    for (const bool compress : {false, true}) {
+        PBFDataBlobDecoder nodes{make_blob(false, compress), osmium::osm_entity_bits::way};
+        PBFDataBlobDecoder ways{make_blob(true, compress), osmium::osm_entity_bits::way};
+
+        nodes.skip_unwanted_types(&ways);
+        osmium::memory::Buffer buffer = nodes();
+        REQUIRE(buffer);
+        REQUIRE(buffer.committed() == 0);
+
+        ways.skip_unwanted_types(nullptr);
+        buffer = ways();
+        REQUIRE(buffer.committed() > 0);
+        REQUIRE(buffer.get<osmium::Way>(0).id() == 17);
+    }
+}
+
+static std::string write_sorted_file(const char* format) {
+    const std::string filename{"test-pbf-skip-blobs.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 20000; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _version(1), _location(1.5, 2.5), _tag("amenity", "bench"));
+    }
+    for (int i = 1; i <= 10000; ++i) {
+        osmium::builder::add_way(buffer, _id(i), _version(1), _node(1), _node(2));
+    }
+    for (int i = 1; i <= 10; ++i) {
+        osmium::builder::add_relation(buffer, _id(i), _version(1), _member(osmium::item_type::way, 1));
+    }
+
+    osmium::io::Header header;
+    header.set("sorting", "Type_then_ID");
+    osmium::io::Writer writer{osmium::io::File{filename, format}, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    return filename;
+}
+
+static void count_objects(const std::string& filename, osmium::osm_entity_bits::type types, int* counts) {
+    osmium::io::Reader reader{filename, types};
+    REQUIRE(reader.header().get("sorting") == "Type_then_ID");
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ++counts[static_cast<int>(object.type()) - 1];
+        }
+    }
+    reader.close();
+}
+
+TEST_CASE("Read only some types from PBF file sorted by type") {
+    for (const char* format : {"pbf", "pbf,pbf_compression=none"}) {
+        const std::string filename = write_sorted_file(format);
+
+        int counts[3] = {0, 0, 0};
+        count_objects(filename, osmium::osm_entity_bits::relation, counts);
+        REQUIRE(counts[0] == 0);
+        REQUIRE(counts[1] == 0);
+        REQUIRE(counts[2] == 10);
+
+        int counts_ways[3] = {0, 0, 0};
+        count_objects(filename, osmium::osm_entity_bits::way, counts_ways);
+        REQUIRE(counts_ways[0] == 0);
+        REQUIRE(counts_ways[1] == 10000);
+        REQUIRE(counts_ways[2] == 0);
+
+        int counts_nr[3] = {0, 0, 0};
+        count_objects(filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation, counts_nr);
+        REQUIRE(counts_nr[0] == 20000);
+        REQUIRE(counts_nr[1] == 0);
+        REQUIRE(counts_nr[2] == 10);
+    }
+}
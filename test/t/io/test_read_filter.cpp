@@ -0,0 +1,223 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+using namespace osmium::builder::attr;
+
+static void write_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 100; ++i) {
+        osmium::builder::add_node(buffer, _id(i), _version(1), _location(i * 0.1, i * 0.1), _tag("n", std::to_string(i)));
+    }
+    for (int i = 1; i <= 20; ++i) {
+        osmium::builder::add_way(buffer, _id(i), _version(1), _node(i), _node(i + 1));
+    }
+    osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1));
+
+    osmium::io::File file{filename, format};
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+struct counts {
+    int nodes = 0;
+    int ways = 0;
+    int relations = 0;
+    osmium::object_id_type min_node_id = 0;
+    osmium::object_id_type max_node_id = 0;
+};
+
+template <typename... TArgs>
+static counts count_objects(const osmium::io::File& file, TArgs&&... args) {
+    counts c;
+    osmium::io::Reader reader{file, std::forward<TArgs>(args)...};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            if (c.nodes == 0) {
+                c.min_node_id = node.id();
+            }
+            c.max_node_id = node.id();
+            REQUIRE(node.tags().get_value_by_key("n") == std::to_string(node.id()));
+            ++c.nodes;
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.nodes().size() == 2);
+            REQUIRE(way.nodes()[0].ref() == way.id());
+            ++c.ways;
+        }
+        c.relations += std::distance(buffer.select<osmium::Relation>().cbegin(), buffer.select<osmium::Relation>().cend());
+    }
+    reader.close();
+    return c;
+}
+
+TEST_CASE("Read with bounding box and ID range filters") {
+    std::string filename;
+    const char* format = "";
+
+    SECTION("PBF with dense nodes") {
+        filename = "test-read-filter.osm.pbf";
+        format = "pbf";
+    }
+
+    SECTION("PBF without dense nodes") {
+        filename = "test-read-filter-nondense.osm.pbf";
+        format = "pbf,pbf_dense_nodes=false";
+    }
+
+    SECTION("XML") {
+        filename = "test-read-filter.osm";
+        format = "osm";
+    }
+
+    write_file(filename, format);
+    const osmium::io::File file{filename, format};
+
+    const osmium::Box box{osmium::Location{1.05, 1.05}, osmium::Location{2.05, 2.05}};
+
+    const counts all = count_objects(file);
+    REQUIRE(all.nodes == 100);
+    REQUIRE(all.ways == 20);
+    REQUIRE(all.relations == 1);
+
+    const counts in_box = count_objects(file, box);
+    REQUIRE(in_box.nodes == 10);
+    REQUIRE(in_box.min_node_id == 11);
+    REQUIRE(in_box.max_node_id == 20);
+    REQUIRE(in_box.ways == 20);
+    REQUIRE(in_box.relations == 1);
+
+    const counts in_range = count_objects(file, osmium::io::id_range{5, 15});
+    REQUIRE(in_range.nodes == 11);
+    REQUIRE(in_range.min_node_id == 5);
+    REQUIRE(in_range.max_node_id == 15);
+    REQUIRE(in_range.ways == 11);
+    REQUIRE(in_range.relations == 0);
+
+    const counts both = count_objects(file, box, osmium::io::id_range{15, 30}, osmium::osm_entity_bits::node);
+    REQUIRE(both.nodes == 6);
+    REQUIRE(both.min_node_id == 15);
+    REQUIRE(both.max_node_id == 20);
+    REQUIRE(both.ways == 0);
+}
+
+static void append_varint(std::string& data, uint64_t value) {
+    while (value >= 0x80) {
+        data += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    data += static_cast<char>(value);
+}
+
+static void append_zvarint(std::string& data, int64_t value) {
+    append_varint(data, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static void append_dataset(std::string& data, char type, const std::string& payload) {
+    data += type;
+    append_varint(data, payload.size());
+    data += payload;
+}
+
+// Nodes 1, 2, and 3 at (1,1), (2,2), (3,3). Node 1 has an inline tag, node 3
+// refers back to it through the string table. Way 10 has nodes 1 and 2.
+static std::string make_o5m() {
+    std::string data{"\xff\xe0\x04o5m2", 7};
+
+    std::string node1;
+    append_zvarint(node1, 1);
+    node1 += '\0'; // no info
+    append_zvarint(node1, 10000000);
+    append_zvarint(node1, 10000000);
+    node1.append("\0n\0x\0", 5);
+    append_dataset(data, 0x10, node1);
+
+    std::string node2;
+    append_zvarint(node2, 1);
+    node2 += '\0';
+    append_zvarint(node2, 10000000);
+    append_zvarint(node2, 10000000);
+    append_dataset(data, 0x10, node2);
+
+    std::string node3;
+    append_zvarint(node3, 1);
+    node3 += '\0';
+    append_zvarint(node3, 10000000);
+    append_zvarint(node3, 10000000);
+    append_varint(node3, 1); // string table reference
+    append_dataset(data, 0x10, node3);
+
+    std::string refs;
+    append_zvarint(refs, 1);
+    append_zvarint(refs, 1);
+
+    std::string way;
+    append_zvarint(way, 7);
+    way += '\0';
+    append_varint(way, refs.size());
+    way += refs;
+    way.append("\0n\0y\0", 5);
+    append_dataset(data, 0x11, way);
+
+    data += '\xfe';
+    return data;
+}
+
+static std::vector<osmium::object_id_type> read_o5m_ids(const std::string& data, std::vector<std::string>& values, const osmium::Box& box, osmium::io::id_range range) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::File file{data.data(), data.size(), "o5m"};
+    osmium::io::Reader reader{file, box, range};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.id());
+            const char* value = object.tags().get_value_by_key("n");
+            values.emplace_back(value ? value : "");
+            if (object.type() == osmium::item_type::way) {
+                const auto& way = static_cast<const osmium::Way&>(object);
+                REQUIRE(way.nodes().size() == 2);
+                REQUIRE(way.nodes()[0].ref() == 1);
+                REQUIRE(way.nodes()[1].ref() == 2);
+            }
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+TEST_CASE("Read O5M with bounding box and ID range filters") {
+    const std::string data = make_o5m();
+    std::vector<std::string> values;
+
+    SECTION("ID range including everything") {
+        const auto ids = read_o5m_ids(data, values, osmium::Box{}, osmium::io::id_range{1, 100});
+        REQUIRE(ids == (std::vector<osmium::object_id_type>{1, 2, 3, 10}));
+        REQUIRE(values == (std::vector<std::string>{"x", "", "x", "y"}));
+    }
+
+    SECTION("bounding box") {
+        const osmium::Box box{osmium::Location{1.5, 1.5}, osmium::Location{3.5, 3.5}};
+        const auto ids = read_o5m_ids(data, values, box, osmium::io::id_range{1, 100});
+        REQUIRE(ids == (std::vector<osmium::object_id_type>{2, 3, 10}));
+        REQUIRE(values == (std::vector<std::string>{"", "x", "y"}));
+    }
+
+    SECTION("ID range") {
+        const auto ids = read_o5m_ids(data, values, osmium::Box{}, osmium::io::id_range{3, 3});
+        REQUIRE(ids == (std::vector<osmium::object_id_type>{3}));
+        REQUIRE(values == (std::vector<std::string>{"x"}));
+    }
+}
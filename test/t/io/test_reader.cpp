@@ -165,6 +165,54 @@ TEST_CASE("Reader") {
         REQUIRE(handler.total_count == 2);
     }
 
+    SECTION("should decode PBF from memory mapped file") {
+        osmium::io::Reader reader(with_data_dir("t/io/deleted_nodes.osh.pbf"),
+                                  osmium::io::mmap_input::yes,
+                                  osmium::osm_entity_bits::node);
+        ZeroPositionNodeCountHandler handler;
+
+        REQUIRE(reader.header().has_multiple_object_versions());
+
+        osmium::apply(reader, handler);
+
+        REQUIRE(handler.count == 0);
+        REQUIRE(handler.total_count == 2);
+        REQUIRE(reader.eof());
+    }
+
+    SECTION("should ignore mmap_input option for XML files") {
+        osmium::io::Reader reader(with_data_dir("t/io/data.osm"), osmium::io::mmap_input::yes);
+        CountHandler handler;
+
+        osmium::apply(reader, handler);
+
+        REQUIRE(handler.count == 1);
+    }
+
+    SECTION("should work with small queues") {
+        osmium::io::Reader reader(with_data_dir("t/io/deleted_nodes.osh.pbf"),
+                                  osmium::io::queue_length{1},
+                                  osmium::io::queue_bytes{1});
+        ZeroPositionNodeCountHandler handler;
+
+        osmium::apply(reader, handler);
+
+        REQUIRE(handler.total_count == 2);
+    }
+
+    SECTION("should accept recycled buffers") {
+        osmium::io::Reader reader(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+        CountHandler handler;
+
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            osmium::apply(buffer, handler);
+            reader.recycle(std::move(buffer));
+        }
+        reader.recycle(osmium::memory::Buffer{});
+
+        REQUIRE(handler.count == 2);
+    }
+
 }
 
 TEST_CASE("Reader failure modes") {
@@ -187,6 +235,12 @@ TEST_CASE("Reader failure modes") {
         });
     }
 
+    SECTION("should fail with nonexistent file (pbf, mmap)") {
+        REQUIRE_THROWS({
+            osmium::io::Reader reader(with_data_dir("t/io/nonexistent-file.osm.pbf"), osmium::io::mmap_input::yes);
+        });
+    }
+
     SECTION("should work when there is an exception in main thread before getting header") {
         try {
             osmium::io::Reader reader(with_data_dir("t/io/data.osm"));
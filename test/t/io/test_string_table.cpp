@@ -90,5 +90,35 @@ TEST_CASE("String table") {
         REQUIRE(st.size() == 1);
     }
 
+    SECTION("sort by frequency") {
+        st.count("foo");
+        st.count("bar");
+        st.count("baz");
+        st.count("baz");
+        st.count("bar");
+        st.count("baz");
+        REQUIRE_FALSE(st.sorted());
+
+        st.sort_by_frequency();
+        REQUIRE(st.sorted());
+        REQUIRE(st.add("baz") == 1);
+        REQUIRE(st.add("bar") == 2);
+        REQUIRE(st.add("foo") == 3);
+        REQUIRE(st.add("new") == 4);
+        REQUIRE(st.size() == 5);
+
+        const auto& strings = st.sorted_strings();
+        REQUIRE(strings.size() == 5);
+        REQUIRE(std::string("") == strings[0]);
+        REQUIRE(std::string("baz") == strings[1]);
+        REQUIRE(std::string("bar") == strings[2]);
+        REQUIRE(std::string("foo") == strings[3]);
+        REQUIRE(std::string("new") == strings[4]);
+
+        st.clear();
+        REQUIRE_FALSE(st.sorted());
+        REQUIRE(st.add("foo") == 1);
+    }
+
 }
 
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/tags/filter.hpp>
+
+using namespace osmium::builder::attr;
+
+static osmium::memory::Buffer make_data() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 100; ++i) {
+        if (i % 10 == 0) {
+            osmium::builder::add_node(buffer, _id(i), _version(1), _location(1.5, 2.5), _tag("highway", "crossing"), _tag("name", "x"));
+        } else if (i % 5 == 0) {
+            osmium::builder::add_node(buffer, _id(i), _version(1), _location(1.5, 2.5), _tag("amenity", "bench"));
+        } else {
+            osmium::builder::add_node(buffer, _id(i), _version(1), _location(1.5 + i, 2.5));
+        }
+    }
+    for (int i = 1; i <= 20; ++i) {
+        if (i % 2 == 0) {
+            osmium::builder::add_way(buffer, _id(i), _version(1), _node(1), _node(2), _tag("highway", i % 4 == 0 ? "primary" : "residential"));
+        } else {
+            osmium::builder::add_way(buffer, _id(i), _version(1), _node(1), _node(2), _tag("building", "yes"));
+        }
+    }
+    osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1), _tag("type", "route"));
+    osmium::builder::add_relation(buffer, _id(2), _version(1), _member(osmium::item_type::way, 2), _tag("highway", "pedestrian"));
+    return buffer;
+}
+
+static std::string write_file(const std::string& filename) {
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(make_data());
+    writer.close();
+    return filename;
+}
+
+struct counts {
+    int nodes = 0;
+    int ways = 0;
+    int relations = 0;
+    osmium::object_id_type last_node_id = 0;
+    bool locations_ok = true;
+};
+
+template <typename TFilter>
+static counts read_file(const std::string& filename, const TFilter& filter) {
+    counts c;
+    osmium::io::Reader reader{filename, osmium::io::tag_filter{filter}};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    ++c.nodes;
+                    c.last_node_id = object.id();
+                    if (static_cast<const osmium::Node&>(object).location() != osmium::Location{1.5, 2.5}) {
+                        c.locations_ok = false;
+                    }
+                    break;
+                case osmium::item_type::way:
+                    ++c.ways;
+                    break;
+                default:
+                    ++c.relations;
+            }
+        }
+    }
+    reader.close();
+    return c;
+}
+
+TEST_CASE("Read only objects matching a tag filter") {
+    std::string filename;
+
+    SECTION("PBF with dense nodes") {
+        filename = write_file("test-tag-filter.osm.pbf");
+    }
+
+    SECTION("PBF without dense nodes") {
+        filename = "test-tag-filter-nondense.osm.pbf";
+        osmium::io::File file{filename, "pbf,pbf_dense_nodes=false"};
+        osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+        writer(make_data());
+        writer.close();
+    }
+
+    SECTION("XML") {
+        filename = write_file("test-tag-filter.osm");
+    }
+
+    osmium::tags::KeyFilter highway{false};
+    highway.add(true, "highway");
+
+    const counts c = read_file(filename, highway);
+    REQUIRE(c.nodes == 10);
+    REQUIRE(c.last_node_id == 100);
+    REQUIRE(c.locations_ok);
+    REQUIRE(c.ways == 10);
+    REQUIRE(c.relations == 1);
+
+    osmium::tags::KeyValueFilter primary{false};
+    primary.add(true, "highway", "primary").add(true, "amenity");
+
+    const counts c2 = read_file(filename, primary);
+    REQUIRE(c2.nodes == 10);
+    REQUIRE(c2.locations_ok);
+    REQUIRE(c2.ways == 5);
+    REQUIRE(c2.relations == 0);
+}
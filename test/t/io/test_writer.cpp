@@ -69,6 +69,17 @@ TEST_CASE("Writer") {
             writer.close();
         }
 
+        SECTION("Writer with small queue") {
+            filename = "test-writer-out-small-queue.osm";
+            osmium::io::Writer writer(filename, header, osmium::io::overwrite::allow,
+                                      osmium::io::queue_length{1}, osmium::io::queue_bytes{1});
+            for (const auto& item : buffer) {
+                writer(item);
+                writer.flush();
+            }
+            writer.close();
+        }
+
         SECTION("Writer output iterator") {
             filename = "test-writer-out-iterator.osm";
             osmium::io::Writer writer(filename, header, osmium::io::overwrite::allow);
@@ -0,0 +1,146 @@
+#include "catch.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+static std::string make_xml(int num_nodes) {
+    std::string xml{"<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\" generator=\"test\">\n"};
+    xml += "  <bounds minlon=\"-1\" minlat=\"-1\" maxlon=\"1\" maxlat=\"1\"/>\n";
+    for (int i = 1; i <= num_nodes; ++i) {
+        xml += "  <node id=\"" + std::to_string(i) + "\" version=\"1\" lon=\"1.5\" lat=\"2.5\">\n";
+        xml += "    <tag k=\"name\" v=\"node &lt;node&gt;\"/>\n";
+        xml += "  </node>\n";
+    }
+    xml += "  <way id=\"1\" version=\"1\">\n    <nd ref=\"1\"/>\n    <nd ref=\"2\"/>\n  </way>\n";
+    xml += "</osm>\n";
+    return xml;
+}
+
+static int count_nodes(osmium::io::Reader& reader, osmium::object_id_type& last_id, int& ways) {
+    int count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == last_id + 1);
+            last_id = node.id();
+            ++count;
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.nodes().size() == 2);
+            ++ways;
+        }
+    }
+    return count;
+}
+
+TEST_CASE("Find start tags of OSM objects in XML data") {
+
+    const std::string data{"<node id=\"1\"/><nodes/>\n<way id=\"2\">\n<nd ref=\"1\"/></way><relation"};
+
+    REQUIRE(osmium::io::detail::find_first_object_start(data) == 0);
+    REQUIRE(osmium::io::detail::find_last_object_start(data) == 23);
+    REQUIRE(osmium::io::detail::find_first_object_start(std::string{"<osm><bounds/>"}) == std::string::npos);
+    REQUIRE(osmium::io::detail::find_last_object_start(std::string{"<osm><bounds/>"}) == std::string::npos);
+}
+
+TEST_CASE("Track sections in osmChange data") {
+
+    std::string section;
+    const std::string data{"<create>\n<node id=\"1\"/>\n</create>\n<delete>\n<node id=\"2\"/>"};
+
+    osmium::io::detail::update_change_section(data.data(), data.data() + 8, section);
+    REQUIRE(section == "create");
+
+    osmium::io::detail::update_change_section(data.data(), data.data() + data.size(), section);
+    REQUIRE(section == "delete");
+
+    const std::string end{"</delete>\n<modify/>"};
+    osmium::io::detail::update_change_section(end.data(), end.data() + end.size(), section);
+    REQUIRE(section.empty());
+}
+
+TEST_CASE("Decode chunk of XML data") {
+
+    SECTION("chunk of osm file") {
+        osmium::io::detail::XMLChunkDecoder decoder{"<osm version=\"0.6\">",
+                                                    "<node id=\"3\" version=\"1\"/><node id=\"4\" version=\"1\"/>",
+                                                    "</osm>",
+                                                    osmium::osm_entity_bits::all};
+        const osmium::memory::Buffer buffer = decoder();
+        auto it = buffer.select<osmium::Node>().cbegin();
+        REQUIRE(it->id() == 3);
+        ++it;
+        REQUIRE(it->id() == 4);
+        REQUIRE(it->visible());
+    }
+
+    SECTION("chunk of osmChange file starting in delete section") {
+        osmium::io::detail::XMLChunkDecoder decoder{"<osmChange version=\"0.6\"><delete>",
+                                                    "<node id=\"3\" version=\"2\"/></delete><modify><node id=\"4\" version=\"2\"/>",
+                                                    "</modify></osmChange>",
+                                                    osmium::osm_entity_bits::all};
+        const osmium::memory::Buffer buffer = decoder();
+        auto it = buffer.select<osmium::Node>().cbegin();
+        REQUIRE(it->id() == 3);
+        REQUIRE_FALSE(it->visible());
+        ++it;
+        REQUIRE(it->id() == 4);
+        REQUIRE(it->visible());
+    }
+
+    SECTION("broken chunk") {
+        osmium::io::detail::XMLChunkDecoder decoder{"<osm version=\"0.6\">",
+                                                    "<node id=\"3\" version=\"1\">",
+                                                    "</osm>",
+                                                    osmium::osm_entity_bits::all};
+        REQUIRE_THROWS_AS(decoder(), osmium::xml_error);
+    }
+
+}
+
+TEST_CASE("Reading XML in parallel gives same result as sequential reading") {
+
+    const int num_nodes = 60000; // more than one chunk
+    const std::string xml = make_xml(num_nodes);
+
+    for (const char* setting : {"false", "true"}) {
+        setenv("OSMIUM_USE_POOL_THREADS_FOR_XML_PARSING", setting, 1);
+
+        osmium::io::File file{xml.data(), xml.size(), "osm"};
+        osmium::io::Reader reader{file};
+
+        const osmium::io::Header header = reader.header();
+        REQUIRE(header.get("generator") == "test");
+        REQUIRE(header.box().valid());
+
+        osmium::object_id_type last_id = 0;
+        int ways = 0;
+        REQUIRE(count_nodes(reader, last_id, ways) == num_nodes);
+        REQUIRE(ways == 1);
+        reader.close();
+    }
+
+    setenv("OSMIUM_USE_POOL_THREADS_FOR_XML_PARSING", "true", 1);
+
+    SECTION("only header") {
+        osmium::io::File file{xml.data(), xml.size(), "osm"};
+        osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+        REQUIRE(reader.header().get("generator") == "test");
+        reader.close();
+    }
+
+    SECTION("truncated input") {
+        osmium::io::File file{xml.data(), xml.size() - 10, "osm"};
+        osmium::io::Reader reader{file};
+        REQUIRE_THROWS_AS({
+            while (reader.read()) {
+            }
+        }, osmium::xml_error);
+    }
+
+    unsetenv("OSMIUM_USE_POOL_THREADS_FOR_XML_PARSING");
+}
@@ -219,4 +219,14 @@ TEST_CASE("Filter") {
         check_filter(tag_list, filter, {false, true});
     }
 
+    SECTION("Filter_can_be_applied_to_key_and_value") {
+        osmium::tags::KeyValueFilter filter(false);
+        filter.add(true, "highway", "residential").add(true, "name");
+
+        REQUIRE(filter("highway", "residential"));
+        REQUIRE_FALSE(filter("highway", "primary"));
+        REQUIRE(filter("name", "Hauptstraße"));
+        REQUIRE_FALSE(filter("amenity", "bench"));
+    }
+
 }
@@ -1,8 +1,11 @@
 #include "catch.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 #include <osmium/thread/pool.hpp>
 #include <osmium/util/compatibility.hpp>
@@ -70,3 +73,103 @@ TEST_CASE("thread") {
 
 }
 
+
+TEST_CASE("high priority tasks run before normal priority tasks, each in submission order") {
+
+    osmium::thread::Pool pool{1, 0};
+    REQUIRE(pool.num_threads() == 1);
+
+    std::promise<void> start;
+    std::shared_future<void> started{start.get_future()};
+
+    // block the only worker until all tasks are submitted
+    auto blocker = pool.submit([started] {
+        started.wait();
+    });
+
+    std::vector<int> order;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 3; ++i) {
+        futures.push_back(pool.submit([&order, i] {
+            order.push_back(i);
+        }, osmium::thread::task_priority::normal));
+    }
+    for (int i = 10; i < 13; ++i) {
+        futures.push_back(pool.submit([&order, i] {
+            order.push_back(i);
+        }, osmium::thread::task_priority::high));
+    }
+
+    start.set_value();
+    blocker.get();
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    REQUIRE(order == (std::vector<int>{10, 11, 12, 0, 1, 2}));
+}
+
+TEST_CASE("tasks can submit tasks to the pool") {
+
+    osmium::thread::Pool pool{2, 1};
+
+    auto future = pool.submit([&pool] {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 20; ++i) {
+            futures.push_back(pool.submit(test_job_with_result{}));
+        }
+        int sum = 0;
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+        return sum;
+    });
+
+    REQUIRE(future.get() == 20 * 42);
+}
+
+TEST_CASE("all tasks are run with many threads") {
+
+    osmium::thread::Pool pool{4, 2};
+
+    std::atomic<int> count{0};
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([&count] {
+            ++count;
+        }, i % 2 ? osmium::thread::task_priority::high : osmium::thread::task_priority::normal));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    REQUIRE(count == 1000);
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("several threads outside the pool submit to a pool with small queue") {
+
+    osmium::thread::Pool pool{4, 1};
+
+    std::atomic<int> count{0};
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 2; ++t) {
+        submitters.emplace_back([&pool, &count] {
+            std::vector<std::future<void>> futures;
+            for (int i = 0; i < 2000; ++i) {
+                futures.push_back(pool.submit([&count] {
+                    ++count;
+                }));
+            }
+            for (auto& future : futures) {
+                future.get();
+            }
+        });
+    }
+    for (auto& submitter : submitters) {
+        submitter.join();
+    }
+
+    REQUIRE(count == 4000);
+    REQUIRE(pool.queue_empty());
+}
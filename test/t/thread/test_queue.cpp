@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include <osmium/thread/queue.hpp>
+
+TEST_CASE("push and pop on unbounded queue") {
+    osmium::thread::Queue<int> queue;
+    REQUIRE(queue.empty());
+
+    for (int i = 0; i < 10; ++i) {
+        queue.push(i);
+    }
+    REQUIRE(queue.size() == 10);
+
+    int value = -1;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 0);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 1);
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.push_count == 10);
+    REQUIRE(stats.full_count == 0);
+    REQUIRE(stats.largest_size == 10);
+}
+
+TEST_CASE("try_pop on empty queue") {
+    osmium::thread::Queue<int> queue{2, "test"};
+    REQUIRE(queue.name() == "test");
+    REQUIRE(queue.max_size() == 2);
+
+    int value = -1;
+    REQUIRE_FALSE(queue.try_pop(value));
+    REQUIRE(value == -1);
+}
+
+TEST_CASE("push on full queue blocks until there is space") {
+    osmium::thread::Queue<int> queue{2};
+
+    std::thread producer{[&queue] {
+        for (int i = 0; i < 100; ++i) {
+            queue.push(i);
+        }
+    }};
+
+    for (int i = 0; i < 100; ++i) {
+        int value = -1;
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+    }
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.push_count == 100);
+    REQUIRE(stats.largest_size <= 2);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("shutdown wakes up blocked producer") {
+    osmium::thread::Queue<int> queue{1};
+    queue.push(1);
+
+    std::thread producer{[&queue] {
+        queue.push(2);
+    }};
+
+    // give the producer a chance to block
+    while (queue.stats().full_count == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    queue.shutdown();
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.full_count == 1);
+    REQUIRE(stats.push_wait_time > std::chrono::steady_clock::duration::zero());
+    REQUIRE(queue.size() == 2);
+}
+
+TEST_CASE("queue limited by bytes") {
+    osmium::thread::Queue<int> queue{0, "bytes", 100};
+    REQUIRE(queue.max_bytes() == 100);
+
+    // one element is always allowed in, even if it is larger than the limit
+    queue.push(1, 1000);
+    REQUIRE(queue.bytes() == 1000);
+
+    std::thread producer{[&queue] {
+        queue.push(2, 10);
+    }};
+
+    while (queue.stats().full_count == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    producer.join();
+
+    REQUIRE(queue.bytes() == 10);
+    REQUIRE(queue.stats().largest_bytes == 1000);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 2);
+    REQUIRE(queue.bytes() == 0);
+}
@@ -0,0 +1,144 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/multimap.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/sort.hpp>
+
+static std::vector<std::pair<uint64_t, uint64_t>> make_data(std::size_t size) {
+    std::mt19937_64 gen{42};
+    std::vector<std::pair<uint64_t, uint64_t>> data;
+    data.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data.emplace_back(gen() % (size / 2), i);
+    }
+    return data;
+}
+
+TEST_CASE("Parallel sort with different numbers of threads") {
+    auto data = make_data(1000000);
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+
+    int num_threads = 1;
+
+    SECTION("1 thread") {
+        num_threads = 1;
+    }
+
+    SECTION("2 threads") {
+        num_threads = 2;
+    }
+
+    SECTION("3 threads") {
+        num_threads = 3;
+    }
+
+    SECTION("7 threads") {
+        num_threads = 7;
+    }
+
+    osmium::thread::Pool pool{num_threads, 0};
+    osmium::thread::parallel_sort(data.begin(), data.end(), std::less<std::pair<uint64_t, uint64_t>>{}, pool);
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Parallel sort with comparison function") {
+    auto data = make_data(500000);
+    osmium::thread::Pool pool{4, 0};
+    osmium::thread::parallel_sort(data.begin(), data.end(), [](const std::pair<uint64_t, uint64_t>& a, const std::pair<uint64_t, uint64_t>& b) {
+        return a.first > b.first;
+    }, pool);
+
+    REQUIRE(std::is_sorted(data.cbegin(), data.cend(), [](const std::pair<uint64_t, uint64_t>& a, const std::pair<uint64_t, uint64_t>& b) {
+        return a.first > b.first;
+    }));
+}
+
+TEST_CASE("Merge sorted ranges with a small buffer") {
+    auto data = make_data(10000);
+    std::sort(data.begin(), data.begin() + 3000);
+    std::sort(data.begin() + 3000, data.end());
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<std::pair<uint64_t, uint64_t>> buffer;
+    osmium::thread::detail::merge_with_buffer(data.begin(), data.begin() + 3000, data.end(), buffer, 7, std::less<std::pair<uint64_t, uint64_t>>{});
+    REQUIRE(data == expected);
+    REQUIRE(buffer.size() <= 7);
+}
+
+TEST_CASE("Parallel sort of small and empty ranges") {
+    osmium::thread::Pool pool{4, 0};
+
+    std::vector<int> data{5, 3, 1, 4, 2};
+    osmium::thread::parallel_sort(data.begin(), data.end(), pool);
+    REQUIRE(data == (std::vector<int>{1, 2, 3, 4, 5}));
+
+    std::vector<int> empty;
+    osmium::thread::parallel_sort(empty.begin(), empty.end(), pool);
+    REQUIRE(empty.empty());
+}
+
+TEST_CASE("Sort sparse index in parallel") {
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    for (osmium::unsigned_object_id_type id = 200000; id > 0; --id) {
+        index.set(id * 2, osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id)});
+    }
+    osmium::thread::Pool pool{4, 0};
+    index.sort(pool);
+
+    REQUIRE(std::is_sorted(index.cbegin(), index.cend()));
+    REQUIRE(index.get(1000) == (osmium::Location{500, 500}));
+    REQUIRE_THROWS_AS(index.get(1001), osmium::not_found);
+}
+
+TEST_CASE("Sort index in parallel through the map interface") {
+    using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> sparse_index;
+    osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> dense_index;
+    for (osmium::unsigned_object_id_type id = 200000; id > 0; --id) {
+        const osmium::Location location{static_cast<int32_t>(id), static_cast<int32_t>(id)};
+        sparse_index.set(id * 2, location);
+        dense_index.set(id * 2, location);
+    }
+
+    osmium::thread::Pool pool{4, 0};
+    for (map_type* index : std::vector<map_type*>{&sparse_index, &dense_index}) {
+        index->sort(pool);
+        REQUIRE(index->get(1000) == (osmium::Location{500, 500}));
+        REQUIRE_THROWS_AS(index->get(1001), osmium::not_found);
+    }
+    REQUIRE(std::is_sorted(sparse_index.cbegin(), sparse_index.cend()));
+}
+
+TEST_CASE("Sort multimap in parallel through the multimap interface") {
+    using multimap_type = osmium::index::multimap::Multimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+
+    osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> index;
+    for (osmium::unsigned_object_id_type id = 200000; id > 0; --id) {
+        index.set(id, id + 1);
+        index.set(id, id);
+    }
+
+    osmium::thread::Pool pool{4, 0};
+    static_cast<multimap_type&>(index).sort(pool);
+
+    const auto range = index.get_all(1000);
+    REQUIRE(std::distance(range.first, range.second) == 2);
+    REQUIRE(range.first->second == 1000);
+}